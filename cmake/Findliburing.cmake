@@ -0,0 +1,25 @@
+if(TARGET liburing)
+    return()
+endif()
+
+find_path(liburing_INCLUDE_DIR NAMES liburing.h)
+find_library(liburing_LIBRARY_FILE NAMES uring)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(liburing DEFAULT_MSG
+        liburing_LIBRARY_FILE
+        liburing_INCLUDE_DIR
+        )
+
+if(liburing_INCLUDE_DIR AND liburing_LIBRARY_FILE)
+    set(liburing_FOUND ON)
+    add_library(liburing SHARED IMPORTED)
+    set_target_properties(liburing PROPERTIES
+        IMPORTED_LOCATION "${liburing_LIBRARY_FILE}"
+        INTERFACE_INCLUDE_DIRECTORIES "${liburing_INCLUDE_DIR}")
+else()
+    set(liburing_FOUND OFF)
+endif()
+
+unset(liburing_INCLUDE_DIR CACHE)
+unset(liburing_LIBRARY_FILE CACHE)
@@ -0,0 +1,25 @@
+if(TARGET zstd)
+    return()
+endif()
+
+find_path(zstd_INCLUDE_DIR NAMES zstd.h)
+find_library(zstd_LIBRARY_FILE NAMES zstd)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(zstd DEFAULT_MSG
+        zstd_LIBRARY_FILE
+        zstd_INCLUDE_DIR
+        )
+
+if(zstd_INCLUDE_DIR AND zstd_LIBRARY_FILE)
+    set(zstd_FOUND ON)
+    add_library(zstd SHARED IMPORTED)
+    set_target_properties(zstd PROPERTIES
+        IMPORTED_LOCATION "${zstd_LIBRARY_FILE}"
+        INTERFACE_INCLUDE_DIRECTORIES "${zstd_INCLUDE_DIR}")
+else()
+    set(zstd_FOUND OFF)
+endif()
+
+unset(zstd_INCLUDE_DIR CACHE)
+unset(zstd_LIBRARY_FILE CACHE)
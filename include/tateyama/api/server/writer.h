@@ -16,6 +16,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string_view>
 #include <tateyama/status.h>
 
 namespace tateyama::api::server {
@@ -66,6 +67,30 @@ public:
      */
     virtual status commit() = 0;
 
+    /**
+     * @brief write and commit multiple records at once
+     * @details write out each of the given records and mark its boundary as write() followed by commit() does,
+     * while the endpoint makes the records ready to be consumed together so that the consumer is notified at most
+     * once for them. This is intended for the call site that emits many small records.
+     * The default implementation calls write() and commit() for each record.
+     * @param records the pointer to the first element of the records
+     * @param count the number of the records
+     * @return status::ok when successful
+     * @return other status code when error occurs
+     */
+    virtual status write_records(std::string_view const* records, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++) {
+            auto const& record = records[i];  // NOLINT
+            if (auto rc = write(record.data(), record.length()); rc != status::ok) {
+                return rc;
+            }
+            if (auto rc = commit(); rc != status::ok) {
+                return rc;
+            }
+        }
+        return status::ok;
+    }
+
 };
 
 }
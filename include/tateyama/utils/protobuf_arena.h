@@ -0,0 +1,83 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+
+#include <google/protobuf/arena.h>
+
+namespace tateyama::utils {
+
+/**
+ * @brief the protobuf arena of the current thread, on which the messages parsed and built
+ *  while serving a request are allocated.
+ * @details the arena is reset when the outermost scope on the thread ends,
+ *  keeping its first block for the next request, so that the small requests do not allocate from the heap.
+ */
+class request_arena {
+public:
+    /**
+     * @brief the size of the first block of the arena, which is kept over the requests
+     */
+    static constexpr std::size_t initial_block_size = 16UL * 1024UL;
+
+    /**
+     * @brief the maximum size of the blocks allocated when the first block is exhausted
+     */
+    static constexpr std::size_t max_block_size = 1024UL * 1024UL;
+
+    /**
+     * @brief RAII object marking the time span of serving a request on the current thread.
+     *  The scopes can be nested, e.g. the scope of the routing service and that of the service it dispatches to.
+     */
+    class scope {
+    public:
+        scope();
+        ~scope();
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        scope(scope const&) = delete;
+        scope(scope&&) = delete;
+        scope& operator = (scope const&) = delete;
+        scope& operator = (scope&&) = delete;
+    };
+
+    /**
+     * @brief create a message on the arena of the current thread
+     * @attention the message is owned by the arena, thus it must not be deleted,
+     *  nor be used after the outermost scope on the thread ends
+     * @throws std::logic_error if no scope is active on the current thread
+     */
+    template <class T>
+    [[nodiscard]] static T* create() {
+        return google::protobuf::Arena::Create<T>(arena());
+    }
+
+    /**
+     * @brief returns the arena of the current thread
+     * @throws std::logic_error if no scope is active on the current thread
+     */
+    [[nodiscard]] static google::protobuf::Arena* arena();
+
+    /**
+     * @brief returns the bytes used in the arena of the current thread, for diagnostic
+     */
+    [[nodiscard]] static std::size_t space_used() noexcept;
+};
+
+}  // namespace tateyama::utils
@@ -21,6 +21,7 @@
 
 #include <tateyama/proto/datastore/request.pb.h>
 #include <tateyama/proto/datastore/response.pb.h>
+#include <tateyama/utils/protobuf_arena.h>
 #ifdef ENABLE_ALTIMETER
 #include "altimeter_logger.h"
 #endif
@@ -47,7 +48,8 @@ bool tateyama::datastore::service::core::operator()(const std::shared_ptr<reques
     constexpr static auto this_request_does_not_use_session_id = static_cast<std::size_t>(-2);
 
     auto data = req->payload();
-    ns::Request rq{};
+    tateyama::utils::request_arena::scope arena_scope{};
+    auto& rq = *tateyama::utils::request_arena::create<ns::Request>();
     if(!rq.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
         LOG(ERROR) << "request parse error";
         return false;
@@ -72,7 +74,7 @@ bool tateyama::datastore::service::core::operator()(const std::shared_ptr<reques
             service::backup(req, "all", backup_restore_success);
 #endif
 
-            tateyama::proto::datastore::response::BackupBegin rp{};
+            auto& rp = *tateyama::utils::request_arena::create<tateyama::proto::datastore::response::BackupBegin>();
             auto success = rp.mutable_success();
             success->set_id(backup_id_);
             auto simple_source = success->mutable_simple_source();
@@ -97,7 +99,7 @@ bool tateyama::datastore::service::core::operator()(const std::shared_ptr<reques
                     backup_restore_success);
 #endif
 
-            tateyama::proto::datastore::response::BackupBegin rp{};
+            auto& rp = *tateyama::utils::request_arena::create<tateyama::proto::datastore::response::BackupBegin>();
             auto success = rp.mutable_success();
             success->set_id(backup_id_);
             auto detail_source = success->mutable_detail_source();
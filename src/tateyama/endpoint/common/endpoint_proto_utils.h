@@ -16,6 +16,9 @@
 #pragma once
 
 #include <string_view>
+#include <cstdint>
+#include <cstring>
+#include <climits>
 #include <set>
 #include <map>
 #include <utility>
@@ -30,6 +33,9 @@
 #include <tateyama/api/server/blob_info.h>
 #include <tateyama/endpoint/common/pointer_comp.h>
 #include <tateyama/utils/protobuf_utils.h>
+#include <tateyama/utils/protobuf_arena.h>
+
+#include <google/protobuf/io/coded_stream.h>
 
 namespace tateyama::endpoint::common {
 
@@ -41,9 +47,93 @@ struct parse_result {
     std::size_t service_message_version_minor_{};
 };
 
+namespace details {
+
+/**
+ * @brief read a varint from the buffer, advancing the pointer given.
+ * @return false if the buffer ends before the varint does, or the varint is longer than 10 bytes
+ */
+inline bool read_varint(const char*& p, const char* end, std::uint64_t& value) noexcept {
+    value = 0;
+    for (std::uint32_t shift = 0; shift < 64 && p < end; shift += 7) {
+        auto byte = static_cast<std::uint8_t>(*p++);  // NOLINT
+        value |= static_cast<std::uint64_t>(byte & 0x7fU) << shift;
+        if ((byte & 0x80U) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+constexpr std::uint64_t varint_tag(int field_number) noexcept {
+    return static_cast<std::uint64_t>(field_number) << 3U;  // wire type is 0 (varint)
+}
+
+/**
+ * @brief decode the request header carrying no blobs, which is the common case, without protobuf.
+ * @return false if the input has to be decoded by protobuf,
+ *  such as the header carrying blobs, an unknown field, or the input which seems to be broken
+ */
+inline bool parse_header_fast(std::string_view input, parse_result& result) noexcept {
+    using header = ::tateyama::proto::framework::request::Header;
+
+    const char* p = input.data();
+    const char* end = p + input.size();  // NOLINT
+    std::uint64_t header_length{};
+    if (!read_varint(p, end, header_length) || header_length > static_cast<std::uint64_t>(end - p)) {
+        return false;
+    }
+    const char* header_end = p + header_length;  // NOLINT
+    while (p < header_end) {
+        std::uint64_t tag{};
+        std::uint64_t value{};
+        if (!read_varint(p, header_end, tag)) {
+            return false;
+        }
+        switch (tag) {
+        case varint_tag(header::kServiceMessageVersionMajorFieldNumber):
+            if (!read_varint(p, header_end, value)) { return false; }
+            result.service_message_version_major_ = value;
+            break;
+        case varint_tag(header::kServiceMessageVersionMinorFieldNumber):
+            if (!read_varint(p, header_end, value)) { return false; }
+            result.service_message_version_minor_ = value;
+            break;
+        case varint_tag(header::kServiceIdFieldNumber):
+            if (!read_varint(p, header_end, value)) { return false; }
+            result.service_id_ = value;
+            break;
+        case varint_tag(header::kSessionIdFieldNumber):
+            if (!read_varint(p, header_end, value)) { return false; }
+            result.session_id_ = value;
+            break;
+        default:  // blobs, or a field this decoder does not know
+            return false;
+        }
+    }
+    std::uint64_t body_length{};
+    if (!read_varint(p, end, body_length) || body_length == 0 || body_length > static_cast<std::uint64_t>(end - p)) {
+        return false;
+    }
+    result.payload_ = std::string_view(p, body_length);
+    return true;
+}
+
+}  // namespace details
+
+/**
+ * @brief parse the framework header and locate the payload of the request.
+ *  The header without blobs is decoded directly from the input, and the other is decoded by protobuf.
+ * @param blobs_map the map to which the blobs in the header are added, which is left untouched if the header carries no blobs
+ */
 inline bool parse_header(std::string_view input, parse_result& result, std::map<std::string, std::pair<std::variant<std::string, proto::framework::common::BlobRelayReference>, bool>>& blobs_map) {
     result = {};
-    ::tateyama::proto::framework::request::Header hdr{};
+    if (details::parse_header_fast(input, result)) {
+        return true;
+    }
+    result = {};
+    utils::request_arena::scope arena_scope{};
+    auto& hdr = *utils::request_arena::create<::tateyama::proto::framework::request::Header>();
     google::protobuf::io::ArrayInputStream in{input.data(), static_cast<int>(input.size())};
     if(auto res = utils::ParseDelimitedFromZeroCopyStream(std::addressof(hdr), std::addressof(in), nullptr); ! res) {
         return false;
@@ -75,8 +165,7 @@ struct header_content {
     std::set<std::unique_ptr<tateyama::api::server::blob_info>, pointer_comp<tateyama::api::server::blob_info>>* blobs_{};
 };
 
-inline bool append_response_header(std::stringstream& ss, std::string_view body, header_content input, ::tateyama::proto::framework::response::Header::PayloadType type = ::tateyama::proto::framework::response::Header::UNKNOWN) {
-    ::tateyama::proto::framework::response::Header hdr{};
+inline void fill_response_header(::tateyama::proto::framework::response::Header& hdr, header_content input, ::tateyama::proto::framework::response::Header::PayloadType type) {
     hdr.set_session_id(input.session_id_);
     hdr.set_payload_type(type);
     if(input.blobs_ && type == ::tateyama::proto::framework::response::Header::SERVICE_RESULT) {
@@ -91,6 +180,12 @@ inline bool append_response_header(std::stringstream& ss, std::string_view body,
             }
         }
     }
+}
+
+inline bool append_response_header(std::stringstream& ss, std::string_view body, header_content input, ::tateyama::proto::framework::response::Header::PayloadType type = ::tateyama::proto::framework::response::Header::UNKNOWN) {
+    utils::request_arena::scope arena_scope{};
+    auto& hdr = *utils::request_arena::create<::tateyama::proto::framework::response::Header>();
+    fill_response_header(hdr, input, type);
     if(auto res = utils::SerializeDelimitedToOstream(hdr, std::addressof(ss)); ! res) {
         return false;
     }
@@ -100,4 +195,48 @@ inline bool append_response_header(std::stringstream& ss, std::string_view body,
     return true;
 }
 
+/**
+ * @brief the response message in the same format as append_response_header() produces,
+ *  which is serialized directly into the buffer given.
+ */
+class response_message {
+public:
+    response_message(std::string_view body, header_content input, ::tateyama::proto::framework::response::Header::PayloadType type) : body_(body) {
+        fill_response_header(hdr_, input, type);
+        auto header_size = hdr_.ByteSizeLong();  // caches the size used in serialize_to()
+        if (header_size > INT_MAX || body_.size() > INT_MAX) {
+            return;
+        }
+        size_ = google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<std::uint32_t>(header_size)) + header_size +
+            google::protobuf::io::CodedOutputStream::VarintSize32(static_cast<std::uint32_t>(body_.size())) + body_.size();
+        valid_ = true;
+    }
+
+    /**
+     * @brief returns whether the response message can be serialized.
+     */
+    [[nodiscard]] bool valid() const noexcept { return valid_; }
+    /**
+     * @brief returns the length of the serialized response message.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    /**
+     * @brief serialize the response message.
+     * @param out the buffer whose size is at least size()
+     */
+    void serialize_to(char* out) const {
+        auto* p = reinterpret_cast<google::protobuf::uint8*>(out);  // NOLINT
+        p = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<std::uint32_t>(hdr_.GetCachedSize()), p);
+        p = hdr_.SerializeWithCachedSizesToArray(p);
+        p = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray(static_cast<std::uint32_t>(body_.size()), p);
+        std::memcpy(p, body_.data(), body_.size());
+    }
+
+private:
+    ::tateyama::proto::framework::response::Header hdr_{};
+    std::string_view body_;
+    std::size_t size_{};
+    bool valid_{};
+};
+
 }  // tateyama::endpoint::ipc
@@ -17,6 +17,7 @@
 
 #include <future>
 #include <thread>
+#include <atomic>
 #include <memory>
 #include <functional>
 #include <map>
@@ -90,9 +91,20 @@ public:
     }
 
     [[nodiscard]] bool is_terminated() const {
+        if (detached_.load()) {
+            return false;
+        }
         return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
     }
 
+    /**
+     * @brief mark that the session continues on another thread after the invoked thread returns.
+     * @param detached true while the session is served by the thread other than the invoked one
+     */
+    void set_detached(bool detached) {
+        detached_.store(detached);
+    }
+
     [[nodiscard]] bool is_quiet() {
         if (!is_all_request_completed()) {
             return false;
@@ -111,6 +123,11 @@ public:
         session_context_->set_worker(me);
     }
 
+    /**
+     * @brief let the thread serving this session check the shutdown request now, instead of at its next periodic check.
+     */
+    virtual void wake_up() {}
+
     /**
      * @brief dispose the session_elements in the session_store.
      */
@@ -181,11 +198,14 @@ protected:
     std::string connection_info_{};         // NOLINT
     // for stream endpoint only
     std::size_t max_result_sets_{};         // NOLINT
+    tateyama::proto::endpoint::request::ResultSetCompression result_set_compression_{tateyama::proto::endpoint::request::ResultSetCompression::NO_COMPRESSION};  // NOLINT
+    std::uint32_t result_set_window_{};     // NOLINT
 
     // for future
     std::packaged_task<void()> task_;       // NOLINT
     std::future<void> future_;              // NOLINT
     std::thread thread_{};                  // NOLINT
+    std::atomic_bool detached_{};           // NOLINT
 
     // for session management
     const std::shared_ptr<tateyama::session::resource::bridge> session_;  // NOLINT
@@ -337,6 +357,16 @@ protected:
                 return false;
             }
             max_result_sets_ = wi.stream_information().maximum_concurrent_result_sets();  // for Stream
+            for (auto&& e : wi.stream_information().result_set_compressions()) {  // in the order the client prefers
+                if (auto compression = static_cast<tateyama::proto::endpoint::request::ResultSetCompression>(e);
+                    compression != tateyama::proto::endpoint::request::ResultSetCompression::NO_COMPRESSION && compression == config_.result_set_compression_) {
+                    result_set_compression_ = compression;
+                    break;
+                }
+            }
+            if (config_.result_set_flow_control_) {
+                result_set_window_ = wi.stream_information().result_set_window();
+            }
             break;
         default:  // shouldn't happen
             std::stringstream ss;
@@ -353,6 +383,8 @@ protected:
         if (auto name_opt = session_info.username(); name_opt) {
             rs->set_user_name(std::string(name_opt.value()));
         }
+        rs->set_result_set_compression(result_set_compression_);
+        rs->set_result_set_window(result_set_window_);
 
         // take care of blob handling mechanism
         constexpr static std::uint64_t ENDPOINT_BROKER_SMVMAJ_BLOB_RELAY_SUPPORT = 0;
@@ -818,6 +850,32 @@ protected:
         }
         return time_over;
     }
+    /**
+     * @brief returns the earliest time when is_expiration_time_over() turns true
+     * @return the expiration time, or empty if neither the session nor the authentication expires
+     */
+    [[nodiscard]] std::optional<tateyama::session::session_context::expiration_time_type> next_expiration_time() const {
+        auto rv = session_context_->expiration_time();
+        if (auth_) {
+            if (auto ne = authentication_timer_.next_expiration(); ne > 0) {
+                tateyama::session::session_context::expiration_time_type auth_time{std::chrono::milliseconds(ne)};
+                if (!rv || auth_time < rv.value()) {
+                    rv = auth_time;
+                }
+            }
+        }
+        return rv;
+    }
+    /**
+     * @brief returns whether the shutdown of the session has been requested, without taking any lock
+     */
+    [[nodiscard]] bool shutdown_requested() const noexcept {
+        return session_context_->shutdown_request() != tateyama::session::shutdown_request_type::nothing;
+    }
+    [[nodiscard]] bool has_reqreses() {
+        std::lock_guard<std::mutex> lock(mtx_reqreses_);
+        return !reqreses_.empty();
+    }
     inline tateyama::endpoint::common::resources& resources() {
         return resources_;
     }
@@ -27,6 +27,7 @@
 #include <tateyama/api/server/session_store.h>
 #include <tateyama/session/variable_set.h>
 #include <tateyama/authentication/resource/bridge.h>
+#include <tateyama/proto/endpoint/request.pb.h>
 
 #include "session_info_impl.h"
 
@@ -101,9 +102,21 @@ public:
     void allow_blob_privileged(bool allow) {
         allow_blob_privileged_ = allow;
     }
+    void result_set_compression(tateyama::proto::endpoint::request::ResultSetCompression compression) {
+        result_set_compression_ = compression;
+    }
+    void result_set_flow_control(bool enable) {
+        result_set_flow_control_ = enable;
+    }
     [[nodiscard]] tateyama::api::server::database_info const& database_info() const noexcept {
         return database_info_;
     }
+    [[nodiscard]] authentication::resource::bridge* get_authentication() const noexcept {
+        return auth_.get();
+    }
+    [[nodiscard]] const administrators& get_administrators() const noexcept {
+        return administrators_;
+    }
 
     // for initialization
     static api::server::database_info const& database_info(tateyama::framework::environment& env) {
@@ -139,6 +152,8 @@ private:
     std::size_t refresh_timeout_{};
     std::size_t max_refresh_timeout_{};
     std::size_t authentication_timeout_{};
+    tateyama::proto::endpoint::request::ResultSetCompression result_set_compression_{tateyama::proto::endpoint::request::ResultSetCompression::NO_COMPRESSION};
+    bool result_set_flow_control_{true};
 
     // for blob_relay
     bool blob_relay_enabled_{};
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <csignal>
+#include <cerrno>
+
+#include <glog/logging.h>
+
+#include <tateyama/logging.h>
+#include <tateyama/api/server/request.h>
+#include <tateyama/framework/routing_service.h>
+#include <tateyama/framework/component_ids.h>
+#include <tateyama/proto/endpoint/request.pb.h>
+#include <tateyama/proto/diagnostics.pb.h>
+
+#include "tateyama/endpoint/common/logging.h"
+#include "tateyama/endpoint/common/worker_configuration.h"
+#include "tateyama/endpoint/common/session_info_impl.h"
+#include "tateyama/endpoint/loopback/loopback_response.h"
+#include "tateyama/endpoint/ipc/wire.h"
+
+namespace tateyama::endpoint::ipc::bootstrap {
+
+/**
+ * @brief request object for the requests through the admin channel, which does not belong to any session.
+ *  The session id is 0, which is never given to a session.
+ */
+class admin_channel_request : public tateyama::api::server::request {
+public:
+    class admin_session_info : public tateyama::endpoint::common::session_info_impl {
+    public:
+        using session_info_impl::session_info_impl;
+        using session_info_impl::user_name;
+    };
+
+    admin_channel_request(const tateyama::endpoint::common::configuration& conf, std::uint64_t client_id, std::size_t service_id, std::string payload)
+        : service_id_(service_id),
+          payload_(std::move(payload)),
+          database_info_(conf.database_info()),
+          session_info_(0, "ipc", "admin_channel:" + std::to_string(client_id), conf.get_administrators()) {
+    }
+
+    [[nodiscard]] std::size_t session_id() const override {
+        return 0;
+    }
+    [[nodiscard]] std::size_t service_id() const override {
+        return service_id_;
+    }
+    [[nodiscard]] std::size_t local_id() const override {
+        return 0;
+    }
+    [[nodiscard]] std::string_view payload() const override {
+        return payload_;
+    }
+    [[nodiscard]] tateyama::api::server::database_info const& database_info() const noexcept override {
+        return database_info_;
+    }
+    [[nodiscard]] tateyama::api::server::session_info const& session_info() const noexcept override {
+        return session_info_;
+    }
+    [[nodiscard]] tateyama::api::server::session_store& session_store() noexcept override {
+        return session_store_;
+    }
+    [[nodiscard]] tateyama::session::session_variable_set& session_variable_set() noexcept override {
+        return session_variable_set_;
+    }
+    [[nodiscard]] bool has_blob(std::string_view) const noexcept override {
+        return false;
+    }
+    [[nodiscard]] tateyama::api::server::blob_info const& get_blob(std::string_view) const override {
+        throw std::runtime_error("blob is not supported with the admin channel");
+    }
+
+    void user_name(const std::string& name) {
+        session_info_.user_name(name);
+    }
+
+private:
+    const std::size_t service_id_;
+    const std::string payload_;
+    tateyama::api::server::database_info const& database_info_;
+    admin_session_info session_info_;
+    tateyama::api::server::session_store session_store_{};
+    tateyama::session::session_variable_set session_variable_set_{};
+};
+
+/**
+ * @brief threads serving the admin channel, which carries the short-lived requests of the management commands
+ *  and the monitoring agents without creating a session for each of them.
+ *  Only the session, metrics and request services are available through the admin channel.
+ */
+class admin_channel_server {
+public:
+    /**
+     * @brief the default buffer size of each admin channel entry in KB
+     */
+    static constexpr std::size_t default_buffer_size = 64;
+
+    /**
+     * @brief construct the server
+     * @param connection_queue the connection queue, whose admin slots are taken while the requests are served
+     * @param threads the number of threads serving the admin channel
+     */
+    admin_channel_server(tateyama::common::wire::admin_channel& channel,
+                         tateyama::common::wire::connection_queue& connection_queue,
+                         std::shared_ptr<tateyama::framework::routing_service> router,
+                         const tateyama::endpoint::common::configuration& conf,
+                         std::size_t threads)
+        : channel_(channel), connection_queue_(connection_queue), router_(std::move(router)), conf_(conf), threads_size_(threads) {
+    }
+    ~admin_channel_server() {
+        stop();
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    admin_channel_server(admin_channel_server const&) = delete;
+    admin_channel_server(admin_channel_server&&) = delete;
+    admin_channel_server& operator = (admin_channel_server const&) = delete;
+    admin_channel_server& operator = (admin_channel_server&&) = delete;
+
+    void start() {
+        for (std::size_t i = 0; i < threads_size_; i++) {
+            threads_.emplace_back([this, i]{ operator()(i == 0); });
+        }
+    }
+
+    /**
+     * @brief stop the threads, and reject the requests remaining in the admin channel
+     */
+    void stop() {
+        if (stop_.exchange(true)) {
+            return;
+        }
+        channel_.interrupt();
+        for (auto&& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+        while (true) {
+            auto idx = channel_.take(0);
+            if (idx == tateyama::common::wire::admin_channel::no_entry) {
+                break;
+            }
+            reply_error(idx, tateyama::proto::diagnostics::Code::OPERATION_CANCELED, "the server is shutting down");
+        }
+    }
+
+    // for diagnostic
+    [[nodiscard]] std::size_t served() const noexcept { return served_.load(); }
+    [[nodiscard]] std::size_t reclaimed() const noexcept { return reclaimed_.load(); }
+    [[nodiscard]] std::size_t entries_in_use() const noexcept { return channel_.entries_in_use(); }
+
+private:
+    static constexpr std::int64_t watch_interval = 5L * 1000L * 1000L;  // in microseconds
+
+    tateyama::common::wire::admin_channel& channel_;
+    tateyama::common::wire::connection_queue& connection_queue_;
+    const std::shared_ptr<tateyama::framework::routing_service> router_;
+    const tateyama::endpoint::common::configuration& conf_;
+    const std::size_t threads_size_;
+    std::vector<std::thread> threads_{};
+    std::atomic_bool stop_{};
+
+    std::atomic_size_t served_{};
+    std::atomic_size_t reclaimed_{};
+
+    void operator()(bool sweeper) {
+        pthread_setname_np(pthread_self(), "ipc_admin");
+        while (!stop_.load()) {
+            auto idx = channel_.take(watch_interval);
+            if (idx == tateyama::common::wire::admin_channel::no_entry) {
+                if (sweeper && !stop_.load()) {
+                    reclaimed_.fetch_add(channel_.reclaim([](std::uint64_t pid){ return kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH; }));
+                }
+                continue;
+            }
+            serve_in_budget(idx);
+        }
+    }
+
+    /**
+     * @brief serve the request holding an admin slot, thus the requests being served and the admin sessions
+     *  do not exceed admin_sessions in total. The request is rejected like an admin session if no admin slot is free.
+     */
+    void serve_in_budget(std::size_t idx) {
+        std::size_t sid{};
+        try {
+            sid = connection_queue_.acquire_admin_slot();
+        } catch (std::runtime_error&) {
+            reply_error(idx, tateyama::proto::diagnostics::Code::RESOURCE_LIMIT_REACHED, "all the admin sessions are in use");
+            return;
+        }
+        serve(idx);
+        connection_queue_.release_admin_slot(sid);
+    }
+
+    static bool is_admin_service(std::size_t service_id) noexcept {
+        return service_id == tateyama::framework::service_id_session ||
+            service_id == tateyama::framework::service_id_metrics ||
+            service_id == tateyama::framework::service_id_request;
+    }
+
+    void serve(std::size_t idx) {
+        try {
+            // the request is copied before anything is parsed, as the client can rewrite the entry at any time
+            tateyama::common::wire::admin_channel::request_image image{};
+            if (!channel_.copy_request(idx, image)) {
+                LOG_LP(ERROR) << "malformed request in the admin channel";
+                reply_error(idx, tateyama::proto::diagnostics::Code::INVALID_REQUEST, "the request exceeds the admin channel entry");
+                return;
+            }
+            if (!is_admin_service(image.service_id_)) {
+                reply_error(idx, tateyama::proto::diagnostics::Code::UNSUPPORTED_OPERATION,
+                            "service (" + std::to_string(image.service_id_) + ") is not available through the admin channel");
+                return;
+            }
+            auto request = std::make_shared<admin_channel_request>(conf_, image.client_id_, image.service_id_, std::move(image.payload_));
+            if (auto* auth = conf_.get_authentication(); auth) {
+                tateyama::proto::endpoint::request::Credential credential{};
+                if (!credential.ParseFromArray(image.credential_.data(), static_cast<int>(image.credential_.length()))) {
+                    reply_error(idx, tateyama::proto::diagnostics::Code::AUTHENTICATION_ERROR, "no valid credential");
+                    return;
+                }
+                std::optional<std::string> username_opt{};
+                try {
+                    switch (credential.credential_opt_case()) {
+                    case tateyama::proto::endpoint::request::Credential::CredentialOptCase::kEncryptedCredential:
+                        username_opt = auth->verify_encrypted(credential.encrypted_credential());
+                        break;
+                    case tateyama::proto::endpoint::request::Credential::CredentialOptCase::kRememberMeCredential:
+                        username_opt = auth->verify_token(credential.remember_me_credential());
+                        break;
+                    default:
+                        break;
+                    }
+                } catch (std::runtime_error &ex) {
+                    reply_error(idx, tateyama::proto::diagnostics::Code::AUTHENTICATION_ERROR, ex.what());
+                    return;
+                }
+                if (!username_opt) {
+                    reply_error(idx, tateyama::proto::diagnostics::Code::AUTHENTICATION_ERROR, "no valid credential");
+                    return;
+                }
+                request->user_name(username_opt.value());
+            }
+
+            auto response = std::make_shared<tateyama::endpoint::loopback::loopback_response>();
+            if (!(*router_)(request, response)) {
+                reply(idx, response->error().SerializeAsString(), true);
+                return;
+            }
+            if (!channel_.respond(idx, response->body(), false)) {
+                reply_error(idx, tateyama::proto::diagnostics::Code::RESOURCE_LIMIT_REACHED,
+                            "the response is too large for the admin channel, use a session instead");
+            }
+            served_.fetch_add(1);
+        } catch (std::exception &ex) {
+            LOG_LP(ERROR) << "error in the admin channel: " << ex.what();
+            reply_error(idx, tateyama::proto::diagnostics::Code::SYSTEM_ERROR, ex.what());
+        }
+    }
+
+    void reply(std::size_t idx, std::string_view body, bool error) {
+        if (!channel_.respond(idx, body, error)) {
+            reply_error(idx, tateyama::proto::diagnostics::Code::RESOURCE_LIMIT_REACHED, "the response is too large for the admin channel");
+        }
+    }
+    void reply_error(std::size_t idx, tateyama::proto::diagnostics::Code code, std::string_view message) {
+        tateyama::proto::diagnostics::Record record{};
+        record.set_code(code);
+        record.set_message(std::string(message));
+        if (!channel_.respond(idx, record.SerializeAsString(), true)) {
+            channel_.respond(idx, {}, true);
+        }
+    }
+};
+
+}
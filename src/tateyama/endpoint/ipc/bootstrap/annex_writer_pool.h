@@ -0,0 +1,444 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <glog/logging.h>
+#include <tateyama/logging.h>
+#include <tateyama/logging_helper.h>
+
+namespace tateyama::endpoint::ipc::bootstrap {
+
+/**
+ * @brief a bounded pool of threads transferring the records buffered in the annexes of the result set writers
+ *  to the result set wires, instead of a thread per writer in annex mode.
+ *  A task never blocks, it reports stalled when the wire is full and is retried with backoff until the client makes room.
+ *  The pool also bounds the heap memory used by the annexes, the annexes beyond the limit spill to temporary files.
+ */
+class annex_writer_pool {
+public:
+    /**
+     * @brief the default number of threads
+     */
+    static constexpr std::size_t default_threads = 4;
+
+    /**
+     * @brief the minimum and maximum interval to retry a stalled task, in microseconds.
+     */
+    static constexpr std::int64_t min_retry_interval = 100;
+    static constexpr std::int64_t max_retry_interval = 10 * 1000;
+
+    /**
+     * @brief the transfer for a writer in annex mode.
+     */
+    class task {
+    public:
+        enum class state {
+            /**
+             * @brief waiting for the records written by the writer
+             */
+            idle,
+            /**
+             * @brief waiting for the client to make room in the wire
+             */
+            stalled,
+            /**
+             * @brief no more transfer is needed
+             */
+            finished,
+        };
+
+        explicit task(std::function<state(void)> body) : body_(std::move(body)) {
+        }
+
+        /**
+         * @brief detach the body from the task, waiting for the body to finish if it is running.
+         *  used when the writer is destructed
+         */
+        void detach() {
+            std::lock_guard<std::mutex> lock(mtx_);
+            body_ = nullptr;
+        }
+
+    private:
+        std::mutex mtx_{};
+        std::function<state(void)> body_;
+        std::atomic_bool queued_{};
+        std::chrono::steady_clock::time_point stalled_since_{};
+        std::int64_t retry_interval_{};
+
+        // the bookkeeping of the stall is also done under mtx_, as the task can be run by another thread after it is scheduled again
+        state run(annex_writer_pool& pool, std::int64_t& retry_interval) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            auto rv = body_ ? body_() : state::finished;
+            auto now = std::chrono::steady_clock::now();
+            if (rv == state::stalled) {
+                if (retry_interval_ == 0) {
+                    stalled_since_ = now;
+                    retry_interval_ = min_retry_interval;
+                    pool.stalled_tasks_.fetch_add(1);
+                } else {
+                    retry_interval_ = std::min(retry_interval_ * 2, max_retry_interval);
+                }
+                retry_interval = retry_interval_;
+            } else if (retry_interval_ != 0) {
+                pool.stall_time_.fetch_add(static_cast<std::size_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - stalled_since_).count()));
+                retry_interval_ = 0;
+                pool.stalled_tasks_.fetch_sub(1);
+            }
+            return rv;
+        }
+
+        friend class annex_writer_pool;
+    };
+
+    /**
+     * @brief the usage of the annex memory by a session.
+     */
+    class session {
+    public:
+        explicit session(std::shared_ptr<annex_writer_pool> pool) noexcept : pool_(std::move(pool)) {
+        }
+        ~session() = default;
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        session(session const&) = delete;
+        session(session&&) = delete;
+        session& operator = (session const&) = delete;
+        session& operator = (session&&) = delete;
+
+        [[nodiscard]] annex_writer_pool& pool() const noexcept { return *pool_; }
+        [[nodiscard]] std::size_t heap_bytes() const noexcept { return heap_bytes_.load(); }
+
+    private:
+        std::shared_ptr<annex_writer_pool> pool_;
+        std::atomic_size_t heap_bytes_{};
+
+        friend class annex_writer_pool;
+    };
+
+    /**
+     * @brief the storage of an annex, which is placed in the heap within the limits, or in a temporary file otherwise.
+     */
+    class buffer {
+    public:
+        buffer(std::shared_ptr<session> s, std::size_t size) : session_(std::move(s)), capacity_(size) {
+            auto& pool = session_->pool();
+            if (pool.reserve_heap(*session_, capacity_)) {
+                heap_ = std::make_unique<char[]>(capacity_);  // NOLINT
+                data_ = heap_.get();
+                return;
+            }
+            data_ = pool.spill(capacity_);
+            if (data_ != nullptr) {
+                spilled_ = true;
+                return;
+            }
+            // never fail the query, exceeding the limit instead
+            pool.force_reserve_heap(*session_, capacity_);
+            heap_ = std::make_unique<char[]>(capacity_);  // NOLINT
+            data_ = heap_.get();
+        }
+        ~buffer() {
+            if (spilled_) {
+                session_->pool().unspill(data_, capacity_);
+            } else {
+                session_->pool().release_heap(*session_, capacity_);
+            }
+        }
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        buffer(buffer const&) = delete;
+        buffer(buffer&&) = delete;
+        buffer& operator = (buffer const&) = delete;
+        buffer& operator = (buffer&&) = delete;
+
+        [[nodiscard]] char* data() const noexcept { return data_; }
+        [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+        [[nodiscard]] bool spilled() const noexcept { return spilled_; }
+
+    private:
+        std::shared_ptr<session> session_;
+        std::size_t capacity_;
+        std::unique_ptr<char[]> heap_{};  // NOLINT
+        char* data_{};
+        bool spilled_{};
+    };
+
+    explicit annex_writer_pool(std::size_t threads = default_threads) : threads_size_(threads > 0 ? threads : 1) {
+    }
+    ~annex_writer_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+            cnd_.notify_all();
+        }
+        for (auto&& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    annex_writer_pool(annex_writer_pool const&) = delete;
+    annex_writer_pool(annex_writer_pool&&) = delete;
+    annex_writer_pool& operator = (annex_writer_pool const&) = delete;
+    annex_writer_pool& operator = (annex_writer_pool&&) = delete;
+
+    /**
+     * @brief returns the pool used by the sessions not given a pool, such as in tests
+     */
+    static std::shared_ptr<annex_writer_pool> default_pool() {
+        static std::shared_ptr<annex_writer_pool> pool = std::make_shared<annex_writer_pool>();
+        return pool;
+    }
+
+    /**
+     * @brief let the task run, such as when the writer has written records or released
+     * @param t the task
+     */
+    void schedule(const std::shared_ptr<task>& t) {
+        if (t->queued_.exchange(true)) {
+            return;
+        }
+        std::call_once(start_, [this]{
+            for (std::size_t i = 0; i < threads_size_; i++) {
+                threads_.emplace_back([this]{ operator()(); });
+            }
+        });
+        std::lock_guard<std::mutex> lock(mtx_);
+        ready_.emplace_back(t);
+        cnd_.notify_one();
+    }
+
+    /**
+     * @brief set the limits of the heap memory used by the annexes, supposed to be called before the pool is used
+     * @param limit the maximum bytes of the heap memory used by the annexes of all the sessions, 0 means unlimited
+     * @param session_limit the maximum bytes of the heap memory used by the annexes of a session, 0 means unlimited
+     * @param spill_directory the directory where the temporary files are created, empty means the system temporary directory
+     */
+    void set_memory_limit(std::size_t limit, std::size_t session_limit, std::string spill_directory) {
+        heap_limit_ = limit;
+        session_heap_limit_ = session_limit;
+        spill_directory_ = std::move(spill_directory);
+    }
+
+    /**
+     * @brief account the bytes buffered in the annexes
+     */
+    void add_buffered(std::size_t n) noexcept { buffered_bytes_.fetch_add(n); }
+    void sub_buffered(std::size_t n) noexcept { buffered_bytes_.fetch_sub(n); }
+
+    /**
+     * @brief returns the bytes buffered in the annexes and not transferred yet
+     */
+    [[nodiscard]] std::size_t buffered_bytes() const noexcept { return buffered_bytes_.load(); }
+    /**
+     * @brief returns the total time the writers have been stalled by the clients, in microseconds
+     */
+    [[nodiscard]] std::size_t stall_time() const noexcept { return stall_time_.load(); }
+    /**
+     * @brief returns the number of tasks stalled now
+     */
+    [[nodiscard]] std::size_t stalled_tasks() const noexcept { return stalled_tasks_.load(); }
+    /**
+     * @brief returns the bytes of the heap memory used by the annexes
+     */
+    [[nodiscard]] std::size_t heap_bytes() const noexcept { return heap_bytes_.load(); }
+    /**
+     * @brief returns the bytes of the annexes spilled to the temporary files
+     */
+    [[nodiscard]] std::size_t spilled_bytes() const noexcept { return spilled_bytes_.load(); }
+
+private:
+    class stalled_entry {
+    public:
+        stalled_entry(std::shared_ptr<task> t, std::chrono::steady_clock::time_point retry_at) : task_(std::move(t)), retry_at_(retry_at) {
+        }
+        std::shared_ptr<task> task_;
+        std::chrono::steady_clock::time_point retry_at_;
+    };
+
+    const std::size_t threads_size_;
+    std::vector<std::thread> threads_{};
+    std::once_flag start_{};
+    std::mutex mtx_{};
+    std::condition_variable cnd_{};
+    std::deque<std::shared_ptr<task>> ready_{};
+    std::deque<stalled_entry> stalled_{};
+    bool stop_{};
+
+    std::atomic_size_t buffered_bytes_{};
+    std::atomic_size_t stall_time_{};
+    std::atomic_size_t stalled_tasks_{};
+
+    std::size_t heap_limit_{};
+    std::size_t session_heap_limit_{};
+    std::string spill_directory_{};
+    std::atomic_size_t heap_bytes_{};
+    std::atomic_size_t spilled_bytes_{};
+    std::atomic_bool spill_warned_{};
+
+    bool reserve_heap(session& s, std::size_t n) noexcept {
+        if (session_heap_limit_ > 0) {
+            auto held = s.heap_bytes_.load();
+            do {
+                if (held + n > session_heap_limit_) {
+                    return false;
+                }
+            } while (!s.heap_bytes_.compare_exchange_weak(held, held + n));
+        } else {
+            s.heap_bytes_.fetch_add(n);
+        }
+        if (heap_limit_ > 0) {
+            auto total = heap_bytes_.load();
+            do {
+                if (total + n > heap_limit_) {
+                    s.heap_bytes_.fetch_sub(n);
+                    return false;
+                }
+            } while (!heap_bytes_.compare_exchange_weak(total, total + n));
+        } else {
+            heap_bytes_.fetch_add(n);
+        }
+        return true;
+    }
+    void force_reserve_heap(session& s, std::size_t n) noexcept {
+        s.heap_bytes_.fetch_add(n);
+        heap_bytes_.fetch_add(n);
+    }
+    void release_heap(session& s, std::size_t n) noexcept {
+        s.heap_bytes_.fetch_sub(n);
+        heap_bytes_.fetch_sub(n);
+    }
+
+    // the temporary file is unlinked at once, so that it is removed even if the server crashes
+    char* spill(std::size_t n) noexcept {
+        std::string directory = spill_directory_;
+        if (directory.empty()) {
+            std::error_code ec{};
+            directory = std::filesystem::temp_directory_path(ec).string();
+            if (ec) {
+                directory = "/tmp";
+            }
+        }
+        std::string path = directory + "/tsurugi_annex_XXXXXX";
+        int fd = ::mkstemp(path.data());
+        if (fd < 0) {
+            warn_spill_failure(path);
+            return nullptr;
+        }
+        ::unlink(path.c_str());
+        if (::ftruncate(fd, static_cast<off_t>(n)) != 0) {
+            ::close(fd);
+            warn_spill_failure(path);
+            return nullptr;
+        }
+        void* addr = ::mmap(nullptr, n, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {  // NOLINT
+            warn_spill_failure(path);
+            return nullptr;
+        }
+        spilled_bytes_.fetch_add(n);
+        return static_cast<char*>(addr);
+    }
+    void unspill(char* addr, std::size_t n) noexcept {
+        ::munmap(addr, n);
+        spilled_bytes_.fetch_sub(n);
+    }
+    void warn_spill_failure(const std::string& path) noexcept {
+        if (!spill_warned_.exchange(true)) {
+            LOG_LP(WARNING) << "cannot spill the result set records to " << path << ", uses the heap memory beyond the limit";
+        }
+    }
+
+    void operator()() {
+        pthread_setname_np(pthread_self(), "ipc_annex");
+        while (true) {
+            std::shared_ptr<task> t{};
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                while (!stop_ && ready_.empty()) {
+                    auto now = std::chrono::steady_clock::now();
+                    if (!stalled_.empty() && stalled_.front().retry_at_ <= now) {
+                        break;
+                    }
+                    if (stalled_.empty()) {
+                        cnd_.wait(lock);
+                    } else {
+                        cnd_.wait_until(lock, stalled_.front().retry_at_);
+                    }
+                }
+                if (stop_) {
+                    return;
+                }
+                if (!ready_.empty()) {
+                    t = std::move(ready_.front());
+                    ready_.pop_front();
+                } else {
+                    t = std::move(stalled_.front().task_);
+                    stalled_.pop_front();
+                }
+            }
+            t->queued_.store(false);
+            run(t);
+        }
+    }
+
+    void run(const std::shared_ptr<task>& t) {
+        std::int64_t retry_interval{};
+        if (t->run(*this, retry_interval) != task::state::stalled) {
+            return;
+        }
+        if (t->queued_.exchange(true)) {
+            return;  // already scheduled by the writer
+        }
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto retry_at = std::chrono::steady_clock::now() + std::chrono::microseconds(retry_interval);
+        auto it = stalled_.begin();
+        while (it != stalled_.end() && it->retry_at_ <= retry_at) {
+            it++;
+        }
+        stalled_.emplace(it, t, retry_at);
+        cnd_.notify_one();
+    }
+};
+
+}
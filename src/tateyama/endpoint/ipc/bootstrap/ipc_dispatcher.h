@@ -0,0 +1,214 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <glog/logging.h>
+#include <tateyama/logging.h>
+
+#include "tateyama/endpoint/common/logging.h"
+#include "ipc_worker.h"
+
+namespace tateyama::endpoint::ipc::bootstrap {
+
+/**
+ * @brief a fixed number of io threads serving the sessions handed over from the ipc_worker threads,
+ *  the io threads are woken up by the doorbell in the connection_queue rung by the clients.
+ */
+class ipc_dispatcher {
+public:
+    /**
+     * @brief the interval of the housekeeping of the sessions served, in microseconds,
+     *  only the sessions whose idle() is due are served by the housekeeping, as a shutdown request notifies the session.
+     */
+    static constexpr std::int64_t sweep_interval = 500 * 1000;
+
+    ipc_dispatcher(tateyama::common::wire::connection_queue::doorbell& doorbell, std::size_t threads, std::size_t slots)
+        : doorbell_(doorbell), threads_size_(threads), entries_(slots) {
+    }
+    ~ipc_dispatcher() {
+        stop();
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    ipc_dispatcher(ipc_dispatcher const&) = delete;
+    ipc_dispatcher(ipc_dispatcher&&) = delete;
+    ipc_dispatcher& operator = (ipc_dispatcher const&) = delete;
+    ipc_dispatcher& operator = (ipc_dispatcher&&) = delete;
+
+    /**
+     * @brief start the io threads.
+     */
+    void start() {
+        for (std::size_t i = 0; i < threads_size_; i++) {
+            threads_.emplace_back([this]{ operator()(); });
+        }
+    }
+
+    /**
+     * @brief stop the io threads, all the sessions are supposed to have been finished.
+     */
+    void stop() {
+        if (stop_.exchange(true)) {
+            return;
+        }
+        doorbell_.interrupt();
+        for (auto&& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    /**
+     * @brief hand over the session to the io threads.
+     * @param slot the slot index of the session
+     * @param worker the worker of the session, whose handshake has been completed
+     * @param on_finished the callback invoked by the io thread when the session has been finished
+     */
+    void attach(std::size_t slot, std::shared_ptr<ipc_worker> worker, std::function<void(void)> on_finished) {
+        auto& e = entries_.at(slot);
+        {
+            std::lock_guard<std::mutex> lock(e.mtx_);
+            e.worker_ = worker;
+            e.on_finished_ = std::move(on_finished);
+        }
+        worker->set_notifier([this, slot]{ notify(slot); });
+        notify(slot);
+    }
+
+    /**
+     * @brief let the io thread check the session immediately, such as after a shutdown request.
+     * @param slot the slot index of the session
+     */
+    void notify(std::size_t slot) {
+        entries_.at(slot).tick_.store(true);
+        doorbell_.ring(slot);
+    }
+
+private:
+    class entry {
+    public:
+        std::mutex mtx_{};
+        std::shared_ptr<ipc_worker> worker_{};
+        std::function<void(void)> on_finished_{};
+        std::atomic_bool busy_{};
+        std::atomic_bool pending_{};
+        std::atomic_bool tick_{};
+        std::atomic<std::chrono::steady_clock::rep> due_{never};  // when idle() is due, given by ipc_worker::next_idle()
+    };
+
+    static constexpr std::chrono::steady_clock::rep never = std::chrono::steady_clock::time_point::max().time_since_epoch().count();
+
+    tateyama::common::wire::connection_queue::doorbell& doorbell_;
+    std::size_t threads_size_;
+    std::vector<entry> entries_;
+    std::vector<std::thread> threads_{};
+    std::atomic_bool stop_{};
+
+    std::mutex mtx_sweep_{};
+    std::chrono::steady_clock::time_point next_sweep_{};
+
+    void operator()() {
+        pthread_setname_np(pthread_self(), "ipc_io");
+        while (!stop_.load()) {
+            auto slot = doorbell_.wait(sweep_interval);
+            if (slot < entries_.size()) {
+                serve(entries_.at(slot));
+            }
+            sweep();
+        }
+    }
+
+    // at most one io thread serves a session at a time, the others leave the work to that thread by setting pending_
+    void serve(entry& e) {
+        e.pending_.store(true);
+        while (!e.busy_.exchange(true)) {
+            std::shared_ptr<ipc_worker> worker{};
+            {
+                std::lock_guard<std::mutex> lock(e.mtx_);
+                worker = e.worker_;
+            }
+            bool alive = true;
+            if (worker) {
+                while (alive && e.pending_.exchange(false)) {
+                    alive = worker->poll();
+                    if (alive && e.tick_.exchange(false)) {
+                        alive = worker->idle();
+                    }
+                }
+            } else {
+                e.pending_.store(false);
+            }
+            if (!alive) {
+                finish(e, worker);
+            } else if (worker) {
+                e.due_.store(worker->next_idle().time_since_epoch().count());
+            }
+            e.busy_.store(false);
+            if (!e.pending_.load()) {
+                break;
+            }
+        }
+    }
+
+    void finish(entry& e, const std::shared_ptr<ipc_worker>& worker) {
+        std::function<void(void)> on_finished{};
+        {
+            std::lock_guard<std::mutex> lock(e.mtx_);
+            e.worker_ = nullptr;
+            on_finished = std::move(e.on_finished_);
+            e.on_finished_ = nullptr;
+        }
+        e.tick_.store(false);
+        e.due_.store(never);
+        worker->set_notifier(nullptr);
+        worker->finish();
+        if (on_finished) {
+            on_finished();
+        }
+    }
+
+    void sweep() {
+        std::unique_lock<std::mutex> lock(mtx_sweep_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;  // another io thread is sweeping
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_sweep_) {
+            return;
+        }
+        next_sweep_ = now + std::chrono::microseconds(sweep_interval);
+        for (auto&& e : entries_) {
+            if (e.due_.load() > now.time_since_epoch().count()) {
+                continue;
+            }
+            e.tick_.store(true);
+            serve(e);
+        }
+    }
+};
+
+}
@@ -38,6 +38,9 @@
 #include "tateyama/endpoint/common/pointer_comp.h"
 #include "tateyama/endpoint/ipc/metrics/ipc_metrics.h"
 #include "ipc_worker.h"
+#include "ipc_dispatcher.h"
+#include "session_setup_pool.h"
+#include "admin_channel_server.h"
 
 namespace tateyama::endpoint::ipc::bootstrap {
 
@@ -103,8 +106,63 @@ public:
         VLOG_LP(log_debug) << "allow_blob_privileged = " << utils::boolalpha(allow_blob_privileged);
         conf_.allow_blob_privileged(allow_blob_privileged);
 
+        auto io_threads_opt = endpoint_config->get<std::size_t>("io_threads");
+        auto io_threads = io_threads_opt ? io_threads_opt.value() : 0;
+        VLOG_LP(log_debug) << "io_threads = " << io_threads;
+
+        auto max_datachannel_buffers_total_opt = endpoint_config->get<std::size_t>("max_datachannel_buffers_total");
+        auto max_datachannel_buffers_total = max_datachannel_buffers_total_opt ? max_datachannel_buffers_total_opt.value() : 0;
+        VLOG_LP(log_debug) << "max_datachannel_buffers_total = " << max_datachannel_buffers_total;
+
+        auto annex_writer_threads_opt = endpoint_config->get<std::size_t>("annex_writer_threads");
+        auto annex_writer_threads = annex_writer_threads_opt ? annex_writer_threads_opt.value() : annex_writer_pool::default_threads;
+        if (annex_writer_threads == 0) {
+            throw std::runtime_error("annex_writer_threads in ipc_endpoint section should be greater than 0");
+        }
+        VLOG_LP(log_debug) << "annex_writer_threads = " << annex_writer_threads;
+
+        auto max_annex_memory_opt = endpoint_config->get<std::size_t>("max_annex_memory");
+        auto max_annex_memory = max_annex_memory_opt ? max_annex_memory_opt.value() : 0;
+        VLOG_LP(log_debug) << "max_annex_memory = " << max_annex_memory << " MB";
+
+        auto max_annex_memory_per_session_opt = endpoint_config->get<std::size_t>("max_annex_memory_per_session");
+        auto max_annex_memory_per_session = max_annex_memory_per_session_opt ? max_annex_memory_per_session_opt.value() : 0;
+        VLOG_LP(log_debug) << "max_annex_memory_per_session = " << max_annex_memory_per_session << " MB";
+
+        auto annex_spill_directory_opt = endpoint_config->get<std::string>("annex_spill_directory");
+        auto annex_spill_directory = annex_spill_directory_opt ? annex_spill_directory_opt.value() : std::string{};
+        VLOG_LP(log_debug) << "annex_spill_directory = " << annex_spill_directory;
+
+        auto session_setup_threads_opt = endpoint_config->get<std::size_t>("session_setup_threads");
+        auto session_setup_threads = session_setup_threads_opt ? session_setup_threads_opt.value() : session_setup_pool::default_threads;
+        VLOG_LP(log_debug) << "session_setup_threads = " << session_setup_threads;
+
+        auto admin_channel_buffer_size_opt = endpoint_config->get<std::size_t>("admin_channel_buffer_size");
+        auto admin_channel_buffer_size = (admin_channel_buffer_size_opt ? admin_channel_buffer_size_opt.value() : admin_channel_server::default_buffer_size) * 1024;  // in KB
+        VLOG_LP(log_debug) << "admin_channel_buffer_size = " << admin_channel_buffer_size << " bytes";
+
         // connection channel
-        container_ = std::make_unique<connection_container>(database_name_, threads, admin_sessions);
+        container_ = std::make_unique<connection_container>(database_name_, threads, admin_sessions, admin_channel_buffer_size);
+
+        // threads serving the admin channel, each request being served takes an admin slot shared with the admin sessions
+        if (auto* admin_channel = container_->get_admin_channel(); admin_channel) {
+            admin_server_ = std::make_unique<admin_channel_server>(*admin_channel, container_->get_connection_queue(), router_, conf_, admin_sessions);
+        }
+
+        // result set buffers shared by all the sessions
+        buffer_pool_ = std::make_shared<resultset_buffer_pool>(server_wire_container_impl::resultset_buffer_size(datachannel_buffer_size_), max_datachannel_buffers_, max_datachannel_buffers_total);
+
+        // threads transferring the records overflowing the result set buffers
+        annex_pool_ = std::make_shared<annex_writer_pool>(annex_writer_threads);
+        annex_pool_->set_memory_limit(max_annex_memory * 1024 * 1024, max_annex_memory_per_session * 1024 * 1024, annex_spill_directory);  // in MB
+
+        // threads setting up the sessions requested
+        setup_pool_ = std::make_shared<session_setup_pool>(session_setup_threads);
+
+        // io threads serving the sessions after handshake
+        if (io_threads > 0) {
+            dispatcher_ = std::make_unique<ipc_dispatcher>(container_->get_connection_queue().get_doorbell(), io_threads, threads + admin_sessions);
+        }
 
         // worker objects
         workers_.resize(threads + admin_sessions);
@@ -113,8 +171,13 @@ public:
         status_->set_maximum_sessions(threads + admin_sessions);
 
         // set memory usage parameters to ipc_metrics
-        ipc_metrics_.set_memory_parameters(connection_container::fixed_memory_size(threads + admin_sessions),
-                                           server_wire_container_impl::proportional_memory_size(datachannel_buffer_size_, max_datachannel_buffers_));
+        ipc_metrics_.set_memory_parameters(connection_container::fixed_memory_size(threads + admin_sessions,
+                                                                                   admin_server_ ? admin_sessions * connection_container::admin_channel_entries_per_session : 0,
+                                                                                   admin_channel_buffer_size),
+                                           server_wire_container_impl::proportional_memory_size(datachannel_buffer_size_, 0),
+                                           buffer_pool_);
+        ipc_metrics_.set_annex_writer_pool(annex_pool_);
+        ipc_metrics_.set_session_setup_pool(setup_pool_);
 
         // output configuration to be used
         LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
@@ -132,6 +195,30 @@ public:
         LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
                   << "admin_sessions: " << admin_sessions << ", "
                   << "the number of maximum admin sessions.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "io_threads: " << io_threads << ", "
+                  << "the number of io threads serving the sessions, 0 means a thread per session.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "max_datachannel_buffers_total: " << max_datachannel_buffers_total << ", "
+                  << "the number of maximum datachannel buffers used by all the sessions, 0 means no limit other than max_datachannel_buffers.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "annex_writer_threads: " << annex_writer_threads << ", "
+                  << "the number of threads transferring the records overflowing the result set buffers.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "max_annex_memory: " << max_annex_memory << ", "
+                  << "the heap memory in MB used by all the sessions for the records overflowing the result set buffers, 0 means unlimited.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "max_annex_memory_per_session: " << max_annex_memory_per_session << ", "
+                  << "the heap memory in MB used by a session for the records overflowing the result set buffers, 0 means unlimited.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "annex_spill_directory: " << annex_spill_directory << ", "
+                  << "the directory of the temporary files holding the records beyond the memory limits.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "session_setup_threads: " << session_setup_threads << ", "
+                  << "the number of threads setting up the sessions requested, 0 means the listener sets up the sessions by itself.";
+        LOG(INFO) << tateyama::endpoint::common::ipc_endpoint_config_prefix
+                  << "admin_channel_buffer_size: " << admin_channel_buffer_size / 1024 << ", "
+                  << "the buffer size in KB of each admin channel entry, 0 means that no admin channel is provided.";
 
         // session
         if (auto* session_config = cfg_->get_section("session"); session_config) {
@@ -191,6 +278,12 @@ public:
         pthread_setname_np(pthread_self(), "ipc_listener");
         auto& connection_queue = container_->get_connection_queue();
         proc_mutex_file_ = status_->mutex_file();
+        if (dispatcher_) {
+            dispatcher_->start();
+        }
+        if (admin_server_) {
+            admin_server_->start();
+        }
         arrive_and_wait();
 
         while(true) {
@@ -202,55 +295,25 @@ public:
                 }
                 if (connection_queue.is_terminated()) {
                     VLOG_LP(log_trace) << "receive terminate request";
+                    setup_pool_->stop();
+                    if (admin_server_) {
+                        admin_server_->stop();
+                    }
                     terminate_workers();
                     connection_queue.confirm_terminated();
                     break;    // shutdown the ipc_listener
                 }
-                auto slot_id = connection_queue.slot();
-                auto slot_index = tateyama::common::wire::connection_queue::reset_admin(slot_id);
-                try {
-                    std::string session_name = database_name_;
-                    session_name += "-";
-                    session_name += std::to_string(session_id);
-                    auto wire = std::make_unique<server_wire_container_impl>(session_name, proc_mutex_file_, datachannel_buffer_size_, max_datachannel_buffers_, [this, session_id, slot_index](){status_->remove_shm_entry(session_id, slot_index);});
-                    VLOG_LP(log_trace) << "create session wire: " << session_name << " at index " << slot_index;
-                    status_->add_shm_entry(session_id, slot_index);
-
-                    auto& worker_entry = workers_.at(slot_index);
-                    std::unique_lock<std::mutex> lock(mtx_workers_);
-                    worker_entry = std::make_shared<ipc_worker>(*router_, conf_, session_id, std::move(wire));
-                    connection_queue.accept(slot_id, session_id);
-                    ipc_metrics_.increase();
-                    worker_entry->invoke([this, slot_id, slot_index, &connection_queue]{
-                        auto& worker = workers_.at(slot_index);
-                        worker->register_worker_in_context(worker);
-                        try {
-                            worker->run();
-                        } catch(std::exception &ex) {
-                            LOG(ERROR) << "ipc_endpoint worker thread got an exception: " << ex.what();
-                        }
-                        worker->dispose_session_store();
-                        auto* wp = worker.get();
-                        {
-                            std::unique_lock<std::mutex> lock_w(mtx_workers_);
-                            std::unique_lock<std::mutex> lock_u(mtx_undertakers_);
-                            undertakers_.emplace(std::move(worker));
-                        }
-                        connection_queue.disconnect(slot_id);
-                        wp->delete_hook();
-                        ipc_metrics_.decrease();
-                    });
-                } catch (std::exception& ex) {
-                    LOG_LP(ERROR) << ex.what();
-                    connection_queue.reject(slot_id);
-                    continue;
-                }
+                auto slot_id = connection_queue.take();
+                setup_pool_->submit([this, slot_id, session_id]{ setup_session(slot_id, session_id); });
             } catch (std::exception& ex) {
                 LOG_LP(ERROR) << ex.what();
                 continue;
             }
         }
         confirm_workers_termination();
+        if (dispatcher_) {
+            dispatcher_->stop();
+        }
     }
 
     void arrive_and_wait() override {
@@ -275,6 +338,23 @@ public:
         os << "  connection queue status\n"
               "    session_id accepted = " << container_->session_id_accepted() << "\n"
               "    pending requests = " << container_->pending_requests() << "\n"
+              "    pending setups = " << setup_pool_->pending() << "\n"
+              "    accept latency average = " << setup_pool_->accept_latency_average() << " us\n"
+              "    accept latency max = " << setup_pool_->accept_latency_max() << " us\n"
+              "  admin channel\n"
+              "    entries in use = " << (admin_server_ ? admin_server_->entries_in_use() : 0) << "\n"
+              "    served = " << (admin_server_ ? admin_server_->served() : 0) << "\n"
+              "    reclaimed = " << (admin_server_ ? admin_server_->reclaimed() : 0) << "\n"
+              "  result set buffers\n"
+              "    in use = " << buffer_pool_->in_use() << "\n"
+              "    peak = " << buffer_pool_->peak() << "\n"
+              "    rejected = " << buffer_pool_->rejected() << "\n"
+              "  annex writers\n"
+              "    buffered bytes = " << annex_pool_->buffered_bytes() << "\n"
+              "    stalled writers = " << annex_pool_->stalled_tasks() << "\n"
+              "    stall time = " << annex_pool_->stall_time() << " us\n"
+              "    heap bytes = " << annex_pool_->heap_bytes() << "\n"
+              "    spilled bytes = " << annex_pool_->spilled_bytes() << "\n"
               "/:tateyama:ipc_endpoint print diagnostics end\n";
     }
 
@@ -294,6 +374,11 @@ private:
     tateyama::endpoint::ipc::metrics::ipc_metrics ipc_metrics_;
 
     std::unique_ptr<connection_container> container_{};
+    std::unique_ptr<ipc_dispatcher> dispatcher_{};
+    std::shared_ptr<resultset_buffer_pool> buffer_pool_{};
+    std::shared_ptr<annex_writer_pool> annex_pool_{};
+    std::shared_ptr<session_setup_pool> setup_pool_{};
+    std::unique_ptr<admin_channel_server> admin_server_{};
     std::vector<std::shared_ptr<ipc_worker>> workers_{};
     std::set<std::shared_ptr<ipc_worker>, tateyama::endpoint::common::pointer_comp<ipc_worker>> undertakers_{};
     std::string database_name_;
@@ -305,6 +390,62 @@ private:
 
     boost::barrier sync{2};
 
+    void setup_session(std::size_t slot_id, std::size_t session_id) {
+        auto& connection_queue = container_->get_connection_queue();
+        auto slot_index = tateyama::common::wire::connection_queue::reset_admin(slot_id);
+        try {
+            std::string session_name = database_name_;
+            session_name += "-";
+            session_name += std::to_string(session_id);
+            auto wire = std::make_unique<server_wire_container_impl>(session_name, proc_mutex_file_, datachannel_buffer_size_, max_datachannel_buffers_, [this, session_id, slot_index](){status_->remove_shm_entry(session_id, slot_index);}, buffer_pool_, annex_pool_);
+            VLOG_LP(log_trace) << "create session wire: " << session_name << " at index " << slot_index;
+            if (dispatcher_) {
+                wire->enable_doorbell(slot_index);
+            }
+            status_->add_shm_entry(session_id, slot_index);
+
+            auto& worker_entry = workers_.at(slot_index);
+            std::unique_lock<std::mutex> lock(mtx_workers_);
+            worker_entry = std::make_shared<ipc_worker>(*router_, conf_, session_id, std::move(wire));
+            if (auto elapsed = connection_queue.elapsed(slot_id); elapsed) {
+                setup_pool_->record_accept(elapsed.value());
+            }
+            connection_queue.accept_taken(slot_id, session_id);
+            ipc_metrics_.increase();
+            worker_entry->invoke([this, slot_id, slot_index, &connection_queue]{
+                auto& worker = workers_.at(slot_index);
+                worker->register_worker_in_context(worker);
+                try {
+                    if (!worker->run(dispatcher_ != nullptr)) {
+                        dispatcher_->attach(slot_index, worker, [this, slot_id, slot_index, &connection_queue]{
+                            retire_worker(slot_id, slot_index, connection_queue);
+                        });
+                        return;
+                    }
+                } catch(std::exception &ex) {
+                    LOG(ERROR) << "ipc_endpoint worker thread got an exception: " << ex.what();
+                }
+                retire_worker(slot_id, slot_index, connection_queue);
+            });
+        } catch (std::exception& ex) {
+            LOG_LP(ERROR) << ex.what();
+            connection_queue.reject_taken(slot_id);
+        }
+    }
+    void retire_worker(std::size_t slot_id, std::size_t slot_index, tateyama::common::wire::connection_queue& connection_queue) {
+        auto& worker = workers_.at(slot_index);
+        worker->dispose_session_store();
+        auto* wp = worker.get();
+        {
+            std::unique_lock<std::mutex> lock_w(mtx_workers_);
+            std::unique_lock<std::mutex> lock_u(mtx_undertakers_);
+            worker->set_detached(false);
+            undertakers_.emplace(std::move(worker));
+        }
+        connection_queue.disconnect(slot_id);
+        wp->delete_hook();
+        ipc_metrics_.decrease();
+    }
     bool care_undertakers() {
         std::unique_lock<std::mutex> lock(mtx_undertakers_);
         for (auto it{undertakers_.begin()}, end{undertakers_.end()}; it != end; ) {
@@ -320,8 +461,8 @@ private:
         tateyama::status_info::shutdown_type shutdown_type = status_->get_shutdown_request();
         {
             std::unique_lock<std::mutex> lock(mtx_workers_);
-            for (auto&& worker : workers_) {
-                if (worker) {
+            for (std::size_t slot_index = 0; slot_index < workers_.size(); slot_index++) {
+                if (auto& worker = workers_.at(slot_index); worker) {
                     worker->terminate(shutdown_type == tateyama::status_info::shutdown_type::graceful ?
                                       tateyama::session::shutdown_request_type::graceful :
                                       tateyama::session::shutdown_request_type::forceful);
@@ -24,7 +24,7 @@
 
 namespace tateyama::endpoint::ipc::bootstrap {
 
-void ipc_worker::run() {  // NOLINT(readability-function-cognitive-complexity)
+bool ipc_worker::run(bool detachable) {  // NOLINT(readability-function-cognitive-complexity)
     pthread_setname_np(pthread_self(), "ipc_worker");
     tateyama::common::wire::message_header hdr{};
     while(true) {
@@ -35,14 +35,14 @@ void ipc_worker::run() {  // NOLINT(readability-function-cognitive-complexity)
         }
         if (hdr.get_length() == 0 && hdr.get_idx() == tateyama::common::wire::message_header::terminate_request) {
             VLOG_LP(log_trace) << "received shutdown request: session_id = " << std::to_string(session_id());
-            return;
+            return true;
         }
 
         ipc_request request_obj{*wire_, hdr, resources(), local_id_++, conf_};
         ipc_response response_obj{*wire_, hdr.get_idx(), [](){}, conf_, std::this_thread::get_id()};
         try {
             if (! handshake(static_cast<tateyama::api::server::request*>(&request_obj), static_cast<tateyama::api::server::response*>(&response_obj))) {
-                return;
+                return true;
             }
             break;
         } catch (psudo_exception_of_continue &ex) {
@@ -52,116 +52,161 @@ void ipc_worker::run() {  // NOLINT(readability-function-cognitive-complexity)
 
     VLOG(log_debug_timing_event) << "/:tateyama:timing:session:started " << session_id();
 #ifdef ENABLE_ALTIMETER
-    const std::chrono::time_point session_start_time = std::chrono::steady_clock::now();
+    session_start_time_ = std::chrono::steady_clock::now();
     tateyama::endpoint::altimeter::session_start(conf_.database_info(), resources().session_info());
 #endif
-    bool notiry_expiration_time_over{};
+    if (detachable && request_wire_container_->doorbell_attached()) {
+        VLOG_LP(log_trace) << "hand over session " << session_id() << " to the io threads";
+        set_detached(true);
+        return false;
+    }
     while(true) {
         try {
             hdr = request_wire_container_->peep();
         } catch (std::exception &ex) {
-            care_reqreses();
-            if (check_shutdown_request() && is_completed()) {
-                VLOG_LP(log_trace) << "terminate worker thread for session " << session_id() << ", as it has received a shutdown request";
+            if (!idle()) {
                 break;  // break the while loop
             }
-            if (!notiry_expiration_time_over) {
-                if (is_expiration_time_over()) {
-                    wire_->force_close();
-                    request_shutdown(tateyama::session::shutdown_request_type::forceful);
-                    notiry_expiration_time_over = true;
-                }
-            }
             continue;
         }
-        try {
-            if (hdr.get_length() == 0 && hdr.get_idx() == tateyama::common::wire::message_header::terminate_request) {
-                request_shutdown(tateyama::session::shutdown_request_type::forceful);
-                care_reqreses();
-                if (check_shutdown_request() && is_completed()) {
-                    VLOG_LP(log_trace) << "terminate worker thread for session " << session_id() << ", as disconnection is requested and the subsequent shutdown process is completed";
-                    break;  // break the while loop
-                }
-                VLOG_LP(log_trace) << "shutdown for session " << session_id() << " is to be delayed";
-                continue;
+        if (!process(hdr)) {
+            break;  // break the while loop
+        }
+    }
+    finish();
+    return true;
+}
+
+bool ipc_worker::poll() {
+    request_wire_container_->disarm_doorbell();
+    while (request_wire_container_->has_request()) {
+        if (!process(request_wire_container_->peep())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ipc_worker::idle() {
+    care_reqreses();
+    if (check_shutdown_request() && is_completed()) {
+        VLOG_LP(log_trace) << "terminate worker for session " << session_id() << ", as it has received a shutdown request";
+        return false;
+    }
+    if (!notify_expiration_time_over_) {
+        if (is_expiration_time_over()) {
+            wire_->force_close();
+            request_shutdown(tateyama::session::shutdown_request_type::forceful);
+            notify_expiration_time_over_ = true;
+        }
+    }
+    return true;
+}
+
+std::chrono::steady_clock::time_point ipc_worker::next_idle() {
+    auto now = std::chrono::steady_clock::now();
+    if (shutdown_requested() || has_reqreses() || has_incomplete_resultset()) {
+        return now;
+    }
+    if (auto expiration_time = next_expiration_time(); expiration_time && !notify_expiration_time_over_) {
+        auto remaining = expiration_time.value() - tateyama::session::session_context::expiration_time_type::clock::now();
+        return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(remaining);
+    }
+    return std::chrono::steady_clock::time_point::max();
+}
+
+bool ipc_worker::process(tateyama::common::wire::message_header hdr) {  // NOLINT(readability-function-cognitive-complexity)
+    try {
+        if (hdr.get_length() == 0 && hdr.get_idx() == tateyama::common::wire::message_header::terminate_request) {
+            request_shutdown(tateyama::session::shutdown_request_type::forceful);
+            care_reqreses();
+            if (check_shutdown_request() && is_completed()) {
+                VLOG_LP(log_trace) << "terminate worker for session " << session_id() << ", as disconnection is requested and the subsequent shutdown process is completed";
+                return false;
             }
+            VLOG_LP(log_trace) << "shutdown for session " << session_id() << " is to be delayed";
+            return true;
+        }
 
-            update_expiration_time();
-            auto request = std::make_shared<ipc_request>(*wire_, hdr, resources(), local_id_++, conf_);
-            std::size_t index = hdr.get_idx();
-            bool exit_frag = false;
-            switch (request->service_id()) {
-            case tateyama::framework::service_id_endpoint_broker:
-            {
-                auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [](){}, conf_, std::this_thread::get_id());
-                // currently cancel request only
-                if (!endpoint_service(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                      std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response),
+        update_expiration_time();
+        auto request = std::make_shared<ipc_request>(*wire_, hdr, resources(), local_id_++, conf_);
+        std::size_t index = hdr.get_idx();
+        bool exit_frag = false;
+        switch (request->service_id()) {
+        case tateyama::framework::service_id_endpoint_broker:
+        {
+            auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [](){}, conf_, std::this_thread::get_id());
+            // currently cancel request only
+            if (!endpoint_service(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                                  std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response),
+                                  index)) {
+                VLOG_LP(log_info) << "terminate worker because endpoint service returns an error";
+                exit_frag = true;
+            }
+            break;  // break the switch
+        }
+        case tateyama::framework::service_id_routing:
+        {
+            auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [this, index](){remove_reqres(index);}, conf_, std::this_thread::get_id());
+            if (!register_reqres(index,
+                                std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
+                                std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
+                return true;  // error has been notified to the client
+            }
+            if (routing_service_chain(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                                      std::dynamic_pointer_cast<tateyama::api::server::response>(response),
                                       index)) {
-                    VLOG_LP(log_info) << "terminate worker because endpoint service returns an error";
+                care_reqreses();
+                if (check_shutdown_request() && is_completed()) {
+                    VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
                     exit_frag = true;
                 }
-                break;  // break the switch, and set exit_flag true to break the while loop
+                break;  // break the switch
+            }
+            if (!service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                          std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
+                VLOG_LP(log_info) << "terminate worker because service returns an error";
+                exit_frag = true;
             }
-            case tateyama::framework::service_id_routing:
-            {
-                auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [this, index](){remove_reqres(index);}, conf_, std::this_thread::get_id());
+            break;  // break the switch
+        }
+        default:
+        {
+            auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [this, index](){remove_reqres(index);}, conf_, std::this_thread::get_id());
+            if (!check_shutdown_request()) {
                 if (!register_reqres(index,
-                                    std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
-                                    std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
-                    continue;  // error has been notified to the client
-                }
-                if (routing_service_chain(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                          std::dynamic_pointer_cast<tateyama::api::server::response>(response),
-                                          index)) {
-                    care_reqreses();
-                    if (check_shutdown_request() && is_completed()) {
-                        VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
-                        exit_frag = true;
-                    }
-                    break;  // break the switch, and set exit_flag true to break the while loop
+                                     std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
+                                     std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
+                    return true;  // error has been notified to the client
                 }
                 if (!service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
                               std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
                     VLOG_LP(log_info) << "terminate worker because service returns an error";
                     exit_frag = true;
                 }
-                break;  // break the switch, and set exit_flag true to break the while loop
-            }
-            default:
-            {
-                auto response = std::make_shared<ipc_response>(*wire_, hdr.get_idx(), [this, index](){remove_reqres(index);}, conf_, std::this_thread::get_id());
-                if (!check_shutdown_request()) {
-                    if (!register_reqres(index,
-                                         std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
-                                         std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
-                        continue;  // error has been notified to the client
-                    }
-                    if (!service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                  std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
-                        VLOG_LP(log_info) << "terminate worker because service returns an error";
-                        exit_frag = true;
-                    }
-                } else {
-                    notify_client(response.get(), tateyama::proto::diagnostics::SESSION_CLOSED, "this session is already shutdown");
-                }
-                break;  // break the switch, and set exit_flag true to break the while loop
-            }
+            } else {
+                notify_client(response.get(), tateyama::proto::diagnostics::SESSION_CLOSED, "this session is already shutdown");
             }
-            if (exit_frag) {
-                break;  // break the while loop
-            }
-            request->dispose();
-            request = nullptr;
-            wire_->get_garbage_collector()->dump();
-        } catch (std::exception &e) {
-            LOG_LP(ERROR) << e.what();
-            break;  // break the while loop
+            break;  // break the switch
+        }
         }
+        if (exit_frag) {
+            return false;
+        }
+        request->dispose();
+        request = nullptr;
+        wire_->get_garbage_collector()->dump();
+    } catch (std::exception &e) {
+        LOG_LP(ERROR) << e.what();
+        return false;
     }
+    return true;
+}
+
+void ipc_worker::finish() {
     VLOG_LP(log_trace) << "destroy session wire: session_id = " << std::to_string(session_id());
 #ifdef ENABLE_ALTIMETER
-    tateyama::endpoint::altimeter::session_end(conf_.database_info(), resources().session_info(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - session_start_time).count());
+    tateyama::endpoint::altimeter::session_end(conf_.database_info(), resources().session_info(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - session_start_time_).count());
 #endif
     VLOG(log_debug_timing_event) << "/:tateyama:timing:session:finished " << session_id();
 }
@@ -171,8 +216,21 @@ bool ipc_worker::terminate(tateyama::session::shutdown_request_type type) {
     VLOG_LP(log_trace) << "send terminate request: session_id = " << std::to_string(session_id());
 
     auto rv = request_shutdown(type);
-    wire_->get_request_wire()->notify();
+    wake_up();
     return rv;
 }
 
+void ipc_worker::wake_up() {
+    std::function<void(void)> notifier{};
+    {
+        std::lock_guard<std::mutex> lock(mtx_notifier_);
+        notifier = notifier_;
+    }
+    if (notifier) {
+        notifier();  // the detached session does not wait on the request wire
+        return;
+    }
+    wire_->get_request_wire()->notify();
+}
+
 }
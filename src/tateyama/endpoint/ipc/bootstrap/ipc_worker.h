@@ -16,6 +16,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
 
 #include "tateyama/endpoint/common/worker_common.h"
 #include "tateyama/endpoint/ipc/ipc_request.h"
@@ -41,14 +44,54 @@ public:
         shutdown_complete();
         wire_->get_response_wire().notify_shutdown();
     }
-    void run();
+    /**
+     * @brief serve the session on the calling thread.
+     * @param detachable whether the session can be handed over to the io threads after the handshake
+     * @return false if the session has been handed over to the io threads, otherwise true
+     */
+    bool run(bool detachable = false);
+    /**
+     * @brief process the requests arrived, used by the io threads.
+     * @return false if the session is to be finished
+     */
+    bool poll();
+    /**
+     * @brief housekeeping performed periodically while no request arrives.
+     * @return false if the session is to be finished
+     */
+    bool idle();
+    /**
+     * @brief returns when idle() is due next, used by the io threads to skip the sessions having nothing to check.
+     * @return the time point, which is now if the session has the requests or the shutdown in progress
+     */
+    std::chrono::steady_clock::time_point next_idle();
+    /**
+     * @brief the epilogue of the session.
+     */
+    void finish();
     bool terminate(tateyama::session::shutdown_request_type type);
+    /**
+     * @brief set the function waking up the io thread serving the session, nullptr while the session is served by its own thread.
+     */
+    void set_notifier(std::function<void(void)> notifier) {
+        std::lock_guard<std::mutex> lock(mtx_notifier_);
+        notifier_ = std::move(notifier);
+    }
+    void wake_up() override;
 
 private:
     tateyama::framework::routing_service& service_;
     std::unique_ptr<server_wire_container_impl> wire_;
     server_wire_container_impl::wire_container_impl* request_wire_container_;
     const tateyama::endpoint::common::configuration& conf_;
+    bool notify_expiration_time_over_{};
+    std::mutex mtx_notifier_{};
+    std::function<void(void)> notifier_{};
+#ifdef ENABLE_ALTIMETER
+    std::chrono::time_point<std::chrono::steady_clock> session_start_time_{};
+#endif
+
+    bool process(tateyama::common::wire::message_header hdr);
 
     void resultset_force_close() override {
         wire_->get_garbage_collector()->force_close();
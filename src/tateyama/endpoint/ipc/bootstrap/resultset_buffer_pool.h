@@ -0,0 +1,147 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace tateyama::endpoint::ipc::bootstrap {
+
+/**
+ * @brief the server-wide pool of the result set buffers shared by all the IPC sessions.
+ *  The buffer itself is placed in the shared memory of each session, as the client can access only its own segment,
+ *  the pool lends the right to hold a buffer, so that the result set buffers in use are bounded by
+ *  the per-session quota and the server-wide capacity, and are returned as soon as the result set is closed.
+ */
+class resultset_buffer_pool {
+public:
+    /**
+     * @brief construct the pool
+     * @param buffer_size the size of each result set buffer, including its overhead
+     * @param quota the maximum number of buffers a session can hold at a time
+     * @param capacity the maximum number of buffers all the sessions can hold at a time, 0 means unlimited
+     */
+    resultset_buffer_pool(std::size_t buffer_size, std::size_t quota, std::size_t capacity) noexcept
+        : buffer_size_(buffer_size), quota_(quota), capacity_(capacity) {
+    }
+
+    /**
+     * @brief the usage of the pool by a session.
+     */
+    class session {
+    public:
+        session() = default;
+        explicit session(std::shared_ptr<resultset_buffer_pool> pool) noexcept : pool_(std::move(pool)) {
+        }
+        ~session() {
+            if (pool_ != nullptr) {
+                pool_->release(*this, held_.load());
+            }
+        }
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        session(session const&) = delete;
+        session(session&&) = delete;
+        session& operator = (session const&) = delete;
+        session& operator = (session&&) = delete;
+
+        /**
+         * @brief acquire a buffer from the pool
+         * @return true if the buffer can be held by the session
+         */
+        [[nodiscard]] bool acquire() noexcept {
+            return (pool_ == nullptr) || pool_->acquire(*this);
+        }
+        /**
+         * @brief return buffers to the pool
+         * @param n the number of buffers returned
+         */
+        void release(std::size_t n) noexcept {
+            if (pool_ != nullptr) {
+                pool_->release(*this, n);
+            }
+        }
+        /**
+         * @brief returns the number of buffers held by the session
+         */
+        [[nodiscard]] std::size_t held() const noexcept {
+            return held_.load();
+        }
+
+    private:
+        std::shared_ptr<resultset_buffer_pool> pool_{};
+        std::atomic_size_t held_{};
+
+        friend class resultset_buffer_pool;
+    };
+
+    [[nodiscard]] std::size_t buffer_size() const noexcept { return buffer_size_; }
+    [[nodiscard]] std::size_t quota() const noexcept { return quota_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return capacity_; }
+    [[nodiscard]] std::size_t in_use() const noexcept { return in_use_.load(); }
+    [[nodiscard]] std::size_t peak() const noexcept { return peak_.load(); }
+    [[nodiscard]] std::size_t rejected() const noexcept { return rejected_.load(); }
+    [[nodiscard]] std::size_t bytes_in_use() const noexcept { return in_use_.load() * buffer_size_; }
+
+private:
+    const std::size_t buffer_size_;
+    const std::size_t quota_;
+    const std::size_t capacity_;
+
+    std::atomic_size_t in_use_{};
+    std::atomic_size_t peak_{};
+    std::atomic_size_t rejected_{};
+
+    bool acquire(session& s) noexcept {
+        auto held = s.held_.load();
+        do {
+            if (held >= quota_) {
+                return reject();
+            }
+        } while (!s.held_.compare_exchange_weak(held, held + 1));
+
+        auto in_use = in_use_.load();
+        do {
+            if ((capacity_ > 0) && (in_use >= capacity_)) {
+                s.held_.fetch_sub(1);
+                return reject();
+            }
+        } while (!in_use_.compare_exchange_weak(in_use, in_use + 1));
+
+        auto peak = peak_.load();
+        while (peak <= in_use) {
+            if (peak_.compare_exchange_weak(peak, in_use + 1)) {
+                break;
+            }
+        }
+        return true;
+    }
+    void release(session& s, std::size_t n) noexcept {
+        if (n > 0) {
+            s.held_.fetch_sub(n);
+            in_use_.fetch_sub(n);
+        }
+    }
+    bool reject() noexcept {
+        rejected_.fetch_add(1);
+        return false;
+    }
+};
+
+}
@@ -16,6 +16,7 @@
 #pragma once
 
 #include <set>
+#include <cstring>
 #include <mutex>
 #include <condition_variable>
 #include <string>
@@ -24,6 +25,7 @@
 #include <sstream>
 #include <string_view>
 #include <functional>
+#include <algorithm>
 
 #include <boost/version.hpp>
 
@@ -32,6 +34,8 @@
 
 #include "tateyama/endpoint/ipc/wire.h"
 #include "tateyama/endpoint/ipc/server_wires.h"
+#include "resultset_buffer_pool.h"
+#include "annex_writer_pool.h"
 
 namespace tateyama::endpoint::ipc::bootstrap {
 
@@ -39,7 +43,9 @@ class server_wire_container_impl : public server_wire_container
 {
     static constexpr std::size_t request_buffer_size = (1<<12);   //  4K bytes NOLINT
     static constexpr std::size_t response_buffer_size = (1<<13);  //  8K bytes NOLINT
-    static constexpr std::size_t data_channel_overhead = 7700;   //  by experiment NOLINT
+    static constexpr std::size_t max_response_buffer_size = (1<<16);  //  64K bytes, the response buffer grows up to this size NOLINT
+    static constexpr std::size_t response_buffer_grow_threshold = 4;  // the number of the messages that do not fit the room, before the response buffer grows NOLINT
+    static constexpr std::size_t data_channel_overhead = 7700 + 256;   //  by experiment, plus the cache line gaps in the wire NOLINT
 #if BOOST_VERSION < 108600
     static constexpr std::size_t total_overhead = (1<<14);   //  16K bytes by experiment NOLINT
 #else
@@ -48,102 +54,138 @@ class server_wire_container_impl : public server_wire_container
 
 public:
     class resultset_wires_container_impl;
+    class garbage_collector_impl;
 
     // resultset_wire_container
     class resultset_wire_container_impl : public resultset_wire_container {
         class annex {
         public:
-            explicit annex(std::size_t size) {
-                buffer_.reserve(size);
-                read_point_ = buffer_.cbegin();
+            enum class transfer_result {
+                /**
+                 * @brief all the records in this annex have been transferred
+                 */
+                exhausted,
+                /**
+                 * @brief waiting for the records written by the writer
+                 */
+                idle,
+                /**
+                 * @brief waiting for the client to make room in the wire
+                 */
+                stalled,
+                /**
+                 * @brief the result set has been closed by the client
+                 */
+                closed,
+            };
+
+            annex(std::size_t size, const std::shared_ptr<annex_writer_pool::session>& session) : pool_(session->pool()), buffer_(session, size) {
             }
+            ~annex() {
+                pool_.sub_buffered(buffered_.load());
+            }
+
+            /**
+             * @brief Copy and move constructers are delete.
+             */
+            annex(annex const&) = delete;
+            annex(annex&&) = delete;
+            annex& operator = (annex const&) = delete;
+            annex& operator = (annex&&) = delete;
+
             bool is_room(std::size_t length) {
                 std::unique_lock<std::mutex> lock(mtx_chunks_);
                 if (buffer_.capacity() < (write_pos_ + chunk_size_ + length)) {
                     full_ = true;
-                    cnd_chunks_.notify_one();
                     return false;
                 }
                 return true;
             }
             // There is an assumption that write() and flush() are not executed simultaneously
             void write(char const* data, std::size_t length) {
-                buffer_.insert(write_pos_ + chunk_size_, data, length);
+                std::memcpy(buffer_.data() + write_pos_ + chunk_size_, data, length);  // NOLINT
                 chunk_size_ += length;
+                buffered_.fetch_add(length);
+                pool_.add_buffered(length);
             }
             void flush() {
                 std::unique_lock<std::mutex> lock(mtx_chunks_);
                 if (chunk_size_ > 0) {
                     chunks_.push(chunk_size_);
-                    cnd_chunks_.notify_one();
                 }
                 write_pos_ += chunk_size_;
                 chunk_size_ = 0;
             }
-            void notify() {
-                std::unique_lock<std::mutex> lock(mtx_chunks_);
-                cnd_chunks_.notify_one();
-            }
-            bool transfer(tateyama::common::wire::shm_resultset_wire* wire, bool& released) {
+            // transfer the records as long as the wire has room, without blocking
+            transfer_result transfer(tateyama::common::wire::shm_resultset_wire* wire, bool released, bool closed) {
                 while (!exhausted()) {
                     std::unique_lock<std::mutex> lock(mtx_chunks_);
-                    if (chunks_.empty() && !full_ && !released) {
-                        cnd_chunks_.wait(lock, [this, &released]{ return !chunks_.empty() || full_ || released; });
-                    }
                     if (!chunks_.empty()) {
                         std::size_t record_size = chunks_.front();
-                        chunks_.pop();
                         lock.unlock();
-                        if (wire->wait_room(record_size)) {
-                            return false;
+                        if (!wire->check_room(record_size)) {
+                            return publish(wire, closed ? transfer_result::closed : transfer_result::stalled);
                         }
-                        wire->write(std::addressof(*read_point_), record_size);
-                        wire->flush();
-                        read_point_ += static_cast<std::int64_t>(record_size);
+                        wire->write(buffer_.data() + read_pos_, record_size);  // NOLINT
+                        wire->seal();
+                        consume(record_size);
+                        lock.lock();
+                        chunks_.pop();
                         continue;
                     }
                     if (released && chunk_size_ == 0) {
-                        return true;
+                        return publish(wire, transfer_result::exhausted);
                     }
                     if (full_) {
                         if (chunk_size_ > 0) {
-                            if (wire->wait_room(chunk_size_)) {
-                                return false;
+                            if (!wire->check_room(chunk_size_)) {
+                                return publish(wire, closed ? transfer_result::closed : transfer_result::stalled);
                             }
-                            wire->write(std::addressof(*read_point_), chunk_size_);
-                            read_point_ += static_cast<std::int64_t>(chunk_size_);
+                            wire->write(buffer_.data() + read_pos_, chunk_size_);  // NOLINT
+                            consume(chunk_size_);
                         }
-                        return true;
+                        return publish(wire, transfer_result::exhausted);
                     }
+                    return publish(wire, transfer_result::idle);
                 }
-                return true;
+                return publish(wire, transfer_result::exhausted);
             }
             bool exhausted() {
-                return full_ && (read_point_ == buffer_.cend());
+                return full_ && (read_pos_ == write_pos_ + chunk_size_);
             }
 
         private:
-            std::string buffer_{};
-            std::string::const_iterator read_point_{};
+            annex_writer_pool& pool_;
+            annex_writer_pool::buffer buffer_;
+            std::size_t read_pos_{};
             std::queue<std::size_t> chunks_{};
             std::size_t write_pos_{};
             std::size_t chunk_size_{};
             bool full_{};
+            std::atomic_size_t buffered_{};
 
             mutable std::mutex mtx_chunks_{};
-            mutable std::condition_variable cnd_chunks_{};
+
+            // the records transferred by a call of transfer() are made visible to the client at once
+            static transfer_result publish(tateyama::common::wire::shm_resultset_wire* wire, transfer_result rv) {
+                wire->publish();
+                return rv;
+            }
+            void consume(std::size_t length) {
+                read_pos_ += length;
+                buffered_.fetch_sub(length);
+                pool_.sub_buffered(length);
+            }
         };
 
     public:
         resultset_wire_container_impl(tateyama::common::wire::shm_resultset_wire* resultset_wire, resultset_wires_container_impl& resultset_wires_container_impl, std::size_t datachannel_buffer_size)
-            : shm_resultset_wire_(resultset_wire), envelope_(resultset_wires_container_impl), datachannel_buffer_size_(datachannel_buffer_size) {
+            : shm_resultset_wire_(resultset_wire), envelope_(resultset_wires_container_impl), annex_session_(envelope_.annex_session_), datachannel_buffer_size_(datachannel_buffer_size) {
             VLOG_LP(log_trace) << "creates a " << datachannel_buffer_size_ << "-byte buffer for " << envelope_.rsw_name_ << " in the shared memory, leaving " << envelope_.managed_shm_ptr_->get_free_memory() << " byte remaining.";
         }
         ~resultset_wire_container_impl() override {
-            if (thread_invoked_) {
-                if(writer_thread_.joinable()) {
-                    writer_thread_.join();
-                }
+            if (task_) {
+                task_->detach();
             }
         }
 
@@ -155,32 +197,45 @@ public:
         resultset_wire_container_impl& operator = (resultset_wire_container_impl const&) = delete;
         resultset_wire_container_impl& operator = (resultset_wire_container_impl&&) = delete;
 
-        void operator()() {
+        // run by the annex_writer_pool
+        annex_writer_pool::task::state transfer() {
+            if (discarded_.load()) {
+                return annex_writer_pool::task::state::finished;
+            }
             while (true) {
+                annex* current_annex{};
+                bool released{};
                 {
                     std::unique_lock<std::mutex> lock(mtx_queue_);
 
-                    cnd_queue_.wait(lock, [this]{ return !queue_.empty() || released_; });
-                    if (queue_.empty() && released_) {
+                    released = released_;
+                    if (queue_.empty()) {
+                        if (!released) {
+                            return annex_writer_pool::task::state::idle;
+                        }
                         VLOG_LP(log_trace) << "exit writer annex mode because the end of the records";
                         write_complete();
                         break;
                     }
-                    auto annex = queue_.front().get();
-                    lock.unlock();
-                    if (auto rv = annex->transfer(shm_resultset_wire_, released_); !rv) {
-                        VLOG_LP(log_trace) << "exit writer annex mode because the result set is closed by the client";
-                        break;
-                    }
+                    current_annex = queue_.front().get();
                 }
-                {
-                    std::unique_lock<std::mutex> lock(mtx_queue_);
-
-                    queue_.pop();
+                auto rv = current_annex->transfer(shm_resultset_wire_, released, envelope_.is_closed());
+                if (rv == annex::transfer_result::idle || rv == annex::transfer_result::stalled) {
+                    return rv == annex::transfer_result::idle ? annex_writer_pool::task::state::idle : annex_writer_pool::task::state::stalled;
+                }
+                std::unique_lock<std::mutex> lock(mtx_queue_);
+                if (rv == annex::transfer_result::closed) {
+                    VLOG_LP(log_trace) << "exit writer annex mode because the result set is closed by the client";
+                    discarded_.store(true);
+                    std::queue<std::unique_ptr<annex>>().swap(queue_);
+                    break;
                 }
+                queue_.pop();
             }
             std::atomic_thread_fence(std::memory_order_acq_rel);
             thread_active_ = false;
+            envelope_.shm_resultset_wires_->bump_retire_counter();  // may have become disposable
+            return annex_writer_pool::task::state::finished;
         }
         void write(char const* data, std::size_t length) override {
             current_record_size += length;
@@ -194,14 +249,14 @@ public:
                     return;
                 }
                 VLOG_LP(log_trace) << "enter writer annex mode";
+                shm_resultset_wire_->publish();  // the records sealed so far precede the ones in the annex
                 annex_mode_ = true;
-                queue_.emplace(std::make_unique<annex>(datachannel_buffer_size_));
-                if (!thread_invoked_) {
-                    thread_active_ = true;
-                    writer_thread_ = std::thread(std::ref(*this));
-                    std::atomic_thread_fence(std::memory_order_acq_rel);
-                    thread_invoked_ = true;
-                }
+                thread_active_ = true;
+                queue_.emplace(std::make_unique<annex>(datachannel_buffer_size_, annex_session_));
+                task_ = std::make_shared<annex_writer_pool::task>([this]{ return transfer(); });
+            }
+            if (discarded_.load()) {
+                return;
             }
             {
                 std::unique_lock<std::mutex> lock(mtx_queue_);
@@ -214,25 +269,36 @@ public:
                     }
                 }
                 VLOG_LP(log_trace) << "extend annex";
-                queue_.emplace(std::make_unique<annex>(datachannel_buffer_size_));
-                cnd_queue_.notify_one();
+                queue_.emplace(std::make_unique<annex>(datachannel_buffer_size_, annex_session_));
                 auto* current_annex = queue_.back().get();
                 current_annex->write(data, length);
             }
+            annex_session_->pool().schedule(task_);  // let the full annex be transferred
         }
         void flush() override {
+            seal();
+            if (!annex_mode_) {
+                shm_resultset_wire_->publish();
+                return;
+            }
+            if (discarded_.load()) {
+                return;
+            }
+            annex_session_->pool().schedule(task_);
+        }
+        void seal() override {
             current_record_size = 0;
             if (!annex_mode_) {
-                shm_resultset_wire_->flush();
+                shm_resultset_wire_->seal();
                 return;
             }
-            {
-                std::unique_lock<std::mutex> lock(mtx_queue_);
-
-                if (!queue_.empty()) {
-                    auto* current_annex = queue_.back().get();
-                    current_annex->flush();
-                }
+            if (discarded_.load()) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mtx_queue_);
+            if (!queue_.empty()) {
+                auto* current_annex = queue_.back().get();
+                current_annex->flush();
             }
         }
         void release(unq_p_resultset_wire_conteiner resultset_wire) override;
@@ -241,16 +307,16 @@ public:
     private:
         tateyama::common::wire::shm_resultset_wire* shm_resultset_wire_;
         resultset_wires_container_impl &envelope_;
+        std::shared_ptr<annex_writer_pool::session> annex_session_;
 
         std::queue<std::unique_ptr<annex>> queue_{};
-        std::thread writer_thread_{};
+        std::shared_ptr<annex_writer_pool::task> task_{};
         bool annex_mode_{};
-        std::atomic_bool thread_invoked_{};
         std::atomic_bool thread_active_{};
+        std::atomic_bool discarded_{};
         bool released_{};
 
         mutable std::mutex mtx_queue_{};
-        mutable std::condition_variable cnd_queue_{};
 
         std::size_t datachannel_buffer_size_;
         std::size_t current_record_size{};
@@ -265,15 +331,19 @@ public:
     class resultset_wires_container_impl : public resultset_wires_container {
     public:
         //   for server
-        resultset_wires_container_impl(boost::interprocess::managed_shared_memory* managed_shm_ptr, std::string_view name, std::size_t count, std::mutex& mtx_shm, std::size_t datachannel_buffer_size)
-            : managed_shm_ptr_(managed_shm_ptr), rsw_name_(name), server_(true), mtx_shm_(mtx_shm), datachannel_buffer_size_(datachannel_buffer_size) {
+        resultset_wires_container_impl(boost::interprocess::managed_shared_memory* managed_shm_ptr, std::string_view name, std::size_t count, std::mutex& mtx_shm, std::size_t datachannel_buffer_size, std::shared_ptr<resultset_buffer_pool::session> buffer_session, std::shared_ptr<annex_writer_pool::session> annex_session, std::atomic_uint64_t* retire_counter = nullptr)
+            : managed_shm_ptr_(managed_shm_ptr), rsw_name_(name), server_(true), mtx_shm_(mtx_shm), datachannel_buffer_size_(datachannel_buffer_size), buffer_session_(std::move(buffer_session)), annex_session_(std::move(annex_session)) {
+            acquire_buffer();
             std::lock_guard<std::mutex> lock(mtx_shm_);
             managed_shm_ptr_->destroy<tateyama::common::wire::shm_resultset_wires>(rsw_name_.c_str());
             try {
                 shm_resultset_wires_ = managed_shm_ptr_->construct<tateyama::common::wire::shm_resultset_wires>(rsw_name_.c_str())(managed_shm_ptr_, count, datachannel_buffer_size_);
+                shm_resultset_wires_->set_retire_counter(retire_counter);
             } catch(const boost::interprocess::interprocess_exception& ex) {
+                release_buffers();
                 throw std::runtime_error(ex.what());
             } catch (std::exception &ex) {
+                release_buffers();
                 LOG_LP(ERROR) << "running out of boost managed shared memory";
                 throw ex;
             }
@@ -296,6 +366,7 @@ public:
             } catch (std::exception& e) {
                 LOG_LP(WARNING) << e.what();
             }
+            release_buffers();
         }
 
         /**
@@ -308,6 +379,9 @@ public:
 
         unq_p_resultset_wire_conteiner acquire() override {
             std::lock_guard<std::mutex> lock(mtx_shm_);
+            if (writers_.load() >= buffers_held_) {
+                acquire_buffer();  // the first writer uses the buffer reserved on construction
+            }
             try {
                 auto rv = std::unique_ptr<resultset_wire_container_impl, resultset_wire_deleter_type>{
                     new resultset_wire_container_impl{shm_resultset_wires_->acquire(), *this, datachannel_buffer_size_}, resultset_wire_deleter_impl};
@@ -356,14 +430,14 @@ public:
         }
 
         // for client
-        std::string_view get_chunk() {
+        std::string_view get_chunk(std::int64_t timeout_us = 0) {
             if (wrap_around_.data()) {
                 auto rv = wrap_around_;
                 wrap_around_ = std::string_view();
                 return rv;
             }
             if (current_wire_ == nullptr) {
-                current_wire_ = active_wire();
+                current_wire_ = active_wire(timeout_us);
             }
             if (current_wire_ != nullptr) {
                 return current_wire_->get_chunk(current_wire_->get_bip_address(managed_shm_ptr_), wrap_around_);
@@ -391,14 +465,36 @@ public:
         std::mutex& mtx_shm_;
         std::size_t datachannel_buffer_size_;
 
+        std::shared_ptr<resultset_buffer_pool::session> buffer_session_{};
+        std::size_t buffers_held_{};
+        std::shared_ptr<annex_writer_pool::session> annex_session_{};
+
         std::set<unq_p_resultset_wire_conteiner> released_writers_{};
         std::atomic_ulong writers_{};
         std::atomic_ulong completed_writers_{};
         std::atomic_bool eor_{};
         std::atomic_flag notify_eor_{};
         mutable std::mutex mtx_released_writers_{};
+        resultset_wires_container_impl* next_garbage_{};  // used by garbage_collector_impl
         
         friend class resultset_wire_container_impl;
+        friend class garbage_collector_impl;
+
+        void acquire_buffer() {
+            if (buffer_session_) {
+                if (!buffer_session_->acquire()) {
+                    LOG_LP(ERROR) << "running out of the result set buffers, " << buffer_session_->held() << " buffers are used by the session";
+                    throw std::runtime_error("running out of the result set buffers");
+                }
+            }
+            buffers_held_++;
+        }
+        void release_buffers() noexcept {
+            if (buffer_session_) {
+                buffer_session_->release(buffers_held_);
+            }
+            buffers_held_ = 0;
+        }
 
         void notify_eor_conditional() {
             if ((writers_.load() == completed_writers_.load()) && eor_.load()) {
@@ -412,21 +508,30 @@ public:
         std::string_view wrap_around_{};
         tateyama::common::wire::shm_resultset_wire* current_wire_{};
 
-        tateyama::common::wire::shm_resultset_wire* active_wire() {
-            return shm_resultset_wires_->active_wire();
+        tateyama::common::wire::shm_resultset_wire* active_wire(std::int64_t timeout_us) {
+            return shm_resultset_wires_->active_wire(timeout_us);
         }
     };
     static void resultset_deleter_impl(resultset_wires_container* resultset) {
         delete dynamic_cast<resultset_wires_container_impl*>(resultset);  // NOLINT
     }
 
+    /**
+     * @brief the retire list of the result set wires released by the sql service.
+     *  put() pushes the wires onto a lock-free intrusive stack, and dump() sweeps the list only when the retire counter
+     *  shows that some result set has been closed by the client or has become disposable since the last sweep,
+     *  so that dump() called after every request costs O(1) while no result set is closed.
+     */
     class garbage_collector_impl : public garbage_collector
     {
     public:
         garbage_collector_impl() = default;
         ~garbage_collector_impl() override {
-            std::lock_guard<std::mutex> lock(mtx_put_);
-            resultset_wires_set_.clear();
+            std::lock_guard<std::mutex> lock(mtx_dump_);
+            collect_incoming();
+            while (retired_ != nullptr) {
+                retire(std::exchange(retired_, retired_->next_garbage_));
+            }
         }
 
         /**
@@ -437,47 +542,93 @@ public:
         garbage_collector_impl& operator = (garbage_collector_impl const&) = delete;
         garbage_collector_impl& operator = (garbage_collector_impl&&) = delete;
 
+        /**
+         * @brief attach the retire counter placed in the shared memory of the session
+         */
+        void attach(std::atomic_uint64_t* retire_counter) noexcept {
+            retire_counter_ = retire_counter;
+        }
+
         void put(unq_p_resultset_wires_conteiner wires) override {
-            std::lock_guard<std::mutex> lock(mtx_put_);
-            if (force_close_) {
-                wires->force_close();
+            auto* garbage = dynamic_cast<resultset_wires_container_impl*>(wires.release());
+            if (force_close_.load()) {
+                garbage->force_close();
+            }
+            size_.fetch_add(1);
+            auto* head = incoming_.load();
+            do {
+                garbage->next_garbage_ = head;
+            } while (!incoming_.compare_exchange_weak(head, garbage));
+            if (force_close_.load()) {  // force_close() may have missed the wires pushed above
+                std::lock_guard<std::mutex> lock(mtx_dump_);
+                collect_incoming();
+                force_close_retired();
             }
-            resultset_wires_set_.emplace(std::move(wires));
         }
         void dump() override {
-            if (!force_close_) {
-                if (mtx_dump_.try_lock()) {
-                    std::lock_guard<std::mutex> lock(mtx_put_);
-
-                    auto it = resultset_wires_set_.begin();
-                    while (it != resultset_wires_set_.end()) {
-                        if ((*it)->is_closed() && (*it)->is_disposable()) {
-                            resultset_wires_set_.erase(it++);
-                        } else {
-                            it++;
-                        }
+            if (force_close_.load()) {
+                return;
+            }
+            auto counter = retire_counter_ != nullptr ? retire_counter_->load() : swept_counter_.load() + 1;
+            if (counter == swept_counter_.load() && incoming_.load() == nullptr) {
+                return;
+            }
+            if (mtx_dump_.try_lock()) {
+                std::lock_guard<std::mutex> lock(mtx_dump_, std::adopt_lock);
+
+                swept_counter_.store(counter);  // a result set closed during the sweep bumps the counter again
+                collect_incoming();
+                resultset_wires_container_impl** prev = &retired_;
+                while (*prev != nullptr) {
+                    auto* wires = *prev;
+                    if (wires->is_closed() && wires->is_disposable()) {
+                        *prev = wires->next_garbage_;
+                        retire(wires);
+                    } else {
+                        prev = &wires->next_garbage_;
                     }
-                    mtx_dump_.unlock();
                 }
             }
         }
         bool empty() override {
-            std::lock_guard<std::mutex> lock(mtx_put_);
-            return resultset_wires_set_.empty() || force_close_;
+            return size_.load() == 0 || force_close_.load();
         }
         void force_close() override {
-            std::lock_guard<std::mutex> lock(mtx_put_);
-            for (const auto& it : resultset_wires_set_) {
-                it->force_close();
-            }
-            force_close_ = true;
+            force_close_.store(true);
+            std::lock_guard<std::mutex> lock(mtx_dump_);
+            collect_incoming();
+            force_close_retired();
         }
 
     private:
-        std::set<unq_p_resultset_wires_conteiner> resultset_wires_set_{};
-        bool force_close_{};
-        mutable std::mutex mtx_put_{};
+        std::atomic<resultset_wires_container_impl*> incoming_{};
+        resultset_wires_container_impl* retired_{};  // guarded by mtx_dump_
+        std::atomic_size_t size_{};
+        std::atomic_uint64_t* retire_counter_{};
+        std::atomic_uint64_t swept_counter_{};
+        std::atomic_bool force_close_{};
         mutable std::mutex mtx_dump_{};
+
+        // move the wires pushed by put() to the retired_ list, assumes caller holds mtx_dump_
+        void collect_incoming() {
+            auto* wires = incoming_.exchange(nullptr);
+            while (wires != nullptr) {
+                auto* next = wires->next_garbage_;
+                wires->next_garbage_ = retired_;
+                retired_ = wires;
+                wires = next;
+            }
+        }
+        // assumes caller holds mtx_dump_
+        void force_close_retired() {
+            for (auto* wires = retired_; wires != nullptr; wires = wires->next_garbage_) {
+                wires->force_close();
+            }
+        }
+        void retire(resultset_wires_container_impl* wires) {
+            resultset_deleter_impl(wires);
+            size_.fetch_sub(1);
+        }
     };
 
 
@@ -497,6 +648,10 @@ public:
         tateyama::common::wire::message_header peep() {
             return wire_->peep(bip_buffer_);
         }
+        [[nodiscard]] bool has_request() const { return wire_->has_request(); }
+        void enable_doorbell(std::size_t slot) { wire_->enable_doorbell(slot); }
+        [[nodiscard]] bool doorbell_attached() const { return wire_->doorbell_attached(); }
+        void disarm_doorbell() { wire_->disarm_doorbell(); }
         std::string_view payload() override {
             return wire_->payload(bip_buffer_);
         }
@@ -526,11 +681,22 @@ public:
         response_wire_container_impl& operator = (response_wire_container_impl const&) = delete;
         response_wire_container_impl& operator = (response_wire_container_impl&&) = delete;
 
-        void initialize(tateyama::common::wire::unidirectional_response_wire* wire, char* bip_buffer) {
+        void initialize(tateyama::common::wire::unidirectional_response_wire* wire, char* bip_buffer, boost::interprocess::managed_shared_memory* managed_shm_ptr, std::mutex* mtx_shm) {
             wire_ = wire;
             bip_buffer_ = bip_buffer;
+            managed_shm_ptr_ = managed_shm_ptr;
+            mtx_shm_ = mtx_shm;
         }
         void write(const char* from, tateyama::common::wire::response_header header, bool blockable) override {
+            try_swap();
+            if (!thread_active_) {
+                std::size_t position{};
+                if (wire_->try_reserve(header.get_length(), position)) {
+                    wire_->write_reserved(bip_buffer_, position, from, header.get_length());
+                    wire_->commit(bip_buffer_, position, header);
+                    return;
+                }
+            }
             if (thread_active_) {
                 std::lock_guard<std::mutex> lock(thread_mtx_);
                 if (thread_active_) {
@@ -540,10 +706,14 @@ public:
             }
             {
                 std::lock_guard<std::mutex> lock(write_mtx_);
-                if (blockable || wire_->is_writable(header)) {
+                if (blockable) {
+                    grow(header);
                     wire_->write(bip_buffer_, from, header);
                     return;
                 }
+                if (wire_->try_write(bip_buffer_, from, header)) {  // not to wait for the writers filling the regions reserved
+                    return;
+                }
             }
             {
                 std::lock_guard<std::mutex> lock(thread_mtx_);
@@ -554,6 +724,30 @@ public:
                 thread_active_ = true;
             }
         }
+        /**
+         * @brief write the response message serialized by the serializer,
+         *  directly into the response wire unless the message must be queued or wraps around the ring buffer.
+         *  Writers that find enough room reserve their region without taking write_mtx_,
+         *  and nothing that can throw but the serializer runs between the reservation and its commit.
+         * @param header the header of the response message
+         * @param serializer the function that serializes the response message of header.get_length() bytes
+         * @param blockable true if the caller is allowed to wait for the room in the response wire
+         */
+        void write(tateyama::common::wire::response_header header, const std::function<void(char*)>& serializer, bool blockable) override {
+            try_swap();
+            if (!thread_active_) {
+                std::size_t position{};
+                if (wire_->try_reserve(header.get_length(), position, true)) {
+                    tateyama::common::wire::unidirectional_response_wire::reservation reservation{wire_, bip_buffer_, position, header};
+                    serializer(wire_->reserved_address(bip_buffer_, position, header.get_length()));
+                    reservation.commit();
+                    return;
+                }
+            }
+            std::string message(header.get_length(), '\0');  // allocated before reserving the region, including the wrap around case
+            serializer(message.data());
+            write(message.data(), header, blockable);
+        }
         void operator()() {
             while (true) {
                 std::string r{};
@@ -572,6 +766,7 @@ public:
                 }
                 {
                     std::lock_guard<std::mutex> lock(write_mtx_);
+                    grow(h);
                     wire_->write(bip_buffer_, r.data(), h);
                 }
             }
@@ -580,6 +775,65 @@ public:
         void notify_shutdown() override {
             wire_->notify_shutdown();
         }
+
+        /**
+         * @brief prepare the larger response buffer when the messages repeatedly do not fit the room of the response buffer,
+         *  which replaces the current one once the response wire becomes empty, called under write_mtx_.
+         *  The writers keep using the current buffer until then, so the message is sent in pieces if it is larger than the buffer.
+         * @param header the header of the response message to be written
+         */
+        void grow(tateyama::common::wire::response_header header) {
+            if (pending_buffer_ != nullptr) {
+                swap_pending();
+                return;
+            }
+            std::size_t capacity = wire_->capacity();
+            if (wire_->is_writable(header) || capacity >= max_response_buffer_size || managed_shm_ptr_ == nullptr) {
+                return;
+            }
+            high_water_length_ = std::max(high_water_length_, tateyama::common::wire::response_header::size + header.get_length());
+            if (++high_water_hits_ < response_buffer_grow_threshold) {
+                return;
+            }
+            capacity *= 2;  // a multiple of the current capacity, as try_grow() requires
+            while (capacity < high_water_length_ && capacity < max_response_buffer_size) {
+                capacity *= 2;
+            }
+            high_water_hits_ = 0;
+            high_water_length_ = 0;
+            {
+                std::lock_guard<std::mutex> lock(*mtx_shm_);
+                pending_buffer_ = static_cast<char*>(managed_shm_ptr_->allocate_aligned(capacity, tateyama::common::wire::simple_wire<tateyama::common::wire::response_header>::Alignment, std::nothrow));
+            }
+            if (pending_buffer_ == nullptr) {
+                VLOG_LP(log_debug) << "cannot grow the response buffer to " << capacity << " bytes, the messages are sent in pieces";
+                return;  // the messages are sent in pieces with the current buffer
+            }
+            pending_capacity_ = capacity;
+            grow_pending_.store(true);
+            swap_pending();
+        }
+        // replace the response buffer with the one prepared by grow() if the response wire is empty, called under write_mtx_
+        void swap_pending() {
+            if (auto* old_buffer = wire_->try_grow(bip_buffer_, pending_buffer_, pending_capacity_); old_buffer != nullptr) {
+                {
+                    std::lock_guard<std::mutex> lock(*mtx_shm_);
+                    managed_shm_ptr_->deallocate(old_buffer);
+                }
+                pending_buffer_ = nullptr;
+                grow_pending_.store(false);
+                VLOG_LP(log_trace) << "the response buffer has grown to " << pending_capacity_ << " bytes";
+            }
+        }
+        // give the buffer prepared by grow() a chance to replace the current one, without waiting for the other writers
+        void try_swap() {
+            if (grow_pending_.load()) {
+                std::unique_lock<std::mutex> lock(write_mtx_, std::try_to_lock);
+                if (lock.owns_lock() && pending_buffer_ != nullptr) {
+                    swap_pending();
+                }
+            }
+        }
         void force_close() {
             wire_->force_close();
         }
@@ -603,19 +857,31 @@ public:
         void close() {
             wire_->close();
         }
+        [[nodiscard]] std::size_t capacity() const {
+            return wire_->capacity();
+        }
 
     private:
         tateyama::common::wire::unidirectional_response_wire* wire_{};
         char* bip_buffer_{};
+        boost::interprocess::managed_shared_memory* managed_shm_ptr_{};
+        std::mutex* mtx_shm_{};
         mutable std::mutex write_mtx_{};
         mutable std::mutex thread_mtx_{};
         std::thread writer_thread_{};
         std::queue<std::pair<std::string, tateyama::common::wire::response_header>> responses_{};
         std::atomic_bool thread_active_{};
+
+        // the members for growing the response buffer, guarded by write_mtx_ except grow_pending_
+        std::size_t high_water_hits_{};
+        std::size_t high_water_length_{};
+        char* pending_buffer_{};
+        std::size_t pending_capacity_{};
+        std::atomic_bool grow_pending_{};
     };
 
-    server_wire_container_impl(std::string_view name, std::string_view mutex_file, std::size_t datachannel_buffer_size, std::size_t max_datachannel_buffers, std::function<void(void)> clean_up)
-        : name_(name), garbage_collector_impl_(std::make_unique<garbage_collector_impl>()), datachannel_buffer_size_(datachannel_buffer_size), clean_up_(std::move(clean_up)) {
+    server_wire_container_impl(std::string_view name, std::string_view mutex_file, std::size_t datachannel_buffer_size, std::size_t max_datachannel_buffers, std::function<void(void)> clean_up, std::shared_ptr<resultset_buffer_pool> buffer_pool = nullptr, std::shared_ptr<annex_writer_pool> annex_pool = nullptr)
+        : name_(name), buffer_session_(std::make_shared<resultset_buffer_pool::session>(std::move(buffer_pool))), annex_session_(std::make_shared<annex_writer_pool::session>(annex_pool ? std::move(annex_pool) : annex_writer_pool::default_pool())), garbage_collector_impl_(std::make_unique<garbage_collector_impl>()), datachannel_buffer_size_(datachannel_buffer_size), clean_up_(std::move(clean_up)) {
         boost::interprocess::shared_memory_object::remove(name_.c_str());
         try {
             boost::interprocess::permissions unrestricted_permissions;
@@ -624,12 +890,15 @@ public:
             std::size_t shared_memory_size = proportional_memory_size(datachannel_buffer_size_, max_datachannel_buffers);
             managed_shared_memory_ =
                 std::make_unique<boost::interprocess::managed_shared_memory>(boost::interprocess::create_only, name_.c_str(), shared_memory_size, nullptr, unrestricted_permissions);
+            managed_shared_memory_->construct<std::uint32_t>(tateyama::common::wire::wire_layout_name)(tateyama::common::wire::wire_layout_version);
             auto req_wire = managed_shared_memory_->construct<tateyama::common::wire::unidirectional_message_wire>(tateyama::common::wire::request_wire_name)(managed_shared_memory_.get(), request_buffer_size);
             auto res_wire = managed_shared_memory_->construct<tateyama::common::wire::unidirectional_response_wire>(tateyama::common::wire::response_wire_name)(managed_shared_memory_.get(), response_buffer_size);
             status_provider_ = managed_shared_memory_->construct<tateyama::common::wire::status_provider>(tateyama::common::wire::status_provider_name)(managed_shared_memory_.get(), mutex_file);
+            retire_counter_ = managed_shared_memory_->construct<std::atomic_uint64_t>(tateyama::common::wire::retire_counter_name)(0);
+            garbage_collector_impl_->attach(retire_counter_);
 
             request_wire_.initialize(req_wire, req_wire->get_bip_address(managed_shared_memory_.get()));
-            response_wire_.initialize(res_wire, res_wire->get_bip_address(managed_shared_memory_.get()));
+            response_wire_.initialize(res_wire, res_wire->get_bip_address(managed_shared_memory_.get()), managed_shared_memory_.get(), &mtx_shm_);
             VLOG_LP(log_trace) << "create " << shared_memory_size << " byte of shred memory for the session, free space remaining is " << managed_shared_memory_->get_free_memory() << " byte.";
         } catch(const boost::interprocess::interprocess_exception& ex) {
             std::stringstream ss{};
@@ -662,7 +931,7 @@ public:
     unq_p_resultset_wires_conteiner create_resultset_wires(std::string_view name, std::size_t count) override {
         try {
             return std::unique_ptr<resultset_wires_container_impl, resultset_deleter_type>{
-                new resultset_wires_container_impl{managed_shared_memory_.get(), name, count, mtx_shm_, datachannel_buffer_size_}, resultset_deleter_impl};
+                new resultset_wires_container_impl{managed_shared_memory_.get(), name, count, mtx_shm_, datachannel_buffer_size_, buffer_session_, annex_session_, retire_counter_}, resultset_deleter_impl};
         }
         catch(const boost::interprocess::interprocess_exception& ex) {
             LOG_LP(ERROR) << "running out of boost managed shared memory";
@@ -673,8 +942,21 @@ public:
         return garbage_collector_impl_.get();
     }
 
+    /**
+     * @brief returns the number of result set buffers held by this session
+     */
+    [[nodiscard]] std::size_t resultset_buffers() const noexcept {
+        return buffer_session_->held();
+    }
+
+    static std::size_t resultset_buffer_size(std::size_t datachannel_buffer_size) {
+        return datachannel_buffer_size + data_channel_overhead;
+    }
+    // the response buffer grows only while it is smaller than max_response_buffer_size, so the current buffer (at most a half of
+    // max_response_buffer_size) and the one prepared by grow() (at most max_response_buffer_size) coexist until they are swapped.
+    // The pages of /dev/shm are not charged until the response buffer actually grows.
     static std::size_t proportional_memory_size(std::size_t datachannel_buffer_size, std::size_t max_datachannel_buffers) {
-        return (datachannel_buffer_size + data_channel_overhead) * max_datachannel_buffers + (request_buffer_size + response_buffer_size) + total_overhead;
+        return (datachannel_buffer_size + data_channel_overhead) * max_datachannel_buffers + (request_buffer_size + response_buffer_size + max_response_buffer_size + max_response_buffer_size / 2) + total_overhead;
     }
 
     /**
@@ -685,6 +967,14 @@ public:
         garbage_collector_impl_->force_close();
     }
 
+    /**
+     * @brief let the client ring the doorbell of the connection_queue on request arrival
+     * @param slot the slot index of this session
+     */
+    void enable_doorbell(std::size_t slot) {
+        request_wire_.enable_doorbell(slot);
+    }
+
     // for client
     std::unique_ptr<resultset_wires_container_impl> create_resultset_wires_for_client(std::string_view name) {
         return std::make_unique<resultset_wires_container_impl>(managed_shared_memory_.get(), name, mtx_shm_);
@@ -696,6 +986,9 @@ private:
     wire_container_impl request_wire_{};
     response_wire_container_impl response_wire_{};
     tateyama::common::wire::status_provider* status_provider_{};
+    std::atomic_uint64_t* retire_counter_{};
+    std::shared_ptr<resultset_buffer_pool::session> buffer_session_;
+    std::shared_ptr<annex_writer_pool::session> annex_session_;
     std::unique_ptr<garbage_collector_impl> garbage_collector_impl_;
     mutable std::mutex mtx_shm_{};
 
@@ -705,15 +998,13 @@ private:
 
 inline void server_wire_container_impl::resultset_wire_container_impl::release(unq_p_resultset_wire_conteiner resultset_wire_conteiner) {
     envelope_.add_released_writer(std::move(resultset_wire_conteiner));
-    if (thread_invoked_) {
-        std::unique_lock<std::mutex> lock(mtx_queue_);
+    if (task_) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_queue_);
 
-        released_ = true;
-        cnd_queue_.notify_one();
-        if (!queue_.empty()) {
-            auto* current_annex = queue_.back().get();
-            current_annex->notify();
+            released_ = true;
         }
+        annex_session_->pool().schedule(task_);
     } else {
         envelope_.write_complete();
     }
@@ -725,16 +1016,32 @@ inline void server_wire_container_impl::resultset_wire_container_impl::write_com
 class connection_container
 {
 public:
-    explicit connection_container(std::string_view name, std::size_t threads, std::size_t admin_sessions) : name_(name) {
+    /**
+     * @brief the number of the admin channel entries per admin session
+     */
+    static constexpr std::size_t admin_channel_entries_per_session = 4;
+
+    /**
+     * @brief construct the connection container
+     * @param admin_channel_buffer_size the buffer size of each admin channel entry, 0 means that no admin channel is provided
+     */
+    explicit connection_container(std::string_view name, std::size_t threads, std::size_t admin_sessions, std::size_t admin_channel_buffer_size = 0) : name_(name) {
+        std::size_t admin_channel_entries = admin_channel_buffer_size > 0 ? admin_sessions * admin_channel_entries_per_session : 0;
         boost::interprocess::shared_memory_object::remove(name_.c_str());
         try {
             boost::interprocess::permissions  unrestricted_permissions;
             unrestricted_permissions.set_unrestricted();
 
             managed_shared_memory_ =
-                std::make_unique<boost::interprocess::managed_shared_memory>(boost::interprocess::create_only, name_.c_str(), fixed_memory_size(threads + admin_sessions), nullptr, unrestricted_permissions);
+                std::make_unique<boost::interprocess::managed_shared_memory>(boost::interprocess::create_only, name_.c_str(), fixed_memory_size(threads + admin_sessions, admin_channel_entries, admin_channel_buffer_size), nullptr, unrestricted_permissions);
             managed_shared_memory_->destroy<tateyama::common::wire::connection_queue>(tateyama::common::wire::connection_queue::name);
             connection_queue_ = managed_shared_memory_->construct<tateyama::common::wire::connection_queue>(tateyama::common::wire::connection_queue::name)(threads, managed_shared_memory_->get_segment_manager(), static_cast<std::uint8_t>(admin_sessions));
+            managed_shared_memory_->destroy<std::uint32_t>(tateyama::common::wire::connection_layout_name);
+            managed_shared_memory_->construct<std::uint32_t>(tateyama::common::wire::connection_layout_name)(tateyama::common::wire::connection_layout_version);
+            if (admin_channel_entries > 0) {
+                managed_shared_memory_->destroy<tateyama::common::wire::admin_channel>(tateyama::common::wire::admin_channel::name);
+                admin_channel_ = managed_shared_memory_->construct<tateyama::common::wire::admin_channel>(tateyama::common::wire::admin_channel::name)(admin_channel_entries, admin_channel_buffer_size, managed_shared_memory_->get_segment_manager());
+            }
         }
         catch(const boost::interprocess::interprocess_exception& ex) {
             using namespace std::literals::string_view_literals;
@@ -759,6 +1066,12 @@ public:
     tateyama::common::wire::connection_queue& get_connection_queue() {
         return *connection_queue_;
     }
+    /**
+     * @brief returns the admin channel, or nullptr if no admin channel is provided
+     */
+    tateyama::common::wire::admin_channel* get_admin_channel() noexcept {
+        return admin_channel_;
+    }
 
     // for diagnostic
     [[nodiscard]] std::size_t pending_requests() const {
@@ -768,8 +1081,11 @@ public:
         return connection_queue_->session_id_accepted();
     }
 
-    static std::size_t fixed_memory_size(std::size_t n) {
+    static std::size_t fixed_memory_size(std::size_t n, std::size_t admin_channel_entries = 0, std::size_t admin_channel_buffer_size = 0) {
         std::size_t size = initial_size + (n * per_size); // exact size
+        if (admin_channel_entries > 0) {
+            size += tateyama::common::wire::admin_channel::memory_size(admin_channel_entries, admin_channel_buffer_size);
+        }
         size += initial_size / 2;                         // a little bit of leeway
         return ((size / 4096) + 1) * 4096;                // round up to the page size
     }
@@ -778,9 +1094,10 @@ private:
     std::string name_;
     std::unique_ptr<boost::interprocess::managed_shared_memory> managed_shared_memory_{};
     tateyama::common::wire::connection_queue* connection_queue_;
+    tateyama::common::wire::admin_channel* admin_channel_{};
 
-    static constexpr std::size_t initial_size = 720;      // obtained by experiment
-    static constexpr std::size_t per_size = 112;          // obtained by experiment
+    static constexpr std::size_t initial_size = 848;      // obtained by experiment
+    static constexpr std::size_t per_size = 128;          // obtained by experiment
 };
 
 };  // namespace tateyama::common::wire
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace tateyama::endpoint::ipc::bootstrap {
+
+/**
+ * @brief a pool of threads setting up the sessions requested through the connection queue,
+ *  so that the listener can take the next connection request while the preceding sessions are being set up.
+ *  The pool also keeps the statistics of the accept latency, the time from the connection request by the client
+ *  to the accept by the server.
+ */
+class session_setup_pool {
+public:
+    /**
+     * @brief the default number of threads
+     */
+    static constexpr std::size_t default_threads = 4;
+
+    /**
+     * @brief construct the pool
+     * @param threads the number of threads, 0 means that the session is set up by the caller of submit()
+     */
+    explicit session_setup_pool(std::size_t threads) noexcept : threads_size_(threads) {
+    }
+    ~session_setup_pool() {
+        stop();
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    session_setup_pool(session_setup_pool const&) = delete;
+    session_setup_pool(session_setup_pool&&) = delete;
+    session_setup_pool& operator = (session_setup_pool const&) = delete;
+    session_setup_pool& operator = (session_setup_pool&&) = delete;
+
+    /**
+     * @brief set up a session by a thread of the pool
+     * @param job the function setting up the session
+     */
+    void submit(std::function<void()> job) {
+        if (threads_size_ == 0) {
+            job();
+            return;
+        }
+        std::call_once(start_, [this]{
+            for (std::size_t i = 0; i < threads_size_; i++) {
+                threads_.emplace_back([this]{ operator()(); });
+            }
+        });
+        std::lock_guard<std::mutex> lock(mtx_);
+        jobs_.emplace_back(std::move(job));
+        cnd_.notify_one();
+    }
+
+    /**
+     * @brief wait for the sessions submitted to be set up, and stop the threads
+     */
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stop_ = true;
+            cnd_.notify_all();
+        }
+        for (auto&& t : threads_) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    /**
+     * @brief record the accept latency of a session
+     * @param latency the accept latency in microseconds
+     */
+    void record_accept(std::int64_t latency) noexcept {
+        accepted_.fetch_add(1);
+        latency_total_.fetch_add(latency);
+        auto max = latency_max_.load();
+        while (max < latency) {
+            if (latency_max_.compare_exchange_weak(max, latency)) {
+                break;
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t threads() const noexcept { return threads_size_; }
+    [[nodiscard]] std::size_t accepted() const noexcept { return accepted_.load(); }
+    [[nodiscard]] std::int64_t accept_latency_max() const noexcept { return latency_max_.load(); }
+    [[nodiscard]] double accept_latency_average() const noexcept {
+        auto accepted = accepted_.load();
+        return accepted > 0 ? static_cast<double>(latency_total_.load()) / static_cast<double>(accepted) : 0.0;
+    }
+    [[nodiscard]] std::size_t pending() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return jobs_.size();
+    }
+
+private:
+    const std::size_t threads_size_;
+    std::vector<std::thread> threads_{};
+    std::once_flag start_{};
+
+    std::deque<std::function<void()>> jobs_{};
+    bool stop_{};
+    mutable std::mutex mtx_{};
+    std::condition_variable cnd_{};
+
+    std::atomic_size_t accepted_{};
+    std::atomic_int64_t latency_total_{};
+    std::atomic_int64_t latency_max_{};
+
+    void operator()() {
+        pthread_setname_np(pthread_self(), "ipc_setup");
+        while (true) {
+            std::function<void()> job{};
+            {
+                std::unique_lock<std::mutex> lock(mtx_);
+                cnd_.wait(lock, [this]{ return stop_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    return;  // stop_ is set and no job remains
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            job();
+        }
+    }
+};
+
+}
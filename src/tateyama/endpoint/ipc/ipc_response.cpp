@@ -36,16 +36,13 @@ tateyama::status ipc_response::body(std::string_view body) {
             data_channel_ = nullptr;
         }
 
-        std::stringstream ss{};
         endpoint::common::header_content arg{};
         arg.session_id_ = session_id_;
         arg.blobs_ = &blobs_;
-        if(auto res = endpoint::common::append_response_header(ss, body, arg, ::tateyama::proto::framework::response::Header::SERVICE_RESULT); ! res) {
+        if(! write_response(endpoint::common::response_message(body, arg, ::tateyama::proto::framework::response::Header::SERVICE_RESULT), RESPONSE_BODY)) {
             LOG_LP(ERROR) << "error formatting response message";
             return status::unknown;
         }
-        auto s = ss.str();
-        server_wire_.get_response_wire().write(s.data(), tateyama::common::wire::response_header(index_, s.length(), RESPONSE_BODY), worker_ != std::this_thread::get_id());
         set_completed();
 
         // The following API is used to reflect the fact that a response has been returned for a request in the
@@ -69,15 +66,12 @@ tateyama::status ipc_response::body_head(std::string_view body_head) {
     }
     VLOG_LP(log_trace) << static_cast<const void*>(&server_wire_) << " slot = " << index_;  //NOLINT
 
-    std::stringstream ss{};
     endpoint::common::header_content arg{};
     arg.session_id_ = session_id_;
-    if(auto res = endpoint::common::append_response_header(ss, body_head, arg, ::tateyama::proto::framework::response::Header::SERVICE_RESULT); ! res) {
+    if(! write_response(endpoint::common::response_message(body_head, arg, ::tateyama::proto::framework::response::Header::SERVICE_RESULT), RESPONSE_BODYHEAD)) {
         LOG_LP(ERROR) << "error formatting response message";
         return status::unknown;
     }
-    auto s = ss.str();
-    server_wire_.get_response_wire().write(s.data(), tateyama::common::wire::response_header(index_, s.length(), RESPONSE_BODYHEAD), worker_ != std::this_thread::get_id());
     set_state(state::to_be_used);
     return tateyama::status::ok;
 }
@@ -108,15 +102,22 @@ void ipc_response::error(proto::diagnostics::Record const& record) {
 }
 
 void ipc_response::server_diagnostics(std::string_view diagnostic_record) {
-    std::stringstream ss{};
     endpoint::common::header_content arg{};
     arg.session_id_ = session_id_;
-    if(! endpoint::common::append_response_header(ss, diagnostic_record, arg, tateyama::proto::framework::response::Header::SERVER_DIAGNOSTICS)) {
+    if(! write_response(endpoint::common::response_message(diagnostic_record, arg, tateyama::proto::framework::response::Header::SERVER_DIAGNOSTICS), RESPONSE_BODY)) {
         LOG_LP(ERROR) << "error formatting response message";
-        return;
     }
-    auto s = ss.str();
-    server_wire_.get_response_wire().write(s.data(), tateyama::common::wire::response_header(index_, s.length(), RESPONSE_BODY), worker_ != std::this_thread::get_id());
+}
+
+// serialize the header and the body directly into the response wire, without intermediate copies
+bool ipc_response::write_response(const tateyama::endpoint::common::response_message& message, tateyama::common::wire::response_header::msg_type type) {
+    if (!message.valid()) {
+        return false;
+    }
+    server_wire_.get_response_wire().write(tateyama::common::wire::response_header(index_, message.size(), type),
+                                           [&message](char* out){ message.serialize_to(out); },
+                                           worker_ != std::this_thread::get_id());
+    return true;
 }
 
 tateyama::status ipc_response::acquire_channel(std::string_view name, std::shared_ptr<tateyama::api::server::data_channel>& ch, std::size_t max_writer_count) {
@@ -252,6 +253,29 @@ tateyama::status ipc_writer::commit() {
     return tateyama::status::ok;
 }
 
+tateyama::status ipc_writer::write_records(std::string_view const* records, std::size_t count) {
+    VLOG_LP(log_trace) << static_cast<const void*>(this) << " " << count << " records";  //NOLINT
+    if (released_.load()) {
+        LOG_LP(INFO) << "ipc_writer (" << static_cast<const void*>(this) << ") has already been released";  //NOLINT
+        return tateyama::status::unknown;
+    }
+
+    // seal each record and publish them by a flush, so that the client is notified once for the records
+    try {
+        for (std::size_t i = 0; i < count; i++) {
+            auto const& record = records[i];  // NOLINT
+            resultset_wire_->write(record.data(), record.length());
+            resultset_wire_->seal();
+        }
+        resultset_wire_->flush();
+        return tateyama::status::ok;
+    } catch (std::exception &ex) {
+        LOG_LP(ERROR) << ex.what();
+        resultset_wire_->flush();
+    }
+    return tateyama::status::unknown;
+}
+
 void ipc_writer::release() {
     released_.store(true);
     resultset_wire_->release(std::move(resultset_wire_));
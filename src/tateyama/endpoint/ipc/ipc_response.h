@@ -24,6 +24,7 @@
 
 #include "tateyama/endpoint/common/response.h"
 #include "tateyama/endpoint/common/pointer_comp.h"
+#include "tateyama/endpoint/common/endpoint_proto_utils.h"
 #include "server_wires.h"
 #include "ipc_request.h"
 
@@ -47,6 +48,7 @@ public:
 
     tateyama::status write(char const* data, std::size_t length) override;
     tateyama::status commit() override;
+    tateyama::status write_records(std::string_view const* records, std::size_t count) override;
 
 private:
     server_wire_container::unq_p_resultset_wire_conteiner resultset_wire_;
@@ -130,6 +132,7 @@ private:
     const std::thread::id worker_;
 
     void server_diagnostics(std::string_view diagnostic_record);
+    bool write_response(const tateyama::endpoint::common::response_message& message, tateyama::common::wire::response_header::msg_type type);
 };
 
 }  // tateyama::common::wire
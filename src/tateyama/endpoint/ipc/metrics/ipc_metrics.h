@@ -16,6 +16,8 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
+#include <functional>
 
 #include <tateyama/framework/resource.h>
 #include <tateyama/framework/environment.h>
@@ -23,6 +25,9 @@
 
 #include "tateyama/metrics/service/core.h"
 #include "tateyama/metrics/resource/bridge.h"
+#include "tateyama/endpoint/ipc/bootstrap/resultset_buffer_pool.h"
+#include "tateyama/endpoint/ipc/bootstrap/annex_writer_pool.h"
+#include "tateyama/endpoint/ipc/bootstrap/session_setup_pool.h"
 
 namespace tateyama::endpoint::ipc::bootstrap {
     class ipc_listener;
@@ -50,24 +55,40 @@ class ipc_metrics {
     // for ipc_memory
     class ipc_memory_aggregator : public tateyama::metrics::metrics_aggregator {
     public:
-        ipc_memory_aggregator(std::size_t fixed, std::size_t proportional)
-            : fixed_(static_cast<double>(fixed)), proportional_(static_cast<double>(proportional)) {
+        ipc_memory_aggregator(std::size_t fixed, std::size_t proportional, std::shared_ptr<bootstrap::resultset_buffer_pool> buffer_pool)
+            : fixed_(static_cast<double>(fixed)), proportional_(static_cast<double>(proportional)), buffer_pool_(std::move(buffer_pool)) {
         }
         ipc_memory_aggregator() = delete;
         void add(tateyama::metrics::metrics_metadata const&, double value) override {
             ipc_session_count_ = value;
         }
         result_type aggregate() override {
+            auto resultset_buffers = static_cast<double>(buffer_pool_->bytes_in_use());
             if(tateyama::metrics::service::ipc_correction) {
-                return fixed_ + (ipc_session_count_ - 1.0) * proportional_;
+                return fixed_ + (ipc_session_count_ - 1.0) * proportional_ + resultset_buffers;
             }
-            return fixed_ + ipc_session_count_ * proportional_;
+            return fixed_ + ipc_session_count_ * proportional_ + resultset_buffers;
         }
       private:
         double fixed_;
         double proportional_{};
+        std::shared_ptr<bootstrap::resultset_buffer_pool> buffer_pool_;
         double ipc_session_count_{};
     };
+    // for the aggregations reading the pools directly
+    class pool_aggregator : public tateyama::metrics::metrics_aggregator {
+    public:
+        explicit pool_aggregator(std::function<double(void)> value) : value_(std::move(value)) {
+        }
+        pool_aggregator() = delete;
+        void add(tateyama::metrics::metrics_metadata const&, double) override {
+        }
+        result_type aggregate() override {
+            return value_();
+        }
+      private:
+        std::function<double(void)> value_;
+    };
 
   public:
     explicit ipc_metrics(tateyama::framework::environment& env)
@@ -85,10 +106,35 @@ class ipc_metrics {
 
     std::atomic_long session_count_{};
 
-    void set_memory_parameters(std::size_t f, std::size_t p) noexcept {
+    void set_memory_parameters(std::size_t f, std::size_t p, const std::shared_ptr<bootstrap::resultset_buffer_pool>& pool) noexcept {
         metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_buffer_size",
                                                                                    "allocated buffer size for all IPC sessions",
-                                                                                   [f, p](){return std::make_unique<ipc_memory_aggregator>(f, p);}});
+                                                                                   [f, p, pool](){return std::make_unique<ipc_memory_aggregator>(f, p, pool);}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_resultset_buffer_size",
+                                                                                   "result set buffer size in use by all IPC sessions",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->bytes_in_use());});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_resultset_buffer_rejections",
+                                                                                   "number of result set buffer requests rejected by the quota",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->rejected());});}});
+    }
+    void set_annex_writer_pool(const std::shared_ptr<bootstrap::annex_writer_pool>& pool) noexcept {
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_annex_buffer_size",
+                                                                                   "result set records buffered in the heap waiting for the client",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->buffered_bytes());});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_annex_stall_time",
+                                                                                   "total time the result set writers have been stalled by the clients",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->stall_time());});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_annex_spill_size",
+                                                                                   "result set records spilled to the temporary files",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->spilled_bytes());});}});
+    }
+    void set_session_setup_pool(const std::shared_ptr<bootstrap::session_setup_pool>& pool) noexcept {
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_accept_latency",
+                                                                                   "average time from the connection request to the accept of IPC sessions",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return pool->accept_latency_average();});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"ipc_accept_latency_max",
+                                                                                   "maximum time from the connection request to the accept of IPC sessions",
+                                                                                   [pool](){return std::make_unique<pool_aggregator>([pool](){return static_cast<double>(pool->accept_latency_max());});}});
     }
     void increase() noexcept {
         session_count_++;
@@ -15,6 +15,8 @@
  */
 #pragma once
 
+#include <functional>
+
 #include "wire.h"
 #include "tateyama/logging_helper.h"
 
@@ -48,6 +50,7 @@ public:
         response_wire_container& operator = (response_wire_container&&) = default;
 
         virtual void write(const char*, tateyama::common::wire::response_header, bool) = 0;
+        virtual void write(tateyama::common::wire::response_header, const std::function<void(char*)>&, bool) = 0;
         virtual void notify_shutdown() = 0;
     };
     class resultset_wire_container;
@@ -64,6 +67,10 @@ public:
 
         virtual void write(char const*, std::size_t) = 0;
         virtual void flush() = 0;
+        /**
+         * @brief mark the record boundary, leaving the record invisible to the client until the next flush()
+         */
+        virtual void seal() = 0;
         virtual void release(unq_p_resultset_wire_conteiner) = 0;
         [[nodiscard]] virtual bool is_disposable() = 0;
     };
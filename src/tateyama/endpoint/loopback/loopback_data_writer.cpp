@@ -34,6 +34,16 @@ tateyama::status loopback_data_writer::commit() {
     return tateyama::status::ok;
 }
 
+tateyama::status loopback_data_writer::write_records(std::string_view const* records, std::size_t count) {
+    committed_data_list_.reserve(committed_data_list_.size() + count);
+    for (std::size_t i = 0; i < count; i++) {
+        auto const& record = records[i];  // NOLINT
+        write(record.data(), record.length());
+        commit();
+    }
+    return tateyama::status::ok;
+}
+
 std::vector<std::string> loopback_data_writer::release_committed_data() noexcept {
     std::vector<std::string> result { };
     committed_data_list_.swap(result);
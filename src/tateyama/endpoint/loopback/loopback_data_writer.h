@@ -29,6 +29,7 @@ class loopback_data_writer: public tateyama::api::server::writer {
 public:
     tateyama::status write(const char *data, std::size_t length) override;
     tateyama::status commit() override;
+    tateyama::status write_records(std::string_view const* records, std::size_t count) override;
 
     // just for unit test
     [[nodiscard]] std::vector<std::string> const& committed_data() const noexcept {
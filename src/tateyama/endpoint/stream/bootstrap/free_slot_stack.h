@@ -0,0 +1,92 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <optional>
+
+namespace tateyama::endpoint::stream::bootstrap {
+
+/**
+ * @brief a lock-free stack of the indexes of the free worker slots, shared by the acceptor threads.
+ * @details the head carries a tag incremented by every update in its upper 32 bits, to avoid the ABA problem
+ *  when an index is popped and pushed again by other threads between the load and the compare-and-swap.
+ */
+class free_slot_stack {
+public:
+    /**
+     * @brief create the stack containing all the indexes in [0, size), to be popped in the ascending order
+     */
+    explicit free_slot_stack(std::size_t size)
+        : size_(size), next_(std::make_unique<std::atomic_uint32_t[]>(size)) {  // NOLINT(cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+        for (std::size_t i = 0; i < size; i++) {
+            next_[i].store(i + 1 < size ? static_cast<std::uint32_t>(i + 2) : nil);
+        }
+        head_.store(size > 0 ? 1 : nil);
+    }
+
+    /**
+     * @brief take a free slot
+     * @return the index of the slot, nullopt if no slot is free
+     */
+    std::optional<std::size_t> pop() noexcept {
+        auto head = head_.load();
+        while (true) {
+            auto top = static_cast<std::uint32_t>(head & link_mask);
+            if (top == nil) {
+                return std::nullopt;
+            }
+            auto next = next_[top - 1].load();
+            if (head_.compare_exchange_weak(head, make_head(head, next))) {
+                return top - 1;
+            }
+        }
+    }
+
+    /**
+     * @brief return the slot which has become free
+     */
+    void push(std::size_t index) noexcept {
+        auto link = static_cast<std::uint32_t>(index + 1);
+        auto head = head_.load();
+        do {
+            next_[index].store(static_cast<std::uint32_t>(head & link_mask));
+        } while (!head_.compare_exchange_weak(head, make_head(head, link)));
+    }
+
+    /**
+     * @brief returns the number of the slots
+     */
+    [[nodiscard]] std::size_t size() const noexcept {
+        return size_;
+    }
+
+private:
+    static constexpr std::uint32_t nil = 0;  // the links are the indexes plus 1
+    static constexpr std::uint64_t link_mask = 0xffffffffULL;
+
+    const std::size_t size_;
+    std::unique_ptr<std::atomic_uint32_t[]> next_;  // NOLINT(cppcoreguidelines-avoid-c-arrays, hicpp-avoid-c-arrays, modernize-avoid-c-arrays)
+    std::atomic_uint64_t head_{};
+
+    static std::uint64_t make_head(std::uint64_t head, std::uint32_t link) noexcept {
+        return (((head >> 32U) + 1) << 32U) | link;
+    }
+};
+
+}  // namespace tateyama::endpoint::stream::bootstrap
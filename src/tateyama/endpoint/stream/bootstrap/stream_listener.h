@@ -23,6 +23,9 @@
 #include <chrono>
 #include <vector>
 #include <set>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 #include <csignal>
 
 #include <boost/thread/barrier.hpp>
@@ -40,6 +43,8 @@
 #include "tateyama/endpoint/stream/stream_response.h"
 #include "tateyama/endpoint/stream/metrics/stream_metrics.h"
 #include "stream_worker.h"
+#include "stream_reactor.h"
+#include "free_slot_stack.h"
 
 namespace tateyama::endpoint::stream::bootstrap {
 
@@ -86,11 +91,109 @@ public:
         VLOG_LP(log_debug) << "allow_blob_privileged = " << utils::boolalpha(allow_blob_privileged);
         conf_.allow_blob_privileged(allow_blob_privileged);
 
+        auto io_threads_opt = endpoint_config->get<std::size_t>("io_threads");
+        auto io_threads = io_threads_opt ? io_threads_opt.value() : 0;
+        VLOG_LP(log_debug) << "io_threads = " << io_threads;
+
+        auto zerocopy_opt = endpoint_config->get<bool>("zerocopy");
+        auto zerocopy = zerocopy_opt ? zerocopy_opt.value() : false;
+        VLOG_LP(log_debug) << "zerocopy = " << utils::boolalpha(zerocopy);
+
+        auto max_send_queue_size_opt = endpoint_config->get<std::size_t>("max_send_queue_size");
+        auto max_send_queue_size = max_send_queue_size_opt ? max_send_queue_size_opt.value() : send_queue::default_limit;
+        VLOG_LP(log_debug) << "max_send_queue_size = " << max_send_queue_size;
+
+        // socket options
+        socket_options options{};
+        if (auto opt = endpoint_config->get<bool>("tcp_nodelay"); opt) {
+            options.tcp_nodelay_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("send_buffer_size"); opt) {
+            options.send_buffer_size_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("receive_buffer_size"); opt) {
+            options.receive_buffer_size_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<bool>("tcp_keepalive"); opt) {
+            options.tcp_keepalive_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("tcp_keepalive_idle"); opt) {
+            options.tcp_keepalive_idle_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("tcp_keepalive_interval"); opt) {
+            options.tcp_keepalive_interval_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("tcp_keepalive_count"); opt) {
+            options.tcp_keepalive_count_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<int>("busy_poll"); opt) {
+            options.busy_poll_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<bool>("tcp_quickack"); opt) {
+            options.tcp_quickack_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<bool>("reuseport"); opt) {
+            options.reuseport_ = opt.value();
+        }
+        if (auto opt = endpoint_config->get<bool>("ipv6"); opt) {
+            options.ipv6_ = opt.value();
+        }
+
+        auto compression_opt = endpoint_config->get<std::string>("result_set_compression");
+        auto compression_name = compression_opt ? compression_opt.value() : std::string("none");
+        auto compression = compression_type::none;
+        if (compression_name == "lz4") {
+            compression = compression_type::lz4;
+        } else if (compression_name == "zstd") {
+            compression = compression_type::zstd;
+        } else if (compression_name != "none") {
+            throw std::runtime_error("result_set_compression at the stream_endpoint section should be none, lz4 or zstd");
+        }
+        if (compression != compression_type::none && !compressor::supported(compression)) {
+            LOG_LP(WARNING) << "result_set_compression is ignored, as the compression is not built in (ENABLE_STREAM_COMPRESSION)";
+            compression = compression_type::none;
+            compression_name = "none";
+        }
+        auto compression_level_opt = endpoint_config->get<int>("result_set_compression_level");
+        auto compression_level = compression_level_opt ? compression_level_opt.value() : 0;
+        VLOG_LP(log_debug) << "result_set_compression = " << compression_name << ", result_set_compression_level = " << compression_level;
+        conf_.result_set_compression(static_cast<tateyama::proto::endpoint::request::ResultSetCompression>(compression));
+
+        auto flow_control_opt = endpoint_config->get<bool>("result_set_flow_control");
+        auto flow_control = flow_control_opt ? flow_control_opt.value() : true;
+        VLOG_LP(log_debug) << "result_set_flow_control = " << utils::boolalpha(flow_control);
+        conf_.result_set_flow_control(flow_control);
+
+        auto acceptors_opt = endpoint_config->get<std::size_t>("acceptors");
+        auto acceptors = acceptors_opt ? std::max(acceptors_opt.value(), static_cast<std::size_t>(1)) : 1;
+        VLOG_LP(log_debug) << "acceptors = " << acceptors;
+        if (acceptors > 1 && !options.reuseport_) {
+            LOG_LP(INFO) << "reuseport is turned on, as multiple acceptors listen the port";
+            options.reuseport_ = true;
+        }
+
         // connection stream
-        connection_socket_ = std::make_unique<connection_socket>(port, connection_socket_timeout);
+        auto& primary = connection_sockets_.emplace_back(std::make_unique<connection_socket>(port, connection_socket_timeout, options));
+        if (zerocopy) {
+            primary->enable_zerocopy();
+            stream_metrics_.set_zerocopy_stats(primary->zerocopy_statistics());
+        }
+        primary->set_send_queue_limit(max_send_queue_size);
+        stream_metrics_.set_send_queue_stats(primary->send_queue_statistics());
+        if (compression != compression_type::none) {
+            primary->enable_compression(compression_level);
+            stream_metrics_.set_compression_stats(primary->compression_statistics());
+        }
+        while (connection_sockets_.size() < acceptors) {  // the kernel distributes the connections among the sockets
+            connection_sockets_.emplace_back(std::make_unique<connection_socket>(port, connection_socket_timeout, options))->share_settings(*connection_sockets_.front());
+        }
 
         // worker objects
         workers_.resize(threads);
+        free_slots_ = std::make_unique<free_slot_stack>(threads);
+        if (io_threads > 0) {
+            reactor_ = std::make_unique<stream_reactor>(io_threads, threads);
+        }
 
         // output configuration to be used
         LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
@@ -99,6 +202,64 @@ public:
         LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
                   << "threads: " << threads << ", "
                   << "the number of maximum sessions.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "io_threads: " << io_threads << ", "
+                  << "the number of io threads serving the sessions, 0 means a thread per session.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "zerocopy: " << utils::boolalpha(zerocopy) << ", "
+                  << "whether the large result sets are sent with MSG_ZEROCOPY or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "max_send_queue_size: " << max_send_queue_size << ", "
+                  << "the maximum bytes of the result set records queued to be sent in a session.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "result_set_compression: " << compression_name << ", "
+                  << "the codec compressing the result sets for the clients requesting it.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "result_set_compression_level: " << compression_level << ", "
+                  << "the compression level, 0 means the default of the codec.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "result_set_flow_control: " << utils::boolalpha(flow_control) << ", "
+                  << "whether the result sets are sent within the credit granted by the clients requesting it or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_nodelay: " << utils::boolalpha(options.tcp_nodelay_) << ", "
+                  << "whether TCP_NODELAY is set to the sockets or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "send_buffer_size: " << options.send_buffer_size_ << ", "
+                  << "SO_SNDBUF of the sockets, 0 means the default of the kernel.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "receive_buffer_size: " << options.receive_buffer_size_ << ", "
+                  << "SO_RCVBUF of the sockets, 0 means the default of the kernel.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_keepalive: " << utils::boolalpha(options.tcp_keepalive_) << ", "
+                  << "whether SO_KEEPALIVE is set to the sockets or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_keepalive_idle: " << options.tcp_keepalive_idle_ << ", "
+                  << "TCP_KEEPIDLE in seconds, 0 means the default of the kernel.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_keepalive_interval: " << options.tcp_keepalive_interval_ << ", "
+                  << "TCP_KEEPINTVL in seconds, 0 means the default of the kernel.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_keepalive_count: " << options.tcp_keepalive_count_ << ", "
+                  << "TCP_KEEPCNT, 0 means the default of the kernel.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "busy_poll: " << options.busy_poll_ << ", "
+                  << "SO_BUSY_POLL in microseconds, 0 means no busy polling.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "tcp_quickack: " << utils::boolalpha(options.tcp_quickack_) << ", "
+                  << "whether TCP_QUICKACK is set after each receive or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "reuseport: " << utils::boolalpha(options.reuseport_) << ", "
+                  << "whether SO_REUSEPORT is set to the listen socket or not.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "acceptors: " << acceptors << ", "
+                  << "the number of threads accepting the connections.";
+        LOG(INFO) << tateyama::endpoint::common::stream_endpoint_config_prefix
+                  << "ipv6: " << utils::boolalpha(options.ipv6_) << ", "
+                  << "whether the port is listened by an IPv6 dual-stack socket or not.";
+#ifdef ENABLE_IO_URING
+        LOG_LP(INFO) << "stream_endpoint accepts the connections by " << (connection_sockets_.front()->uses_io_uring() ? "io_uring" : "accept()")
+                     << ", and sends the large payloads by " << (uring_sender::supported() ? "IORING_OP_SEND_ZC" : "sendmsg()");
+#endif
 
         // session timeout
         if (auto* session_config = cfg_->get_section("session"); session_config) {
@@ -153,7 +314,9 @@ public:
     }
 
     ~stream_listener() override {
-        connection_socket_->close();
+        for (auto&& socket : connection_sockets_) {
+            socket->close();
+        }
     }
 
     stream_listener(stream_listener const& other) = delete;
@@ -163,16 +326,105 @@ public:
 
     void operator()() override {
         pthread_setname_np(pthread_self(), "tcp_listener");
-        session_id_ = 0x1000000000000000LL;  // initial value
+        session_id_.store(0x1000000000000000LL);  // initial value
+        if (reactor_) {
+            reactor_->start();
+        }
 
         arrive_and_wait();
-        while(true) {
+        std::vector<std::thread> acceptors{};
+        for (std::size_t i = 1; i < connection_sockets_.size(); i++) {
+            acceptors.emplace_back([this, i]{
+                pthread_setname_np(pthread_self(), "tcp_acceptor");
+                accept_connections(*connection_sockets_.at(i));
+            });
+        }
+        accept_connections(*connection_sockets_.front());
+        for (auto&& acceptor : acceptors) {
+            acceptor.join();
+        }
+        terminate_workers();
+        confirm_workers_termination();
+        if (reactor_) {
+            reactor_->stop();
+        }
+    }
+
+    void arrive_and_wait() override {
+        sync.wait();
+    }
+
+    void terminate() override {
+        for (auto&& socket : connection_sockets_) {
+            socket->request_terminate();
+        }
+    }
+
+    void print_diagnostic(std::ostream& os) override {
+        os << "/:tateyama:stream_endpoint print diagnostics start\n";
+        {
+            std::unique_lock<std::mutex> lock(mtx_workers_);
+            os << "  live sessions\n";
+            for (auto && worker : workers_) {
+                if (worker) {
+                    worker->print_diagnostic(os);
+                }
+            }
+        }
+        os << "  connection status\n"
+              "    session_id accepted = " << session_id_.load() << "\n"
+              "    acceptors = " << connection_sockets_.size() << "\n"
+              "  io threads\n"
+              "    threads = " << (reactor_ ? reactor_->threads() : 0) << "\n"
+              "    sessions served = " << (reactor_ ? reactor_->sessions() : 0) << "\n"
+              "/:tateyama:stream_endpoint print diagnostics end\n";
+    }
+
+    void foreach_request(const callback& func) override {
+        std::unique_lock<std::mutex> lock(mtx_workers_);
+        for (auto && e : workers_) {
+            if (const std::shared_ptr<stream_worker>& worker = e; worker) {
+                if (!worker->is_terminated()) {
+                    worker->foreach_request(func);
+                }
+            }
+        }
+    }
+
+private:
+    tateyama::endpoint::common::configuration conf_;
+    tateyama::endpoint::stream::metrics::stream_metrics stream_metrics_;
+
+    std::atomic_size_t session_id_{};
+    std::vector<std::unique_ptr<connection_socket>> connection_sockets_{};  // listening the same port, each served by an acceptor thread
+    std::vector<std::shared_ptr<stream_worker>> workers_{};  // an element is accessed only by the acceptor which has taken its index from free_slots_ and by the worker
+    std::unique_ptr<free_slot_stack> free_slots_{};
+    std::set<std::shared_ptr<stream_worker>, tateyama::endpoint::common::pointer_comp<stream_worker>> undertakers_{};
+    std::mutex mtx_workers_{};
+    std::mutex mtx_undertakers_{};
+    std::unique_ptr<stream_reactor> reactor_{};
+
+    boost::barrier sync{2};
+
+    void retire_worker(std::size_t index) {
+        auto& worker = workers_.at(index);
+        worker->dispose_session_store();
+        {
+            std::unique_lock<std::mutex> lock_w(mtx_workers_);
+            std::unique_lock<std::mutex> lock_u(mtx_undertakers_);
+            worker->set_detached(false);
+            undertakers_.emplace(std::move(worker));
+        }
+        stream_metrics_.decrease();
+        free_slots_->push(index);
+    }
 
+    void accept_connections(connection_socket& socket) {
+        while(true) {
             std::unique_ptr<stream_socket> stream{};
             try {
-                stream = connection_socket_->accept([this](){care_undertakers();});
+                stream = socket.accept([this](){care_undertakers();});
                 if (!stream) {  // received termination request.
-                    terminate_workers();
                     break;
                 }
             } catch (std::exception& ex) {
@@ -180,19 +432,10 @@ public:
                 continue;
             }
 
-            DVLOG_LP(log_trace) << "created session stream: " << session_id_;
-            std::size_t index = 0;
-            bool found = false;
-            for (; index < workers_.size() ; index++) {
-                auto& worker = workers_.at(index);
-                if (!worker) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
+            auto slot = free_slots_->pop();
+            if (!slot) {
                 try {
-                    auto worker_decline = std::make_shared<stream_worker>(*router_, conf_, session_id_, std::move(stream), true);
+                    auto worker_decline = std::make_shared<stream_worker>(*router_, conf_, session_id_.load(), std::move(stream), true);
                     auto* worker = worker_decline.get();
                     {
                         std::unique_lock<std::mutex> lock(mtx_undertakers_);
@@ -210,86 +453,40 @@ public:
                     LOG_LP(ERROR) << ex.what();
                 }
             } else {
+                auto index = slot.value();
+                auto session_id = session_id_.fetch_add(1);
+                DVLOG_LP(log_trace) << "created session stream: " << session_id;
                 try {
                     auto& worker_entry = workers_.at(index);
                     {
                         std::unique_lock<std::mutex> lock(mtx_workers_);
-                        worker_entry = std::make_shared<stream_worker>(*router_, conf_, session_id_, std::move(stream), false);
+                        worker_entry = std::make_shared<stream_worker>(*router_, conf_, session_id, std::move(stream), false);
                     }
                     stream_metrics_.increase();
                     worker_entry->invoke([this, index]{
                         auto& worker = workers_.at(index);
                         worker->register_worker_in_context(worker);
                         try {
-                            worker->run();
+                            if (!worker->run(reactor_ != nullptr)) {
+                                reactor_->attach(index, worker, [this, index]{ retire_worker(index); });
+                                return;
+                            }
                         } catch(std::exception &ex) {
                             LOG(ERROR) << "ipc_endpoint worker thread got an exception: " << ex.what();
                         }
-                        worker->dispose_session_store();
-                        {
-                            std::unique_lock<std::mutex> lock_w(mtx_workers_);
-                            std::unique_lock<std::mutex> lock_u(mtx_undertakers_);
-                            undertakers_.emplace(std::move(worker));
-                        }
-                        stream_metrics_.decrease();
+                        retire_worker(index);
                     });
-                    session_id_++;
                 } catch (std::exception& ex) {
                     LOG_LP(ERROR) << ex.what();
-                }
-            }
-        }
-        confirm_workers_termination();
-    }
-
-    void arrive_and_wait() override {
-        sync.wait();
-    }
-
-    void terminate() override {
-        connection_socket_->request_terminate();
-    }
-
-    void print_diagnostic(std::ostream& os) override {
-        os << "/:tateyama:stream_endpoint print diagnostics start\n";
-        {
-            std::unique_lock<std::mutex> lock(mtx_workers_);
-            os << "  live sessions\n";
-            for (auto && worker : workers_) {
-                if (worker) {
-                    worker->print_diagnostic(os);
-                }
-            }
-        }
-        os << "  connection status\n"
-              "    session_id accepted = " << session_id_ << "\n"
-              "/:tateyama:stream_endpoint print diagnostics end\n";
-    }
-
-    void foreach_request(const callback& func) override {
-        std::unique_lock<std::mutex> lock(mtx_workers_);
-        for (auto && e : workers_) {
-            if (const std::shared_ptr<stream_worker>& worker = e; worker) {
-                if (!worker->is_terminated()) {
-                    worker->foreach_request(func);
+                    std::unique_lock<std::mutex> lock(mtx_workers_);
+                    if (!workers_.at(index)) {
+                        free_slots_->push(index);
+                    }
                 }
             }
         }
     }
 
-private:
-    tateyama::endpoint::common::configuration conf_;
-    tateyama::endpoint::stream::metrics::stream_metrics stream_metrics_;
-
-    std::size_t session_id_{};
-    std::unique_ptr<connection_socket> connection_socket_{};
-    std::vector<std::shared_ptr<stream_worker>> workers_{};  // accessed only by the listner thread, thus mutual exclusion in unnecessary.
-    std::set<std::shared_ptr<stream_worker>, tateyama::endpoint::common::pointer_comp<stream_worker>> undertakers_{};
-    std::mutex mtx_workers_{};
-    std::mutex mtx_undertakers_{};
-
-    boost::barrier sync{2};
-
     bool care_undertakers() {
         std::unique_lock<std::mutex> lock(mtx_undertakers_);
         for (auto it{undertakers_.begin()}, end{undertakers_.end()}; it != end; ) {
@@ -306,11 +503,14 @@ private:
         tateyama::status_info::shutdown_type shutdown_type = status_->get_shutdown_request();
         {
             std::unique_lock<std::mutex> lock(mtx_workers_);
-            for (auto&& worker : workers_) {
-                if (worker) {
+            for (std::size_t index = 0; index < workers_.size(); index++) {
+                if (auto& worker = workers_.at(index); worker) {
                     worker->terminate(shutdown_type == tateyama::status_info::shutdown_type::graceful ?
                                       tateyama::session::shutdown_request_type::graceful :
                                       tateyama::session::shutdown_request_type::forceful);
+                    if (reactor_) {
+                        reactor_->notify(index);
+                    }
                 }
             }
         }
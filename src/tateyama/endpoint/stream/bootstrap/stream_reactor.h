@@ -0,0 +1,361 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+#include <glog/logging.h>
+#include <tateyama/logging.h>
+
+#include "tateyama/endpoint/common/logging.h"
+#include "stream_worker.h"
+
+namespace tateyama::endpoint::stream::bootstrap {
+
+/**
+ * @brief a fixed number of io threads serving the sessions handed over from the stream_worker threads.
+ *  Each io thread owns the sockets of the sessions assigned to it and waits for them by epoll,
+ *  and performs the periodic housekeeping of the sessions, which the poll() timeout of the stream_worker used to drive.
+ */
+class stream_reactor {
+public:
+    /**
+     * @brief the interval of the housekeeping of the sessions served, in milliseconds.
+     */
+    static constexpr std::int64_t sweep_interval = 500;
+
+    /**
+     * @brief construct the object
+     * @param threads the number of io threads
+     * @param slots the maximum number of sessions
+     */
+    stream_reactor(std::size_t threads, std::size_t slots) : entries_(slots) {
+        for (std::size_t i = 0; i < threads; i++) {
+            io_threads_.emplace_back(std::make_unique<io_thread>());
+        }
+    }
+    ~stream_reactor() {
+        stop();
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    stream_reactor(stream_reactor const&) = delete;
+    stream_reactor(stream_reactor&&) = delete;
+    stream_reactor& operator = (stream_reactor const&) = delete;
+    stream_reactor& operator = (stream_reactor&&) = delete;
+
+    /**
+     * @brief start the io threads.
+     */
+    void start() {
+        for (auto&& t : io_threads_) {
+            auto* tp = t.get();
+            tp->thread_ = std::thread([this, tp]{ operator()(*tp); });
+        }
+    }
+
+    /**
+     * @brief stop the io threads, all the sessions are supposed to have been finished.
+     */
+    void stop() {
+        if (stop_.exchange(true)) {
+            return;
+        }
+        for (auto&& t : io_threads_) {
+            t->wake_up();
+        }
+        for (auto&& t : io_threads_) {
+            if (t->thread_.joinable()) {
+                t->thread_.join();
+            }
+        }
+    }
+
+    /**
+     * @brief hand over the session to the io threads.
+     * @param slot the slot index of the session
+     * @param worker the worker of the session, whose handshake has been completed
+     * @param on_finished the callback invoked by the io thread when the session has been finished
+     */
+    void attach(std::size_t slot, std::shared_ptr<stream_worker> worker, std::function<void(void)> on_finished) {
+        auto& e = entries_.at(slot);
+        {
+            std::lock_guard<std::mutex> lock(e.mtx_);
+            e.worker_ = std::move(worker);
+            e.on_finished_ = std::move(on_finished);
+        }
+        auto& t = owner(slot);
+        {
+            std::lock_guard<std::mutex> lock(t.mtx_);
+            t.arrived_.emplace_back(slot);
+        }
+        t.wake_up();
+    }
+
+    /**
+     * @brief let the io thread check the session immediately, such as after a shutdown request.
+     * @param slot the slot index of the session
+     */
+    void notify(std::size_t slot) {
+        if (entries_.at(slot).tick_.exchange(true)) {
+            return;  // the io thread has not checked it since the previous notification
+        }
+        auto& t = owner(slot);
+        {
+            std::lock_guard<std::mutex> lock(t.mtx_);
+            t.ticked_.emplace_back(slot);
+        }
+        t.wake_up();
+    }
+
+    // for diagnostic
+    [[nodiscard]] std::size_t threads() const noexcept { return io_threads_.size(); }
+    [[nodiscard]] std::size_t sessions() const noexcept { return sessions_.load(); }
+
+private:
+    static constexpr std::uint64_t wake_up_key = std::numeric_limits<std::uint64_t>::max();
+    static constexpr int max_events = 64;
+
+    class entry {
+    public:
+        std::mutex mtx_{};
+        std::shared_ptr<stream_worker> worker_{};
+        std::function<void(void)> on_finished_{};
+        std::atomic_bool tick_{};
+        bool registered_{};  // accessed only by the owner io thread
+        bool served_{};  // accessed only by the owner io thread, true while the slot is in serving_
+    };
+
+    class io_thread {
+    public:
+        io_thread() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)), event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+            if (epoll_fd_ < 0 || event_fd_ < 0) {
+                throw std::runtime_error("cannot create an epoll instance for the io thread");
+            }
+            struct epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = wake_up_key;
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev) != 0) {
+                throw std::runtime_error("cannot register the eventfd to the epoll instance");
+            }
+        }
+        ~io_thread() {
+            ::close(event_fd_);
+            ::close(epoll_fd_);
+        }
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        io_thread(io_thread const&) = delete;
+        io_thread(io_thread&&) = delete;
+        io_thread& operator = (io_thread const&) = delete;
+        io_thread& operator = (io_thread&&) = delete;
+
+        void wake_up() const {
+            std::uint64_t one = 1;
+            if (write(event_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+                LOG_LP(ERROR) << "fail to wake up the io thread";
+            }
+        }
+
+        const int epoll_fd_;  // NOLINT(misc-non-private-member-variables-in-classes)
+        const int event_fd_;  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::thread thread_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::mutex mtx_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::vector<std::size_t> arrived_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::vector<std::size_t> ticked_{};  // the slots notified, NOLINT(misc-non-private-member-variables-in-classes)
+        std::vector<std::size_t> serving_{};  // accessed only by this io thread, NOLINT(misc-non-private-member-variables-in-classes)
+        std::vector<std::size_t> checking_{};  // accessed only by this io thread, reused for the slots to be checked, NOLINT(misc-non-private-member-variables-in-classes)
+    };
+
+    std::vector<entry> entries_;
+    std::vector<std::unique_ptr<io_thread>> io_threads_{};
+    std::atomic_bool stop_{};
+    std::atomic_size_t sessions_{};
+
+    io_thread& owner(std::size_t slot) {
+        return *io_threads_.at(slot % io_threads_.size());
+    }
+
+    void operator()(io_thread& t) {
+        pthread_setname_np(pthread_self(), "tcp_io");
+        std::vector<struct epoll_event> events(max_events);
+        auto next_sweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(sweep_interval);
+        while (!stop_.load()) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next_sweep - std::chrono::steady_clock::now()).count();
+            auto n = epoll_wait(t.epoll_fd_, events.data(), max_events, static_cast<int>(std::max(wait, static_cast<std::int64_t>(0))));
+            if (n < 0) {
+                if (errno != EINTR) {
+                    LOG_LP(ERROR) << "error in epoll_wait, errno = " << errno;
+                }
+                continue;
+            }
+            for (int i = 0; i < n; i++) {
+                auto& ev = events.at(i);
+                if (ev.data.u64 == wake_up_key) {
+                    std::uint64_t count{};
+                    if (read(t.event_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                        LOG_LP(ERROR) << "fail to read the eventfd of the io thread";
+                    }
+                    adopt(t);
+                    check_ticked(t);
+                    continue;
+                }
+                serve(t, ev.data.u64, (ev.events & EPOLLPRI) != 0);  // NOLINT(hicpp-signed-bitwise)
+            }
+            if (std::chrono::steady_clock::now() >= next_sweep) {
+                next_sweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(sweep_interval);
+                t.checking_.assign(t.serving_.begin(), t.serving_.end());  // serve_idle() may remove the slot from serving_
+                for (auto slot : t.checking_) {
+                    serve_idle(t, slot);
+                }
+            }
+        }
+    }
+
+    // checks the sessions notified, without walking the other sessions
+    void check_ticked(io_thread& t) {
+        t.checking_.clear();
+        {
+            std::lock_guard<std::mutex> lock(t.mtx_);
+            t.checking_.swap(t.ticked_);
+        }
+        for (auto slot : t.checking_) {
+            auto& e = entries_.at(slot);
+            e.tick_.store(false);
+            if (e.served_) {  // otherwise adopted afterwards, and checked by the sweep
+                serve_idle(t, slot);
+            }
+        }
+    }
+
+    // registers the sockets of the sessions handed over to this io thread
+    void adopt(io_thread& t) {
+        std::vector<std::size_t> arrived{};
+        {
+            std::lock_guard<std::mutex> lock(t.mtx_);
+            arrived.swap(t.arrived_);
+        }
+        for (auto slot : arrived) {
+            auto& e = entries_.at(slot);
+            auto worker = get_worker(e);
+            t.serving_.emplace_back(slot);
+            e.served_ = true;
+            sessions_.fetch_add(1);
+            struct epoll_event ev{};
+            ev.events = EPOLLIN | EPOLLPRI | EPOLLRDHUP;  // NOLINT(hicpp-signed-bitwise)
+            ev.data.u64 = slot;
+            if (epoll_ctl(t.epoll_fd_, EPOLL_CTL_ADD, worker->native_handle(), &ev) != 0) {
+                LOG_LP(ERROR) << "cannot register the socket of session " << worker->session_id() << " to the io thread";
+                finish(t, slot);
+                continue;
+            }
+            e.registered_ = true;
+        }
+    }
+
+    void serve(io_thread& t, std::size_t slot, bool urgent) {
+        auto& e = entries_.at(slot);
+        auto worker = get_worker(e);
+        if (!worker) {
+            return;
+        }
+        bool alive{};
+        try {
+            alive = worker->poll(urgent);
+        } catch (std::exception &ex) {
+            LOG_LP(ERROR) << "stream_endpoint io thread got an exception: " << ex.what();
+        }
+        if (!alive) {
+            finish(t, slot);
+            return;
+        }
+        if (worker->draining()) {
+            // the socket is no longer watched, the requests in process are checked at every sweep
+            unregister(t, slot, worker->native_handle());
+        }
+    }
+
+    void serve_idle(io_thread& t, std::size_t slot) {
+        auto& e = entries_.at(slot);
+        auto worker = get_worker(e);
+        if (!worker) {
+            return;
+        }
+        bool alive{};
+        try {
+            alive = worker->idle();
+        } catch (std::exception &ex) {
+            LOG_LP(ERROR) << "stream_endpoint io thread got an exception: " << ex.what();
+        }
+        if (!alive) {
+            finish(t, slot);
+        }
+    }
+
+    void unregister(io_thread& t, std::size_t slot, int fd) {
+        auto& e = entries_.at(slot);
+        if (e.registered_) {
+            epoll_ctl(t.epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+            e.registered_ = false;
+        }
+    }
+
+    void finish(io_thread& t, std::size_t slot) {
+        auto& e = entries_.at(slot);
+        std::shared_ptr<stream_worker> worker{};
+        std::function<void(void)> on_finished{};
+        {
+            std::lock_guard<std::mutex> lock(e.mtx_);
+            worker = std::move(e.worker_);
+            e.worker_ = nullptr;
+            on_finished = std::move(e.on_finished_);
+            e.on_finished_ = nullptr;
+        }
+        unregister(t, slot, worker->native_handle());
+        sessions_.fetch_sub(1);
+        t.serving_.erase(std::remove(t.serving_.begin(), t.serving_.end(), slot), t.serving_.end());
+        e.served_ = false;
+        e.tick_.store(false);
+        worker->finish();
+        if (on_finished) {
+            on_finished();
+        }
+    }
+
+    static std::shared_ptr<stream_worker> get_worker(entry& e) {
+        std::lock_guard<std::mutex> lock(e.mtx_);
+        return e.worker_;
+    }
+};
+
+}
@@ -25,7 +25,7 @@
 
 namespace tateyama::endpoint::stream::bootstrap {
 
-void stream_worker::run()  // NOLINT(readability-function-cognitive-complexity)
+bool stream_worker::run(bool detachable)  // NOLINT(readability-function-cognitive-complexity)
 {
     while (true) {
         pthread_setname_np(pthread_self(), "tcp_worker");
@@ -45,7 +45,7 @@ void stream_worker::run()  // NOLINT(readability-function-cognitive-complexity)
                     std::string error_message{"request parse error"};
                     LOG_LP(INFO) << error_message;
                     notify_client(&response_obj, tateyama::proto::diagnostics::Code::INVALID_REQUEST, error_message);
-                    return;
+                    return true;
                 }
                 notify_of_decline(rq, &response_obj);
                 if (session_stream_->await(slot, payload) == tateyama::endpoint::stream::stream_socket::await_result::payload) {
@@ -54,7 +54,7 @@ void stream_worker::run()  // NOLINT(readability-function-cognitive-complexity)
                     VLOG_LP(log_trace) << "session termination due to reaching the maximum number of sessions: session_id = " << std::to_string(session_id());
                 }
                 session_stream_->close();
-                return;
+                return true;
             }
 
             try {
@@ -63,13 +63,15 @@ void stream_worker::run()  // NOLINT(readability-function-cognitive-complexity)
                         LOG_LP(INFO) << "illegal termination of the session due to handshake error";  // should not reach here
                     }
                     session_stream_->close();
-                    return;
+                    return true;
                 }
             } catch (psudo_exception_of_continue &ex) {
                 continue;
             }
 
             session_stream_->change_slot_size(max_result_sets_);
+            session_stream_->enable_compression(static_cast<compression_type>(result_set_compression_));
+            session_stream_->enable_flow_control(result_set_window_);
             break;
         }
 
@@ -79,148 +81,191 @@ void stream_worker::run()  // NOLINT(readability-function-cognitive-complexity)
         case tateyama::endpoint::stream::stream_socket::await_result::socket_closed:
             session_stream_->close();
             VLOG_LP(log_trace) << "socket has been closed by the client: session_id = " << std::to_string(session_id());
-            return;
+            return true;
 
         case tateyama::endpoint::stream::stream_socket::await_result::termination_request:
             VLOG_LP(log_trace) << "received shutdown request: session_id = " << std::to_string(session_id());
             if (shutdown_from_client()) {
                 session_stream_->send_session_bye_ok();
             }
-            return;
+            return true;
 
         default:
             session_stream_->close();
             VLOG_LP(log_trace) << "detects illegal state: session_id = " << std::to_string(session_id());
-            return;
+            return true;
         }
         break;
     }
 
     VLOG(log_debug_timing_event) << "/:tateyama:timing:session:started " << std::to_string(session_id());
 #ifdef ENABLE_ALTIMETER
-    const std::chrono::time_point session_start_time = std::chrono::high_resolution_clock::now();
+    session_start_time_ = std::chrono::high_resolution_clock::now();
     tateyama::endpoint::altimeter::session_start(conf_.database_info(), resources().session_info());
 #endif
-    bool notiry_expiration_time_over{};
+    if (detachable) {
+        VLOG_LP(log_trace) << "hand over session " << session_id() << " to the io threads";
+        set_detached(true);
+        return false;
+    }
     while(true) {
         std::uint16_t slot{};
-        std::string payload{};
-
-        switch (session_stream_->await(slot, payload)) {
-        case tateyama::endpoint::stream::stream_socket::await_result::payload:
-        {
-            update_expiration_time();
-            auto request = std::make_shared<stream_request>(*session_stream_, payload,  resources(), local_id_++, conf_);
-            switch (request->service_id()) {
-            case tateyama::framework::service_id_endpoint_broker:
-            {
-                auto response = std::make_shared<stream_response>(*session_stream_, slot, [](){}, conf_);
-                // currently cancel request only
-                if (endpoint_service(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                     std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response),
-                                     slot)) {
-                    continue;
-                }
-                VLOG_LP(log_info) << "terminate worker because endpoint service returns an error";
-                break;
-            }
-            case tateyama::framework::service_id_routing:
-            {
-                auto response = std::make_shared<stream_response>(*session_stream_, slot, [this, slot](){remove_reqres(slot);}, conf_);
-                if (!register_reqres(slot,
-                                     std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
-                                     std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
-                    continue;  // error has been notified to the client
-                }
-                if (routing_service_chain(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                          std::dynamic_pointer_cast<tateyama::api::server::response>(response),
-                                          slot)) {
-                    care_reqreses();
-                    if (check_shutdown_request() && is_completed()) {
-                        shutdown_complete();
-                        VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
-                    }
-                    continue;
-                }
-                if (service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                             std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
-                    continue;
-                }
-                VLOG_LP(log_info) << "terminate worker because service returns an error";
-                break;
-            }
-            default:
-            {
-                auto response = std::make_shared<stream_response>(*session_stream_, slot, [this, slot](){remove_reqres(slot);}, conf_);
-                if (!check_shutdown_request()) {
-                    if (!register_reqres(slot,
-                                         std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
-                                         std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
-                        continue;  // error has been notified to the client
-                    }
-                    if(service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
-                                std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
-                        continue;
-                    }
-                    VLOG_LP(log_info) << "terminate worker because service returns an error";
-                } else {
-                    notify_client(response.get(), tateyama::proto::diagnostics::SESSION_CLOSED, "this session is already shutdown");
-                    continue;
-                }
-            }
-            }
-            request = nullptr;
+        if (!handle(session_stream_->await(slot, payload_), slot, payload_)) {
             break;
         }
-
-        case tateyama::endpoint::stream::stream_socket::await_result::timeout:
-            care_reqreses();
-            if (check_shutdown_request() && is_completed()) {
-                VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
-                shutdown_complete();
-                if (!shutdown_from_client()) {
-                    break;
-                }
-            }
-            if (!notiry_expiration_time_over) {
-                if (is_expiration_time_over()) {
-                    request_shutdown(tateyama::session::shutdown_request_type::forceful);
-                    notiry_expiration_time_over = true;
-                }
-            }
-            continue;
-
-        case tateyama::endpoint::stream::stream_socket::await_result::termination_request:
-            if (shutdown_from_client()) {
-                session_stream_->send_session_bye_ok();
-                break;
-            }
-            request_shutdown(tateyama::session::shutdown_request_type::forceful);
-            session_stream_->send_session_bye_ok();
-            continue;
-
-        case tateyama::endpoint::stream::stream_socket::await_result::socket_closed:
-            VLOG_LP(log_trace) << "socket has been closed by the client: session_id = " << std::to_string(session_id());
+        if (draining_) {
             while (!is_completed()) {
                 care_reqreses();
                 std::this_thread::sleep_for(poll_interval);
             }
             break;
+        }
+    }
+    finish();
+    return true;
+}
 
-        default:  // some error
-            VLOG_LP(log_trace) << "detects illegal state: session_id = " << std::to_string(session_id());
+bool stream_worker::poll(bool urgent) {
+    std::uint16_t slot{};
+    if (urgent && !handle(session_stream_->discard_urgent_data(), slot, payload_)) {
+        return false;
+    }
+    for (std::size_t n = 0; n < max_requests_per_poll && !draining_; n++) {
+        auto result = session_stream_->try_await(slot, payload_);
+        if (result == tateyama::endpoint::stream::stream_socket::await_result::would_block) {
             break;
         }
-        break;
+        if (!handle(result, slot, payload_)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool stream_worker::idle() {
+    care_reqreses();
+    if (draining_) {
+        return !is_completed();
+    }
+    if (check_shutdown_request() && is_completed()) {
+        VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
+        shutdown_complete();
+        if (!shutdown_from_client()) {
+            return false;
+        }
+    }
+    if (!notify_expiration_time_over_) {
+        if (is_expiration_time_over()) {
+            request_shutdown(tateyama::session::shutdown_request_type::forceful);
+            notify_expiration_time_over_ = true;
+        }
     }
+    return true;
+}
+
+void stream_worker::finish() {
     session_stream_->close();
 
 #ifdef ENABLE_ALTIMETER
-    tateyama::endpoint::altimeter::session_end(conf_.database_info(), resources().session_info(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - session_start_time).count());
+    tateyama::endpoint::altimeter::session_end(conf_.database_info(), resources().session_info(), std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - session_start_time_).count());
 #endif
     VLOG(log_debug_timing_event) << "/:tateyama:timing:session:finished " << session_id();
 }
 
+bool stream_worker::handle(stream_socket::await_result result, std::uint16_t slot, std::string& payload) {
+    switch (result) {
+    case tateyama::endpoint::stream::stream_socket::await_result::payload:
+        return process(slot, payload);
+
+    case tateyama::endpoint::stream::stream_socket::await_result::timeout:
+        return idle();
+
+    case tateyama::endpoint::stream::stream_socket::await_result::termination_request:
+        if (shutdown_from_client()) {
+            session_stream_->send_session_bye_ok();
+            return false;
+        }
+        request_shutdown(tateyama::session::shutdown_request_type::forceful);
+        session_stream_->send_session_bye_ok();
+        return true;
+
+    case tateyama::endpoint::stream::stream_socket::await_result::socket_closed:
+        VLOG_LP(log_trace) << "socket has been closed by the client: session_id = " << std::to_string(session_id());
+        draining_ = true;
+        return true;
+
+    case tateyama::endpoint::stream::stream_socket::await_result::would_block:
+        return true;
+
+    default:  // some error
+        VLOG_LP(log_trace) << "detects illegal state: session_id = " << std::to_string(session_id());
+        return false;
+    }
+}
+
+bool stream_worker::process(std::uint16_t slot, std::string& payload) {  // NOLINT(readability-function-cognitive-complexity)
+    update_expiration_time();
+    auto request = std::make_shared<stream_request>(*session_stream_, payload,  resources(), local_id_++, conf_);
+    switch (request->service_id()) {
+    case tateyama::framework::service_id_endpoint_broker:
+    {
+        auto response = std::make_shared<stream_response>(*session_stream_, slot, [](){}, conf_);
+        // currently cancel request only
+        if (endpoint_service(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                             std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response),
+                             slot)) {
+            return true;
+        }
+        VLOG_LP(log_info) << "terminate worker because endpoint service returns an error";
+        return false;
+    }
+    case tateyama::framework::service_id_routing:
+    {
+        auto response = std::make_shared<stream_response>(*session_stream_, slot, [this, slot](){remove_reqres(slot);}, conf_);
+        if (!register_reqres(slot,
+                             std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
+                             std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
+            return true;  // error has been notified to the client
+        }
+        if (routing_service_chain(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                                  std::dynamic_pointer_cast<tateyama::api::server::response>(response),
+                                  slot)) {
+            care_reqreses();
+            if (check_shutdown_request() && is_completed()) {
+                shutdown_complete();
+                VLOG_LP(log_trace) << "received and completed shutdown request: session_id = " << std::to_string(session_id());
+            }
+            return true;
+        }
+        if (service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                     std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
+            return true;
+        }
+        VLOG_LP(log_info) << "terminate worker because service returns an error";
+        return false;
+    }
+    default:
+    {
+        auto response = std::make_shared<stream_response>(*session_stream_, slot, [this, slot](){remove_reqres(slot);}, conf_);
+        if (!check_shutdown_request()) {
+            if (!register_reqres(slot,
+                                 std::dynamic_pointer_cast<tateyama::endpoint::common::request>(request),
+                                 std::dynamic_pointer_cast<tateyama::endpoint::common::response>(response))) {
+                return true;  // error has been notified to the client
+            }
+            if(service_(std::dynamic_pointer_cast<tateyama::api::server::request>(request),
+                        std::dynamic_pointer_cast<tateyama::api::server::response>(response))) {
+                return true;
+            }
+            VLOG_LP(log_info) << "terminate worker because service returns an error";
+            return false;
+        }
+        notify_client(response.get(), tateyama::proto::diagnostics::SESSION_CLOSED, "this session is already shutdown");
+        return true;
+    }
+    }
+}
+
 bool stream_worker::terminate(tateyama::session::shutdown_request_type type) {
     VLOG_LP(log_trace) << "send terminate request: session_id = " << std::to_string(session_id());
 
@@ -39,15 +39,58 @@ class alignas(64) stream_worker : public tateyama::endpoint::common::worker_comm
           decline_(decline) {
     }
 
-    void run();
+    /**
+     * @brief serve the session on the calling thread.
+     * @param detachable whether the session can be handed over to the io threads after the handshake
+     * @return false if the session has been handed over to the io threads, otherwise true
+     */
+    bool run(bool detachable = false);
+    /**
+     * @brief process the request messages received, used by the io threads.
+     * @param urgent whether the client has sent the urgent data
+     * @return false if the session is to be finished
+     */
+    bool poll(bool urgent = false);
+    /**
+     * @brief housekeeping performed periodically, used by the io threads.
+     * @return false if the session is to be finished
+     */
+    bool idle();
+    /**
+     * @brief the epilogue of the session.
+     */
+    void finish();
     bool terminate(tateyama::session::shutdown_request_type type);
 
+    /**
+     * @brief returns whether the socket has been closed by the client and the session waits for the requests in process.
+     */
+    [[nodiscard]] bool draining() const noexcept {
+        return draining_;
+    }
+    /**
+     * @brief returns the socket descriptor of the session
+     */
+    [[nodiscard]] int native_handle() const noexcept {
+        return session_stream_->native_handle();
+    }
+
  private:
     tateyama::framework::routing_service& service_;
     std::unique_ptr<stream_socket> session_stream_;
     const tateyama::endpoint::common::configuration& conf_;
     const bool decline_;
     static constexpr std::chrono::duration poll_interval = std::chrono::milliseconds(20);
+    static constexpr std::size_t max_requests_per_poll = 64;
+    bool notify_expiration_time_over_{};
+    bool draining_{};
+    std::string payload_{};  // recycled over the requests to avoid allocating a buffer for each request
+#ifdef ENABLE_ALTIMETER
+    std::chrono::time_point<std::chrono::high_resolution_clock> session_start_time_{};
+#endif
+
+    bool handle(stream_socket::await_result result, std::uint16_t slot, std::string& payload);
+    bool process(std::uint16_t slot, std::string& payload);
 
     void notify_of_decline(tateyama::proto::endpoint::request::Request& rq, tateyama::api::server::response* response) {
         switch (rq.command_case()) {
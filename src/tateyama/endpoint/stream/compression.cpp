@@ -0,0 +1,90 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef ENABLE_STREAM_COMPRESSION
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
+#endif
+
+#include "compression.h"
+
+namespace tateyama::endpoint::stream {
+
+bool compressor::supported(compression_type type) noexcept {
+#ifdef ENABLE_STREAM_COMPRESSION
+    return type == compression_type::lz4 || type == compression_type::zstd;
+#else
+    static_cast<void>(type);
+    return false;
+#endif
+}
+
+compressor::~compressor() {
+#ifdef ENABLE_STREAM_COMPRESSION
+    if (context_ != nullptr) {
+        ZSTD_freeCCtx(static_cast<ZSTD_CCtx*>(context_));
+    }
+#endif
+}
+
+bool compressor::compress(std::string_view bytes, std::vector<char>& buffer) {
+    auto offset = buffer.size();
+    std::size_t size = 0;
+#ifdef ENABLE_STREAM_COMPRESSION
+    switch (type_) {
+    case compression_type::lz4:
+    {
+        if (bytes.size() > LZ4_MAX_INPUT_SIZE) {
+            break;
+        }
+        auto length = static_cast<int>(bytes.size());
+        buffer.resize(offset + static_cast<std::size_t>(LZ4_compressBound(length)));
+        auto capacity = static_cast<int>(buffer.size() - offset);
+        auto rv = level_ >= LZ4HC_CLEVEL_MIN ?
+            LZ4_compress_HC(bytes.data(), &buffer.at(offset), length, capacity, level_) :
+            LZ4_compress_default(bytes.data(), &buffer.at(offset), length, capacity);
+        size = rv > 0 ? static_cast<std::size_t>(rv) : 0;
+        break;
+    }
+    case compression_type::zstd:
+    {
+        if (context_ == nullptr) {
+            context_ = ZSTD_createCCtx();
+            if (context_ == nullptr) {
+                break;
+            }
+        }
+        buffer.resize(offset + ZSTD_compressBound(bytes.size()));
+        auto rv = ZSTD_compressCCtx(static_cast<ZSTD_CCtx*>(context_), &buffer.at(offset), buffer.size() - offset,
+                                    bytes.data(), bytes.size(), level_ != 0 ? level_ : ZSTD_CLEVEL_DEFAULT);
+        size = ZSTD_isError(rv) != 0 ? 0 : rv;
+        break;
+    }
+    default:
+        break;
+    }
+#endif
+    if (size == 0 || size >= bytes.size()) {  // not shrunk, sent as they are
+        buffer.resize(offset);
+        stats_.add(bytes.size(), bytes.size());
+        return false;
+    }
+    buffer.resize(offset + size);
+    stats_.add(bytes.size(), size);
+    return true;
+}
+
+}  // namespace tateyama::endpoint::stream
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <string_view>
+#include <vector>
+
+namespace tateyama::endpoint::stream {
+
+/**
+ * @brief the codec of the result set blocks, the values are the same as ResultSetCompression in the endpoint protocol
+ */
+enum class compression_type : std::uint8_t {
+    none = 0U,
+    lz4 = 1U,
+    zstd = 2U,
+};
+
+/**
+ * @brief the statistics of the result set compression, shared by all the sessions.
+ */
+class compression_stats {
+public:
+    void add(std::size_t raw_bytes, std::size_t compressed_bytes) noexcept {
+        raw_bytes_.fetch_add(raw_bytes);
+        compressed_bytes_.fetch_add(compressed_bytes);
+    }
+
+    /**
+     * @brief returns the bytes of the result set frames given to the compressor
+     */
+    [[nodiscard]] std::size_t raw_bytes() const noexcept {
+        return raw_bytes_.load();
+    }
+
+    /**
+     * @brief returns the bytes sent for them, including the blocks sent uncompressed as not shrunk
+     */
+    [[nodiscard]] std::size_t compressed_bytes() const noexcept {
+        return compressed_bytes_.load();
+    }
+
+    /**
+     * @brief returns compressed_bytes() / raw_bytes(), 1 if nothing has been compressed yet
+     */
+    [[nodiscard]] double ratio() const noexcept {
+        auto raw = raw_bytes_.load();
+        return raw > 0 ? static_cast<double>(compressed_bytes_.load()) / static_cast<double>(raw) : 1.0;
+    }
+
+private:
+    std::atomic_size_t raw_bytes_{};
+    std::atomic_size_t compressed_bytes_{};
+};
+
+/**
+ * @brief compresses the blocks of the result set frames of a session.
+ * @details this object is used by the thread draining the send queue of the session only.
+ */
+class compressor {
+public:
+    /**
+     * @brief returns whether the codec has been built in, which requires ENABLE_STREAM_COMPRESSION
+     */
+    [[nodiscard]] static bool supported(compression_type type) noexcept;
+
+    /**
+     * @brief create a compressor
+     * @param type the codec, which should be supported
+     * @param level the compression level, 0 means the default of the codec
+     * @param stats the statistics to be updated
+     */
+    compressor(compression_type type, int level, compression_stats& stats) noexcept : type_(type), level_(level), stats_(stats) {}
+    ~compressor();
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    compressor(compressor const&) = delete;
+    compressor(compressor&&) = delete;
+    compressor& operator = (compressor const&) = delete;
+    compressor& operator = (compressor&&) = delete;
+
+    /**
+     * @brief compress the bytes and append them to the buffer
+     * @return false if the bytes cannot be compressed smaller, the buffer is left unchanged then
+     */
+    bool compress(std::string_view bytes, std::vector<char>& buffer);
+
+    /**
+     * @brief returns the codec
+     */
+    [[nodiscard]] compression_type type() const noexcept {
+        return type_;
+    }
+
+private:
+    const compression_type type_;
+    const int level_;
+    compression_stats& stats_;
+    void* context_{};  // ZSTD_CCtx, created at the first compression
+};
+
+}  // namespace tateyama::endpoint::stream
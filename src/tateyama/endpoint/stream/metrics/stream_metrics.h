@@ -16,12 +16,17 @@
 #pragma once
 
 #include <atomic>
+#include <functional>
+#include <memory>
 
 #include <tateyama/framework/resource.h>
 #include <tateyama/framework/environment.h>
 #include <tateyama/metrics/metrics_store.h>
 
 #include "tateyama/metrics/resource/bridge.h"
+#include "tateyama/endpoint/stream/zerocopy.h"
+#include "tateyama/endpoint/stream/send_queue.h"
+#include "tateyama/endpoint/stream/compression.h"
 
 namespace tateyama::endpoint::stream::bootstrap {
     class stream_listener;
@@ -34,6 +39,21 @@ using namespace std::literals::string_literals;
  * @brief an object in charge of metrics chores
  */
 class stream_metrics {
+    // for the aggregations reading the statistics directly
+    class stats_aggregator : public tateyama::metrics::metrics_aggregator {
+    public:
+        explicit stats_aggregator(std::function<double(void)> value) : value_(std::move(value)) {
+        }
+        stats_aggregator() = delete;
+        void add(tateyama::metrics::metrics_metadata const&, double) override {
+        }
+        result_type aggregate() override {
+            return value_();
+        }
+      private:
+        std::function<double(void)> value_;
+    };
+
   public:
     explicit stream_metrics(tateyama::framework::environment& env)
         : metrics_store_(env.resource_repository().find<::tateyama::metrics::resource::bridge>()->metrics_store()),
@@ -56,6 +76,27 @@ class stream_metrics {
 
     std::atomic_long count_{0};
 
+    void set_zerocopy_stats(const std::shared_ptr<zerocopy_stats>& stats) noexcept {
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"stream_zerocopy_bytes",
+                                                                                   "result set bytes sent with MSG_ZEROCOPY",
+                                                                                   [stats](){return std::make_unique<stats_aggregator>([stats](){return static_cast<double>(stats->bytes());});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"stream_zerocopy_fallbacks",
+                                                                                   "number of occasions where result set frames have been copied instead of MSG_ZEROCOPY",
+                                                                                   [stats](){return std::make_unique<stats_aggregator>([stats](){return static_cast<double>(stats->fallbacks());});}});
+    }
+    void set_send_queue_stats(const std::shared_ptr<send_queue_stats>& stats) noexcept {
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"stream_send_queue_size",
+                                                                                   "result set bytes queued to be sent in the TCP sessions",
+                                                                                   [stats](){return std::make_unique<stats_aggregator>([stats](){return static_cast<double>(stats->queued_bytes());});}});
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"stream_send_queue_stalls",
+                                                                                   "number of occasions where result set writers have waited for the send queue to be drained",
+                                                                                   [stats](){return std::make_unique<stats_aggregator>([stats](){return static_cast<double>(stats->stalls());});}});
+    }
+    void set_compression_stats(const std::shared_ptr<compression_stats>& stats) noexcept {
+        metrics_store_.register_aggregation(tateyama::metrics::metrics_aggregation{"stream_compression_ratio",
+                                                                                   "ratio of the result set bytes sent to the bytes before compression",
+                                                                                   [stats](){return std::make_unique<stats_aggregator>([stats](){return stats->ratio();});}});
+    }
     void increase() noexcept {
         count_++;
         session_count_ = static_cast<double>(count_.load());
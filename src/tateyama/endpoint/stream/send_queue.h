@@ -0,0 +1,238 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace tateyama::endpoint::stream {
+
+/**
+ * @brief the statistics of the send queues, shared by all the sessions.
+ */
+class send_queue_stats {
+public:
+    void add_queued(std::size_t bytes) noexcept {
+        queued_bytes_.fetch_add(bytes);
+    }
+    void sub_queued(std::size_t bytes) noexcept {
+        queued_bytes_.fetch_sub(bytes);
+    }
+    void add_stall() noexcept {
+        stalls_.fetch_add(1);
+    }
+
+    /**
+     * @brief returns the bytes queued in all the sessions and not yet sent
+     */
+    [[nodiscard]] std::size_t queued_bytes() const noexcept {
+        return queued_bytes_.load();
+    }
+
+    /**
+     * @brief returns the number of the occasions where the writers have waited for the queue to be drained
+     */
+    [[nodiscard]] std::size_t stalls() const noexcept {
+        return stalls_.load();
+    }
+
+private:
+    std::atomic_size_t queued_bytes_{};
+    std::atomic_size_t stalls_{};
+};
+
+/**
+ * @brief the queue of the result set frames to be sent by a session, written by multiple writers
+ *  and drained by a single sender at a time.
+ * @details the writers fill the frames into the entries taken from this queue and push them without a lock.
+ *  The sender takes all the entries pushed at once. A writer waits if the bytes queued exceed the limit,
+ *  until the sender brings them under the limit.
+ */
+class send_queue {
+public:
+    /**
+     * @brief the default limit of the bytes queued in a session
+     */
+    static constexpr std::size_t default_limit = 16UL * 1024UL * 1024UL;
+
+    /**
+     * @brief the number of the entries kept for the reuse
+     */
+    static constexpr std::size_t max_free_entries = 64;
+
+    /**
+     * @brief the entry capacity beyond which the entry is not kept for the reuse
+     */
+    static constexpr std::size_t max_free_entry_capacity = 1024UL * 1024UL;
+
+    /**
+     * @brief a buffer of the frames of a slot
+     */
+    class entry {
+    public:
+        std::vector<char> bytes_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::uint16_t slot_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        bool response_{};  // NOLINT(misc-non-private-member-variables-in-classes) carries a frame other than the records, which is neither compressed nor charged to the credit
+        entry* next_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    };
+
+    explicit send_queue(std::size_t limit = default_limit, send_queue_stats* stats = nullptr) noexcept : limit_(limit), stats_(stats) {}
+    ~send_queue() {
+        auto* e = head_.exchange(nullptr);
+        while (e != nullptr) {
+            auto* next = e->next_;
+            sent(e->bytes_.size());
+            delete e;  // NOLINT(cppcoreguidelines-owning-memory)
+            e = next;
+        }
+        for (auto* e : free_) {
+            delete e;  // NOLINT(cppcoreguidelines-owning-memory)
+        }
+    }
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    send_queue(send_queue const&) = delete;
+    send_queue(send_queue&&) = delete;
+    send_queue& operator = (send_queue const&) = delete;
+    send_queue& operator = (send_queue&&) = delete;
+
+    /**
+     * @brief returns an empty entry for the slot
+     */
+    entry* allocate(std::uint16_t slot) {
+        entry* e{};
+        {
+            std::lock_guard<std::mutex> lock(free_mutex_);
+            if (!free_.empty()) {
+                e = free_.back();
+                free_.pop_back();
+            }
+        }
+        if (e == nullptr) {
+            e = new entry();  // NOLINT(cppcoreguidelines-owning-memory)
+        }
+        e->bytes_.clear();
+        e->slot_ = slot;
+        e->response_ = false;
+        e->next_ = nullptr;
+        return e;
+    }
+
+    /**
+     * @brief returns the entry which has been sent or discarded
+     */
+    void release(entry* e) {
+        if (e->bytes_.capacity() <= max_free_entry_capacity) {
+            std::lock_guard<std::mutex> lock(free_mutex_);
+            if (free_.size() < max_free_entries) {
+                free_.emplace_back(e);
+                return;
+            }
+        }
+        delete e;  // NOLINT(cppcoreguidelines-owning-memory)
+    }
+
+    /**
+     * @brief wait until the bytes queued come under the limit, called by the writer before push()
+     * @param timeout the maximum time to wait
+     * @return false if the timeout has passed
+     */
+    bool wait_for_room(std::chrono::milliseconds timeout) {
+        if (queued_bytes_.load() < limit_) {
+            return true;
+        }
+        if (stats_ != nullptr) {
+            stats_->add_stall();
+        }
+        std::unique_lock<std::mutex> lock(room_mutex_);
+        return room_condition_.wait_for(lock, timeout, [this](){ return queued_bytes_.load() < limit_; });
+    }
+
+    /**
+     * @brief push the entry, which is to be sent by the sender
+     */
+    void push(entry* e) noexcept {
+        auto size = e->bytes_.size();
+        queued_bytes_.fetch_add(size);
+        if (stats_ != nullptr) {
+            stats_->add_queued(size);
+        }
+        e->next_ = head_.load(std::memory_order_relaxed);
+        while (!head_.compare_exchange_weak(e->next_, e));
+    }
+
+    /**
+     * @brief take all the entries pushed, called by the sender
+     * @return the entries linked by next_ in the order pushed
+     */
+    entry* take_all() noexcept {
+        entry* e = head_.exchange(nullptr, std::memory_order_acquire);
+        entry* reversed{};
+        while (e != nullptr) {
+            auto* next = e->next_;
+            e->next_ = reversed;
+            reversed = e;
+            e = next;
+        }
+        return reversed;
+    }
+
+    /**
+     * @brief notify that the entries of the bytes have been sent or discarded, called by the sender
+     */
+    void sent(std::size_t bytes) {
+        queued_bytes_.fetch_sub(bytes);
+        if (stats_ != nullptr) {
+            stats_->sub_queued(bytes);
+        }
+        {
+            std::lock_guard<std::mutex> lock(room_mutex_);
+        }
+        room_condition_.notify_all();
+    }
+
+    /**
+     * @brief returns whether some entries have been pushed and not taken by the sender yet
+     */
+    [[nodiscard]] bool pushed() const noexcept {
+        return head_.load() != nullptr;
+    }
+
+    /**
+     * @brief returns the bytes queued and not sent yet
+     */
+    [[nodiscard]] std::size_t queued_bytes() const noexcept {
+        return queued_bytes_.load();
+    }
+
+private:
+    const std::size_t limit_;
+    send_queue_stats* stats_;
+    std::atomic<entry*> head_{};
+    std::atomic_size_t queued_bytes_{};
+    std::mutex room_mutex_{};
+    std::condition_variable room_condition_{};
+    std::mutex free_mutex_{};
+    std::vector<entry*> free_{};
+};
+
+}  // namespace tateyama::endpoint::stream
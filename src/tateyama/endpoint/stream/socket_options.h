@@ -0,0 +1,110 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <cerrno>
+#include <cstdint>
+
+#include <glog/logging.h>
+#include <tateyama/logging.h>
+#include "tateyama/logging_helper.h"
+
+namespace tateyama::endpoint::stream {
+
+/**
+ * @brief the options of the sockets of stream_endpoint, given by the stream_endpoint section of the configuration.
+ * @details 0 given to the sizes and the intervals means the default of the kernel.
+ */
+class socket_options {
+public:
+    bool tcp_nodelay_{true};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int send_buffer_size_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int receive_buffer_size_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    bool tcp_keepalive_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int tcp_keepalive_idle_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int tcp_keepalive_interval_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int tcp_keepalive_count_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    int busy_poll_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    bool tcp_quickack_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    bool reuseport_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    bool ipv6_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+
+    /**
+     * @brief apply the options to the listen socket before bind(), the buffer sizes are set here
+     *  so that the window scale negotiated in the handshake reflects them.
+     */
+    void apply_to_listener(int socket) const {
+        const int enable = 1;
+        set(socket, SOL_SOCKET, SO_REUSEADDR, enable, "SO_REUSEADDR");
+        if (reuseport_) {
+            set(socket, SOL_SOCKET, SO_REUSEPORT, enable, "SO_REUSEPORT");
+        }
+        if (ipv6_) {
+            set(socket, IPPROTO_IPV6, IPV6_V6ONLY, 0, "IPV6_V6ONLY");  // accept IPv4 connections as well
+        }
+        apply_buffer_sizes(socket);
+    }
+
+    /**
+     * @brief apply the options to the socket accepted
+     */
+    void apply(int socket) const {
+        if (tcp_nodelay_) {
+            set(socket, SOL_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+        }
+        apply_buffer_sizes(socket);
+        if (tcp_keepalive_) {
+            set(socket, SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE");
+            if (tcp_keepalive_idle_ > 0) {
+                set(socket, SOL_TCP, TCP_KEEPIDLE, tcp_keepalive_idle_, "TCP_KEEPIDLE");
+            }
+            if (tcp_keepalive_interval_ > 0) {
+                set(socket, SOL_TCP, TCP_KEEPINTVL, tcp_keepalive_interval_, "TCP_KEEPINTVL");
+            }
+            if (tcp_keepalive_count_ > 0) {
+                set(socket, SOL_TCP, TCP_KEEPCNT, tcp_keepalive_count_, "TCP_KEEPCNT");
+            }
+        }
+        if (busy_poll_ > 0) {
+            set(socket, SOL_SOCKET, SO_BUSY_POLL, busy_poll_, "SO_BUSY_POLL");
+        }
+        if (tcp_quickack_) {  // set again by stream_socket after each receive, as the kernel clears it
+            set(socket, SOL_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+        }
+    }
+
+private:
+    void apply_buffer_sizes(int socket) const {
+        if (send_buffer_size_ > 0) {
+            set(socket, SOL_SOCKET, SO_SNDBUF, send_buffer_size_, "SO_SNDBUF");
+        }
+        if (receive_buffer_size_ > 0) {
+            set(socket, SOL_SOCKET, SO_RCVBUF, receive_buffer_size_, "SO_RCVBUF");
+        }
+    }
+    static void set(int socket, int level, int name, int value, const char* option) {
+        if (setsockopt(socket, level, name, &value, sizeof(value)) < 0) {
+            LOG_LP(ERROR) << "setsockopt(" << option << ") fail, errno = " << errno;
+        }
+    }
+};
+
+}  // namespace tateyama::endpoint::stream
@@ -21,17 +21,32 @@
 namespace tateyama::endpoint::stream {
 
 stream_socket::stream_socket(int socket, std::string_view info, connection_socket* envelope)
-    : socket_(socket), connection_info_(info), envelope_(envelope) {
-    const int enable = 1;
-    if (setsockopt(socket, SOL_TCP, TCP_NODELAY, &enable, sizeof(enable)) < 0) {
-        LOG_LP(ERROR) << "setsockopt() fail";
-    }
+    : socket_(socket), connection_info_(info), envelope_(envelope), zerocopy_stats_(envelope->zerocopy_stats_),
+      send_queue_stats_(envelope->send_queue_stats_), send_queue_(envelope->send_queue_limit_, send_queue_stats_.get()) {
+    tcp_quickack_ = envelope->options_.tcp_quickack_;
     sending_.resize(slot_size_);
+    credits_.resize(slot_size_);
+    generations_.resize(slot_size_);
     envelope_->num_open_.fetch_add(1);
 }
 
+void stream_socket::enable_compression(compression_type type) {
+    if (type == compression_type::none || !envelope_->compression_stats_ || !compressor::supported(type)) {
+        return;
+    }
+    // the sender thread is started by the first result set frames, which follow the handshake
+    compressor_ = std::make_unique<compressor>(type, envelope_->compression_level_, *envelope_->compression_stats_);
+}
+
 stream_socket::~stream_socket() {
+    stop_sender();
     close();
+    for (auto&& [slot, entries] : pending_) {
+        for (auto* e : entries) {
+            send_queue_.sent(e->bytes_.size());
+            send_queue_.release(e);
+        }
+    }
     envelope_->num_open_.fetch_sub(1);
     envelope_->notify_of_close();
 }
@@ -17,6 +17,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
@@ -26,13 +27,23 @@
 #include <string_view>
 #include <stdexcept>
 #include <vector>
+#include <array>
 #include <iterator>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <queue>
+#include <deque>
+#include <map>
 #include <chrono>
 #include <functional>
+#include <thread>
+#include <optional>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <cerrno>
+#include <cstring>
 #include <arpa/inet.h>
 
 
@@ -40,6 +51,11 @@
 
 #include <tateyama/logging.h>
 #include "tateyama/logging_helper.h"
+#include "uring.h"
+#include "zerocopy.h"
+#include "send_queue.h"
+#include "socket_options.h"
+#include "compression.h"
 
 namespace tateyama::endpoint::stream {
 
@@ -54,6 +70,7 @@ class stream_socket
     static constexpr unsigned char REQUEST_RESULT_SET_BYE_OK = 3;
     static constexpr unsigned char REQUEST_SESSION_BYE = 4;
     static constexpr unsigned char REQUEST_ALIVE_CHECK = 5;
+    static constexpr unsigned char REQUEST_RESULT_SET_CREDIT = 6;
 
     static constexpr unsigned char RESPONSE_SESSION_PAYLOAD = 1;
     static constexpr unsigned char RESPONSE_RESULT_SET_PAYLOAD = 2;
@@ -63,6 +80,7 @@ class stream_socket
     static constexpr unsigned char RESPONSE_RESULT_SET_BYE = 6;
     static constexpr unsigned char RESPONSE_SESSION_BODYHEAD = 7;
     static constexpr unsigned char RESPONSE_SESSION_BYE_OK = 8;
+    static constexpr unsigned char RESPONSE_RESULT_SET_COMPRESSED_PAYLOAD = 9;
 
     static constexpr unsigned int SLOT_SIZE = 16;
 
@@ -117,6 +135,11 @@ public:
          * @brief the message received is in an illegal format.
          */
         illegal_message,
+
+        /**
+         * @brief no complete request message is available without blocking, used by try_await().
+         */
+        would_block,
     };
 
     explicit stream_socket(int socket, std::string_view info, connection_socket* envelope);
@@ -132,6 +155,56 @@ public:
         return await(info, slot, payload);
     }
 
+    /**
+     * @brief receive a request message without blocking, used by the io threads which own many sockets.
+     * @details it receives the bytes available on the socket by a single recv() at most, and decodes
+     *  the frames from the bytes received, so that the caller can call this again until would_block is returned.
+     * @return would_block if no complete request message is available
+     */
+    [[nodiscard]] await_result try_await(std::uint16_t& slot, std::string& payload) {
+        bool received = false;
+        while (true) {
+            unsigned char info{};
+            if (decode_frame(info, slot, payload)) {
+                if (auto rv = accept_frame(info, slot, payload); rv) {
+                    return rv.value();
+                }
+                continue;
+            }
+            if (received) {
+                return await_result::would_block;
+            }
+            switch (fill_inbound()) {
+            case fill_result::received:
+                received = true;
+                break;
+            case fill_result::would_block:
+                return await_result::would_block;
+            case fill_result::closed:
+                return await_result::socket_closed;
+            }
+        }
+    }
+
+    /**
+     * @brief discard the urgent data which the client has sent.
+     * @return timeout if the urgent data has been discarded, socket_closed if the socket has been closed
+     */
+    [[nodiscard]] await_result discard_urgent_data() const {
+        unsigned char buf{};
+        if (::recv(socket_, &buf, 1, MSG_OOB) < 0) {
+            return await_result::socket_closed;
+        }
+        return await_result::timeout;
+    }
+
+    /**
+     * @brief returns the socket descriptor, to be registered in the io threads
+     */
+    [[nodiscard]] int native_handle() const noexcept {
+        return socket_;
+    }
+
     void send(std::uint16_t slot, std::string_view payload, bool body) {  // for RESPONSE_SESSION_PAYLOAD
         if (body) {
             VLOG_LP(log_trace) << "<-- RESPONSE_SESSION_PAYLOAD " << static_cast<std::uint32_t>(slot);
@@ -142,15 +215,29 @@ public:
         }
     }
     void send_result_set_hello(std::uint16_t slot, std::string_view name) {  // for RESPONSE_RESULT_SET_HELLO
-        if (sending_.at(slot) != sending_status::sending) {
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
             sending_.at(slot) = sending_status::sending;
+            credits_.at(slot) = window_;
+            generations_.at(slot)++;  // counted by the client as well, to tag the credit
         }
         VLOG_LP(log_trace)  << "<-- RESPONSE_RESULT_SET_HELLO " << static_cast<std::uint32_t>(slot) << ", " << name;
         send_response(RESPONSE_RESULT_SET_HELLO, slot, name);
     }
+    /**
+     * @brief send RESPONSE_RESULT_SET_BYE through the send queue, so that it follows the result set frames of the slot
+     *  but does not wait for the frames of the other slots.
+     */
     void send_result_set_bye(std::uint16_t slot) {  // for RESPONSE_RESULT_SET_BYE
         VLOG_LP(log_trace) << "<-- RESPONSE_RESULT_SET_BYE " << static_cast<std::uint32_t>(slot);
-        send_response(RESPONSE_RESULT_SET_BYE, slot, "");
+        auto* entry = allocate_entry(slot);
+        entry->response_ = true;
+        entry->bytes_.resize(response_header_size);
+        entry->bytes_.at(0) = static_cast<char>(RESPONSE_RESULT_SET_BYE);
+        put_uint16(&entry->bytes_.at(1), slot);
+        put_uint32(&entry->bytes_.at(1 + sizeof(std::uint16_t)), 0);
+        send_queue_.push(entry);
+        wake_sender();
     }
     void send_session_bye_ok() {  // for RESPONSE_SESSION_BYE_OK
         VLOG_LP(log_trace) << "<-- RESPONSE_SESSION_BYE_OK ";
@@ -158,52 +245,123 @@ public:
     }
 
     void send(std::uint16_t slot, unsigned char writer, std::string_view payload) { // for RESPONSE_RESULT_SET_PAYLOAD
-        if (sending_.at(slot) != sending_status::sending) {
-            if (sending_.at(slot) == sending_status::closed) {
+        send(slot, writer, &payload, 1);
+    }
+    void send(std::uint16_t slot, unsigned char writer, std::string_view const* payloads, std::size_t count) { // for RESPONSE_RESULT_SET_PAYLOAD of multiple records
+        auto* entry = allocate_entry(slot);
+        for (std::size_t i = 0; i < count; i++) {
+            append_record(entry->bytes_, slot, writer, payloads[i]);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
+        send(slot, writer, entry);
+    }
+
+    /**
+     * @brief queue the result set frames in the entry, which are sent by the sender thread of this session.
+     * @details the writer does not wait for the credit of the slot, as the sender holds the entries of a slot
+     *  without credit until the client grants it. The writer waits only while the bytes queued in this session
+     *  exceed the limit, which bounds the memory of the session.
+     * @param entry the entry taken by allocate_entry(), the ownership of which is passed to this object
+     */
+    void send(std::uint16_t slot, unsigned char writer, send_queue::entry* entry) {
+        if (!is_sending(slot)) {
+            send_queue_.release(entry);
+            if (finish_closed_slot(slot)) {
                 VLOG_LP(log_trace) << " == send early eor to the client as client closed the result set " << static_cast<std::uint32_t>(slot) << ", " << static_cast<std::uint32_t>(writer);
                 send_result_set_delimiter(slot, writer);
                 send_result_set_bye(slot);
-                sending_.at(slot) = sending_status::finished;
             }
             return;
         }
-        VLOG_LP(log_trace) << (!payload.empty() ? "<-- RESPONSE_RESULT_SET_PAYLOAD " : "<-- RESPONSE_RESULT_SET_COMMIT ") << static_cast<std::uint32_t>(slot) << ", " << static_cast<std::uint32_t>(writer);
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (session_closed_) {
-            return;
+        while (!send_queue_.wait_for_room(std::chrono::milliseconds(TIMEOUT_MS))) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (session_closed_ || socket_closed_) {
+                lock.unlock();
+                send_queue_.release(entry);
+                return;
+            }
         }
-        if (!payload.empty()) {
-            char buffer[sizeof(std::uint16_t)];  // NOLINT
-            unsigned char info = RESPONSE_RESULT_SET_PAYLOAD;
+        send_queue_.push(entry);
+        wake_sender();
+    }
+    void send_result_set_delimiter(std::uint16_t slot, unsigned char writer) {
+        auto* entry = allocate_entry(slot);
+        entry->response_ = true;  // the early eor of the slot closed by the client
+        entry->bytes_.resize(result_set_header_size);
+        put_result_set_header(entry->bytes_.data(), slot, writer, 0);
+        send_queue_.push(entry);
+        wake_sender();
+    }
 
-            ::send(socket_, &info, 1, MSG_MORE | MSG_NOSIGNAL);
+    /**
+     * @brief compress the result set frames sent afterwards by the codec agreed in the handshake
+     * @param type the codec, none leaves the frames uncompressed
+     */
+    void enable_compression(compression_type type);
 
-            buffer[0] = slot & 0xff;  // NOLINT
-            buffer[1] = (slot / 0x100) & 0xff;  // NOLINT
-            ::send(socket_, &buffer[0], sizeof(std::uint16_t), MSG_MORE | MSG_NOSIGNAL);
-            ::send(socket_, &writer, 1, MSG_MORE | MSG_NOSIGNAL);
+    /**
+     * @brief returns the codec compressing the result set frames
+     */
+    [[nodiscard]] compression_type compression() const noexcept {
+        return compressor_ ? compressor_->type() : compression_type::none;
+    }
 
-            send_payload(payload, true);
-        }
-        // To preserve compatibility with previous editions
-        send_result_set_delimiter(slot, writer);
+    /**
+     * @brief send the result set frames of each slot within the credit granted by the client
+     * @param window the credit given to a slot when its result set begins, in bytes, 0 disables the flow control
+     */
+    void enable_flow_control(std::uint32_t window) {
+        std::unique_lock<std::mutex> lock(slot_mutex_);
+        window_ = window;
+        credits_.assign(slot_size_, window);
     }
-    void send_result_set_delimiter(std::uint16_t slot, unsigned char writer) const {
-        char buffer[sizeof(std::uint32_t)];  // NOLINT
-        unsigned char info = RESPONSE_RESULT_SET_PAYLOAD;
 
-        ::send(socket_, &info, 1, MSG_MORE | MSG_NOSIGNAL);
+    /**
+     * @brief returns an empty entry to which the writer of the slot appends the result set frames
+     */
+    send_queue::entry* allocate_entry(std::uint16_t slot) {
+        return send_queue_.allocate(slot);
+    }
 
-        buffer[0] = slot & 0xff;  // NOLINT
-        buffer[1] = (slot / 0x100) & 0xff;  // NOLINT
-        ::send(socket_, &buffer[0], sizeof(std::uint16_t), MSG_MORE | MSG_NOSIGNAL);
-        ::send(socket_, &writer, 1, MSG_MORE | MSG_NOSIGNAL);
+    /**
+     * @brief returns the entry not to be sent
+     */
+    void release_entry(send_queue::entry* entry) {
+        send_queue_.release(entry);
+    }
 
-        buffer[0] = 0;  // NOLINT
-        buffer[1] = 0;  // NOLINT
-        buffer[2] = 0;  // NOLINT
-        buffer[3] = 0;  // NOLINT
-        ::send(socket_, &buffer[0], sizeof(std::uint32_t), MSG_NOSIGNAL);
+    /**
+     * @brief reserve the header of a RESPONSE_RESULT_SET_PAYLOAD frame, the payload is to be appended after it
+     * @return the offset of the frame, to be given to close_record()
+     */
+    static std::size_t open_record(std::vector<char>& bytes) {
+        auto offset = bytes.size();
+        bytes.resize(offset + result_set_header_size);
+        return offset;
+    }
+
+    /**
+     * @brief complete the frame opened by open_record() and append a delimiter frame, which is sent
+     *  after each record to preserve compatibility with previous editions.
+     *  The frame opened is removed if no payload has been appended.
+     */
+    static void close_record(std::vector<char>& bytes, std::size_t offset, std::uint16_t slot, unsigned char writer) {
+        auto length = bytes.size() - offset - result_set_header_size;
+        VLOG_LP(log_trace) << (length > 0 ? "<-- RESPONSE_RESULT_SET_PAYLOAD " : "<-- RESPONSE_RESULT_SET_COMMIT ") << static_cast<std::uint32_t>(slot) << ", " << static_cast<std::uint32_t>(writer);
+        if (length > 0) {
+            put_result_set_header(&bytes.at(offset), slot, writer, length);
+            offset = bytes.size();
+            bytes.resize(offset + result_set_header_size);
+        }
+        put_result_set_header(&bytes.at(offset), slot, writer, 0);
+    }
+
+    /**
+     * @brief append the frames of a record
+     */
+    static void append_record(std::vector<char>& bytes, std::uint16_t slot, unsigned char writer, std::string_view payload) {
+        auto offset = open_record(bytes);
+        bytes.insert(bytes.end(), payload.begin(), payload.end());
+        close_record(bytes, offset, slot, writer);
     }
 
     void close() {
@@ -220,6 +378,8 @@ public:
             VLOG_LP(log_trace) << "enlarge srot to " << (index + 1);
             slot_size_ = index + 1;
             sending_.resize(slot_size_);
+            credits_.resize(slot_size_, window_);
+            generations_.resize(slot_size_);
         }
     }
 
@@ -227,18 +387,32 @@ public:
         return connection_info_;
     }
 
-    [[nodiscard]] inline bool is_sending(std::uint16_t slot) const {
+    [[nodiscard]] bool is_sending(std::uint16_t slot) {
+        std::unique_lock<std::mutex> lock(slot_mutex_);
         return sending_.at(slot) == sending_status::sending;
     }
 
 private:
     int socket_;
     static constexpr std::size_t N_FDS = 1;
+    static constexpr std::size_t inbound_chunk_size = 64UL * 1024UL;
+    static constexpr std::size_t inbound_retained_size = 1024UL * 1024UL;
+    // info, slot and length
+    static constexpr std::size_t response_header_size = 1 + sizeof(std::uint16_t) + sizeof(std::uint32_t);
+    // info, slot, writer and length
+    static constexpr std::size_t result_set_header_size = 1 + sizeof(std::uint16_t) + 1 + sizeof(std::uint32_t);
+    // the number of entries and the bytes sent by a sendmsg() from the send queue at most
+    static constexpr std::size_t max_entries_per_send = 64;
+    static constexpr std::size_t max_bytes_per_send = 4UL * 1024UL * 1024UL;
+    // the frames of a slot are compressed by the blocks of this size at most, and the smaller blocks are sent as they are
+    static constexpr std::size_t compression_block_size = 256UL * 1024UL;
+    static constexpr std::size_t min_compression_block_size = 4UL * 1024UL;
     static constexpr int TIMEOUT_MS = 2000;  // 2000(mS)
     struct pollfd fds_[N_FDS]{};  // NOLINT
 
     bool session_closed_{false};
     bool socket_closed_{false};
+    // the status and the credit of the slots are guarded by slot_mutex_
     std::vector<sending_status> sending_{};
     std::size_t slot_size_{SLOT_SIZE};
     std::string connection_info_{};
@@ -246,152 +420,586 @@ private:
     std::mutex slot_mutex_{};
     connection_socket* envelope_;
 
+    // the bytes received but not yet decoded are in [inbound_head_, inbound_tail_)
+    std::vector<char> inbound_{};
+    std::size_t inbound_head_{};
+    std::size_t inbound_tail_{};
+    bool tcp_quickack_{};
+#ifdef ENABLE_IO_URING
+    // created when a large payload is sent first
+    std::unique_ptr<uring_sender> uring_sender_{};
+#endif
+    // given if MSG_ZEROCOPY is enabled, and the sender is created when a large entry is sent first
+    std::shared_ptr<zerocopy_stats> zerocopy_stats_{};
+    std::unique_ptr<zerocopy_sender> zerocopy_sender_{};
+
+    // the result set frames written by the writers, drained by the sender thread
+    std::shared_ptr<send_queue_stats> send_queue_stats_;
+    send_queue send_queue_;
+    // the entries taken from the send queue and not sent yet, by slot, accessed by the sender thread only
+    std::map<std::uint16_t, std::deque<send_queue::entry*>> pending_{};
+    // started by the first entry pushed, and woken by the entries pushed afterwards
+    std::thread sender_{};
+    std::mutex sender_mutex_{};
+    std::condition_variable sender_condition_{};
+    bool sender_woken_{};
+    bool sender_stopped_{};
+    // the number of the responses waiting for mutex_, to which the sender thread gives way
+    std::atomic_uint32_t responses_waiting_{};
+    // given if the compression has been agreed in the handshake, used by the sender thread only
+    std::unique_ptr<compressor> compressor_{};
+
+    // the bytes of the result set frames each slot can queue, granted by REQUEST_RESULT_SET_CREDIT, used if window_ > 0
+    std::uint32_t window_{};
+    std::vector<std::int64_t> credits_{};
+    // the number of RESPONSE_RESULT_SET_HELLO sent for each slot, which tags the credit granted for the result set
+    std::vector<std::uint32_t> generations_{};
+
+    /**
+     * @brief receive a request message, the frames are decoded from the bytes received by a recv() as many as available,
+     *  thus the pipelined requests are served without further system calls.
+     */
     await_result await(unsigned char& info, std::uint16_t& slot, std::string& payload) {
         fds_[0].fd = socket_;               // NOLINT
         fds_[0].events = POLLIN | POLLPRI;  // NOLINT
-        fds_[0].revents = 0;                // NOLINT
         while (true) {
+            if (decode_frame(info, slot, payload)) {
+                if (auto rv = accept_frame(info, slot, payload); rv) {
+                    return rv.value();
+                }
+                continue;
+            }
+
+            fds_[0].revents = 0;                // NOLINT
             if (auto rv = poll(fds_, N_FDS, TIMEOUT_MS); !(rv > 0)) {  // NOLINT
                 if (rv == 0) {
                     return await_result::timeout;
                 }
+                if (errno == EINTR) {
+                    continue;
+                }
                 throw std::runtime_error("error in poll");
             }
 
             if (fds_[0].revents & POLLPRI) {  // NOLINT
-                unsigned char buf{};
-                if (::recv (socket_, &buf, 1, MSG_OOB) < 0) {
-                    return await_result::socket_closed;
-                }
-                return await_result::timeout;
+                return discard_urgent_data();
             }
-            if (fds_[0].revents & POLLIN) {  // NOLINT
-                if (auto size_i = ::recv(socket_, &info, 1, 0); size_i == 0) {
-                    VLOG_LP(log_trace) << "socket is closed by the client";
+            if (fds_[0].revents & (POLLIN | POLLHUP | POLLERR)) {  // NOLINT
+                if (fill_inbound() == fill_result::closed) {
                     return await_result::socket_closed;
                 }
+            }
+        }
+    }
+
+    enum class fill_result : std::uint8_t {
+        received,
+        would_block,
+        closed,
+    };
+
+    /**
+     * @brief receive the bytes available on the socket into the inbound buffer by a single recv().
+     * @details the bytes not yet decoded are moved to the front of the buffer, and the buffer is enlarged
+     *  if a chunk cannot be received after them, e.g. while receiving a large request.
+     */
+    fill_result fill_inbound() {
+        if (inbound_head_ == inbound_tail_ && inbound_.size() > inbound_retained_size) {
+            std::vector<char>(inbound_chunk_size).swap(inbound_);  // release the buffer enlarged by a large request
+        }
+        if (inbound_.size() - inbound_tail_ < inbound_chunk_size) {
+            std::copy(inbound_.begin() + static_cast<std::ptrdiff_t>(inbound_head_), inbound_.begin() + static_cast<std::ptrdiff_t>(inbound_tail_), inbound_.begin());
+            inbound_tail_ -= inbound_head_;
+            inbound_head_ = 0;
+            if (inbound_.size() - inbound_tail_ < inbound_chunk_size) {
+                inbound_.resize(std::max(inbound_tail_ + inbound_chunk_size, pending_frame_size()));
+            }
+        }
+        auto size = ::recv(socket_, inbound_.data() + inbound_tail_, inbound_.size() - inbound_tail_, MSG_DONTWAIT);  // NOLINT
+        if (size == 0) {
+            VLOG_LP(log_trace) << "socket is closed by the client";
+            return fill_result::closed;
+        }
+        if (size < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return fill_result::would_block;
+            }
+            VLOG_LP(log_trace) << "socket is closed by the client abnormally";
+            return fill_result::closed;
+        }
+        inbound_tail_ += static_cast<std::size_t>(size);
+        if (tcp_quickack_) {  // the kernel may have fallen back to the delayed ack
+            const int enable = 1;
+            setsockopt(socket_, SOL_TCP, TCP_QUICKACK, &enable, sizeof(enable));
+        }
+        return fill_result::received;
+    }
+
+    static bool has_payload(unsigned char info) noexcept {
+        return info == REQUEST_SESSION_PAYLOAD || info == REQUEST_RESULT_SET_BYE_OK || info == REQUEST_SESSION_HELLO || info == REQUEST_SESSION_BYE || info == REQUEST_RESULT_SET_CREDIT;
+    }
+
+    /**
+     * @brief act on the frame received, whose payload has been received if any.
+     * @return the result to be returned to the caller of await(), or nullopt if the frame has been consumed here
+     */
+    std::optional<await_result> accept_frame(unsigned char info, std::uint16_t slot, std::string_view payload) {
+        switch (info) {
+        case REQUEST_SESSION_PAYLOAD:
+            VLOG_LP(log_trace) << "--> REQUEST_SESSION_PAYLOAD " << static_cast<std::uint32_t>(slot);
+            return await_result::payload;
+        case REQUEST_RESULT_SET_BYE_OK:
+            VLOG_LP(log_trace) << "--> REQUEST_RESULT_SET_BYE_OK " << static_cast<std::uint32_t>(slot);
+            release_slot(slot);
+            return std::nullopt;
+        case REQUEST_SESSION_HELLO:  // for backward compatibility
+        {
+            std::string session_name = std::to_string(-1);  // dummy as this session will be closed soon.
+            send_response(RESPONSE_SESSION_HELLO_OK, 0, session_name);
+            return std::nullopt;
+        }
+        case REQUEST_SESSION_BYE:
+        {
+            VLOG_LP(log_trace) << "--> REQUEST_SESSION_BYE ";
+            std::unique_lock<std::mutex> lock(mutex_);
+            session_closed_ = true;
+            return await_result::termination_request;
+        }
+        case REQUEST_ALIVE_CHECK:
+            VLOG_LP(log_trace) << "--> REQUEST_ALIVE_CHECK ";
+            return std::nullopt;
+        case REQUEST_RESULT_SET_CREDIT:
+            VLOG_LP(log_trace) << "--> REQUEST_RESULT_SET_CREDIT " << static_cast<std::uint32_t>(slot);
+            grant_credit(slot, payload);
+            return std::nullopt;
+        default:
+            LOG_LP(ERROR) << "illegal message type " << static_cast<std::uint32_t>(info);
+            close();
+            return await_result::illegal_message;  // to exit this thread
+        }
+    }
+
+    /**
+     * @brief decode a frame from the bytes received
+     * @details the payload is copied into the string given, whose capacity is reused if the caller recycles it
+     * @return false if the bytes of a complete frame have not been received yet
+     */
+    bool decode_frame(unsigned char& info, std::uint16_t& slot, std::string& payload) {
+        static constexpr std::size_t header_size = 1 + sizeof(std::uint16_t);
+        static constexpr std::size_t length_size = sizeof(std::uint32_t);
+
+        auto available = inbound_tail_ - inbound_head_;
+        if (available < header_size) {
+            return false;
+        }
+        const char* p = inbound_.data() + inbound_head_;  // NOLINT
+        info = static_cast<unsigned char>(p[0]);  // NOLINT
+        slot = (strip(p[2]) << 8) | strip(p[1]);  // NOLINT
+        std::size_t frame_size = header_size;
+        payload.clear();
+        if (has_payload(info)) {
+            if (available < header_size + length_size) {
+                return false;
+            }
+            std::size_t length = (strip(p[6]) << 24) | (strip(p[5]) << 16) | (strip(p[4]) << 8) | strip(p[3]);  // NOLINT
+            if (available < header_size + length_size + length) {
+                return false;
+            }
+            payload.assign(p + header_size + length_size, length);  // NOLINT
+            frame_size += length_size + length;
+        }
+        inbound_head_ += frame_size;
+        if (inbound_head_ == inbound_tail_) {
+            inbound_head_ = 0;
+            inbound_tail_ = 0;
+        }
+        return true;
+    }
+    /**
+     * @brief returns the size of the frame partially received, or 0 if its length has not been received yet
+     */
+    [[nodiscard]] std::size_t pending_frame_size() const noexcept {
+        static constexpr std::size_t prefix_size = 1 + sizeof(std::uint16_t) + sizeof(std::uint32_t);
 
-                char buffer[sizeof(std::uint16_t)];  // NOLINT
-                if (!recv(&buffer[0], sizeof(std::uint16_t))) {
-                        VLOG_LP(log_trace) << "socket is closed by the client abnormally";
-                        return await_result::socket_closed;
+        if (inbound_tail_ - inbound_head_ < prefix_size || !has_payload(static_cast<unsigned char>(inbound_.at(inbound_head_)))) {
+            return 0;
+        }
+        const char* p = inbound_.data() + inbound_head_;  // NOLINT
+        return prefix_size + ((strip(p[6]) << 24) | (strip(p[5]) << 16) | (strip(p[4]) << 8) | strip(p[3]));  // NOLINT
+    }
+    static std::size_t strip(char c) {
+        return (static_cast<std::uint32_t>(c) & 0xff);  // NOLINT
+    }
+
+    /**
+     * @brief send the response frame directly, without waiting for the result set frames queued,
+     *  as none of them are ordered against it except RESPONSE_RESULT_SET_BYE, which is sent through the queue.
+     *  The sender thread gives way to the response between its sends.
+     */
+    void send_response(unsigned char info, std::uint16_t slot, std::string_view payload, bool force = false) {
+        responses_waiting_.fetch_add(1);
+        std::unique_lock<std::mutex> lock(mutex_);
+        responses_waiting_.fetch_sub(1);
+        if (session_closed_ && !force) {
+            return;
+        }
+        std::array<char, response_header_size> header{};
+        header.at(0) = static_cast<char>(info);
+        put_uint16(&header.at(1), slot);
+        put_uint32(&header.at(1 + sizeof(std::uint16_t)), payload.length());
+        std::array<struct iovec, 2> iov{{{header.data(), response_header_size}, {const_cast<char*>(payload.data()), payload.length()}}};  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        send_iovecs(iov.data(), payload.empty() ? 1 : 2, false);
+    }
+
+    /**
+     * @brief send the frames in the iovecs by sendmsg(), continuing after a partial send.
+     * @param iov the iovecs, which are modified when the frames are partially sent
+     * @param count the number of the iovecs
+     * @param msg_more true if the caller will send the following frames soon
+     */
+    void send_iovecs(struct iovec* iov, std::size_t count, bool msg_more) {  // a support function, assumes caller hold lock
+#ifdef ENABLE_IO_URING
+        if (uring_sender::supported() && has_large_payload(iov, count)) {
+            if (!uring_sender_) {
+                uring_sender_ = uring_sender::create();
+            }
+            if (uring_sender_) {
+                uring_sender_->send(socket_, iov, count, msg_more);
+                return;
+            }
+        }
+#endif
+        while (count > 0) {
+            struct msghdr msg{};
+            msg.msg_iov = iov;
+            msg.msg_iovlen = count;
+            auto sent = ::sendmsg(socket_, &msg, msg_more ? (MSG_MORE | MSG_NOSIGNAL) : MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
                 }
-                slot = (strip(buffer[1]) << 8) | strip(buffer[0]);  // NOLINT
+                return;  // the disconnection is to be detected by the receiver side
+            }
+            auto remaining = static_cast<std::size_t>(sent);
+            while (count > 0 && remaining >= iov->iov_len) {
+                remaining -= iov->iov_len;
+                ++iov;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + remaining;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                iov->iov_len -= remaining;
+            }
+        }
+    }
+    /**
+     * @brief let the sender thread drain the send queue, called after pushing an entry.
+     * @details the sender thread is started by the first entry, thus the sessions without result sets do not have it.
+     *  The writers only push the entries, and the frames of the result sets are sent by the sender thread alone.
+     */
+    void wake_sender() {
+        {
+            std::unique_lock<std::mutex> lock(sender_mutex_);
+            if (sender_stopped_) {
+                return;
+            }
+            if (!sender_.joinable()) {
+                sender_ = std::thread([this](){ run_sender(); });
+            }
+            if (sender_woken_) {
+                return;
+            }
+            sender_woken_ = true;
+        }
+        sender_condition_.notify_one();
+    }
+
+    void run_sender() {
+        std::unique_lock<std::mutex> lock(sender_mutex_);
+        while (true) {
+            sender_condition_.wait(lock, [this](){ return sender_woken_ || sender_stopped_; });
+            if (sender_stopped_) {
+                return;
             }
-            switch (info) {
-            case REQUEST_SESSION_PAYLOAD:
-                VLOG_LP(log_trace) << "--> REQUEST_SESSION_PAYLOAD " << static_cast<std::uint32_t>(slot);
-                if (recv(payload)) {
-                    return await_result::payload;
+            sender_woken_ = false;
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief stop the sender thread, the entries not sent are left in the send queue and pending_
+     */
+    void stop_sender() {
+        {
+            std::unique_lock<std::mutex> lock(sender_mutex_);
+            sender_stopped_ = true;
+        }
+        sender_condition_.notify_one();
+        if (sender_.joinable()) {
+            sender_.join();
+        }
+    }
+
+    /**
+     * @brief send the entries queued until the queue becomes empty or the slots queued have no credit,
+     *  called by the sender thread only.
+     * @details the entries are sent in the order pushed within a slot, and taken from the slots in turn
+     *  so that a result set producing many records does not delay the others.
+     */
+    void drain() {
+        std::array<send_queue::entry*, max_entries_per_send> entries{};
+        std::array<struct iovec, max_entries_per_send> iov{};
+        while (true) {
+            for (auto* e = send_queue_.take_all(); e != nullptr;) {
+                auto* next = e->next_;
+                pending_[e->slot_].emplace_back(e);
+                e = next;
+            }
+            std::size_t bytes = 0;
+            bool more = false;
+            auto count = take_sendable(entries.data(), bytes, more);
+            if (bytes == 0) {
+                return;
+            }
+            for (std::size_t i = 0; i < count; i++) {
+                if (compressor_) {
+                    entries.at(i) = compress_block(entries.at(i));
                 }
-                VLOG_LP(log_trace) << "socket is closed by the client abnormally";
-                return await_result::socket_closed;
-            case REQUEST_RESULT_SET_BYE_OK:
+                iov.at(i) = {entries.at(i)->bytes_.data(), entries.at(i)->bytes_.size()};
+            }
+            while (responses_waiting_.load() > 0) {
+                std::this_thread::yield();
+            }
             {
-                VLOG_LP(log_trace) << "--> REQUEST_RESULT_SET_BYE_OK " << static_cast<std::uint32_t>(slot);
-                std::string dummy;
-                if (recv(dummy)) {
-                    release_slot(slot);
-                    break;
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (!session_closed_ && count > 0) {
+                    send_entries(entries.data(), iov.data(), count, more || send_queue_.pushed());
                 }
-                VLOG_LP(log_trace) << "socket is closed by the client abnormally";
-                return await_result::socket_closed;
             }
-            case REQUEST_SESSION_HELLO:  // for backward compatibility
-                if (recv(payload)) {
-                    std::string session_name = std::to_string(-1);  // dummy as this session will be closed soon.
-                    send_response(RESPONSE_SESSION_HELLO_OK, 0, session_name);
-                } else {
-                    VLOG_LP(log_trace) << "socket is closed by the client abnormally";
-                }
-                continue;
-            case REQUEST_SESSION_BYE:
-                VLOG_LP(log_trace) << "--> REQUEST_SESSION_BYE ";
-                if (recv(payload)) {
-                    std::unique_lock<std::mutex> lock(mutex_);
-                    session_closed_ = true;
-                    return await_result::termination_request;
-                }
-                VLOG_LP(log_trace) << "socket is closed by the client abnormally";
-                return await_result::socket_closed;
-            case REQUEST_ALIVE_CHECK:
-                VLOG_LP(log_trace) << "--> REQUEST_ALIVE_CHECK ";
+            for (std::size_t i = 0; i < count; i++) {
+                send_queue_.release(entries.at(i));
+            }
+            send_queue_.sent(bytes);
+        }
+    }
+
+    /**
+     * @brief take the entries to be sent from pending_ in turn of the slots, called by the sender thread only.
+     * @details the result set frames of a slot without credit are held until the client grants it, and those of
+     *  a slot closed by the client are discarded. The credit is consumed by the bytes of the frames before the compression,
+     *  which the client counts after decompressing them. If the compression is enabled, the frames following in the slot
+     *  are merged into the entry up to compression_block_size, to be compressed together.
+     * @param entries the array of max_entries_per_send, to which the entries taken are set
+     * @param bytes the bytes of the entries taken or discarded, which have left the send queue
+     * @param more set true if sendable entries are left by the limits of a send
+     * @return the number of the entries taken
+     */
+    std::size_t take_sendable(send_queue::entry** entries, std::size_t& bytes, bool& more) {
+        std::size_t count = 0;
+        std::size_t taken = 0;
+        std::unique_lock<std::mutex> lock(slot_mutex_);
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            if (count >= max_entries_per_send || taken >= max_bytes_per_send) {
+                more = !pending_.empty();
                 break;
-            default:
-                LOG_LP(ERROR) << "illegal message type " << static_cast<std::uint32_t>(info);
-                close();
-                return await_result::illegal_message;  // to exit this thread
+            }
+            for (auto it = pending_.begin(); it != pending_.end() && count < max_entries_per_send;) {
+                auto slot = it->first;
+                auto& queue = it->second;
+                auto* e = queue.front();
+                if (!e->response_ && sending_.at(slot) != sending_status::sending) {
+                    queue.pop_front();
+                    bytes += e->bytes_.size();
+                    send_queue_.release(e);
+                    progress = true;
+                } else if (e->response_ || has_credit(slot)) {
+                    queue.pop_front();
+                    if (!e->response_) {
+                        consume_credit(slot, e->bytes_.size());
+                        if (compressor_) {
+                            merge_following(e, queue);
+                        }
+                    }
+                    bytes += e->bytes_.size();
+                    taken += e->bytes_.size();
+                    entries[count++] = e;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    progress = true;
+                }
+                it = queue.empty() ? pending_.erase(it) : std::next(it);
             }
         }
+        return count;
     }
-    std::size_t strip(char c) {
-        return (static_cast<std::uint32_t>(c) & 0xff);  // NOLINT
+
+    /**
+     * @brief merge the result set frames following in the slot into the entry up to compression_block_size,
+     *  as long as the slot has credit, assumes caller hold slot_mutex_
+     */
+    void merge_following(send_queue::entry* e, std::deque<send_queue::entry*>& following) {
+        while (!following.empty() && !following.front()->response_ && has_credit(e->slot_) &&
+               e->bytes_.size() + following.front()->bytes_.size() <= compression_block_size) {
+            auto* next = following.front();
+            following.pop_front();
+            consume_credit(e->slot_, next->bytes_.size());
+            e->bytes_.insert(e->bytes_.end(), next->bytes_.begin(), next->bytes_.end());
+            send_queue_.release(next);
+        }
     }
 
-    [[nodiscard]] bool recv(std::string& payload) {
-        char buffer[4];  // NOLINT
-        if (!recv(&buffer[0], sizeof(int))) {
-            return false;
+    /**
+     * @brief compress the frames of the entry into a RESPONSE_RESULT_SET_COMPRESSED_PAYLOAD frame,
+     *  whose payload consists of the length of the frames and the frames compressed.
+     * @return the entry to be sent, which is the given one if the frames are sent uncompressed
+     */
+    send_queue::entry* compress_block(send_queue::entry* e) {
+        if (e->response_ || e->bytes_.size() < min_compression_block_size || e->bytes_.size() > std::numeric_limits<std::uint32_t>::max()) {
+            return e;
         }
-        unsigned int length = (strip(buffer[3]) << 24) | (strip(buffer[2]) << 16) | (strip(buffer[1]) << 8) | strip(buffer[0]);  // NOLINT
+        auto* block = send_queue_.allocate(e->slot_);
+        auto& buffer = block->bytes_;
+        buffer.resize(result_set_header_size + sizeof(std::uint32_t));
+        if (!compressor_->compress({e->bytes_.data(), e->bytes_.size()}, buffer)) {
+            send_queue_.release(block);
+            return e;
+        }
+        VLOG_LP(log_trace) << "<-- RESPONSE_RESULT_SET_COMPRESSED_PAYLOAD " << static_cast<std::uint32_t>(e->slot_) << ", " << e->bytes_.size() << " -> " << buffer.size();
+        put_result_set_header(buffer.data(), e->slot_, 0, buffer.size() - result_set_header_size);
+        buffer.at(0) = static_cast<char>(RESPONSE_RESULT_SET_COMPRESSED_PAYLOAD);
+        put_uint32(&buffer.at(result_set_header_size), e->bytes_.size());
+        send_queue_.release(e);
+        return block;
+    }
 
-        if (length > 0) {
-            payload.resize(length);
-            char *data_buffer = payload.data();
-            if (!recv(data_buffer, length)) {
-                return false;
+    /**
+     * @brief send the entries, the ones not less than zerocopy_sender::threshold are sent with MSG_ZEROCOPY if enabled.
+     */
+    void send_entries(send_queue::entry** entries, struct iovec* iov, std::size_t count, bool msg_more) {  // a support function, assumes caller hold lock
+        std::size_t from = 0;
+        if (zerocopy_stats_) {
+            for (std::size_t i = 0; i < count; i++) {
+                auto& bytes = entries[i]->bytes_;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                if (bytes.size() < zerocopy_sender::threshold) {
+                    continue;
+                }
+                if (!zerocopy_sender_) {
+                    zerocopy_sender_ = std::make_unique<zerocopy_sender>(socket_, *zerocopy_stats_);
+                }
+                if (!zerocopy_sender_->available()) {
+                    break;
+                }
+                if (from < i) {
+                    send_iovecs(&iov[from], i - from, true);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+                bool more = (i + 1) < count || msg_more;
+                if (zerocopy_sender_->reserve()) {
+                    zerocopy_sender_->send(std::move(bytes), more);  // kept by zerocopy_sender until the completion
+                } else {
+                    send_iovecs(&iov[i], 1, more);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+                from = i + 1;
             }
         }
-        return true;
+        if (from < count) {
+            send_iovecs(&iov[from], count - from, msg_more);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+        }
     }
-    [[nodiscard]] bool recv(char* to, const std::size_t size) {  // NOLINT
-        auto received = ::recv(socket_, to, size, 0);
-        if (received == 0) {
-            return false;
+
+#ifdef ENABLE_IO_URING
+    static bool has_large_payload(struct iovec const* iov, std::size_t count) noexcept {
+        return std::any_of(iov, iov + count, [](auto& e){ return e.iov_len >= uring_sender::zero_copy_threshold; });  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+    }
+#endif
+    static void put_uint16(char* to, std::uint16_t value) noexcept {
+        to[0] = static_cast<char>(value & 0xffU);  // NOLINT
+        to[1] = static_cast<char>((value >> 8U) & 0xffU);  // NOLINT
+    }
+    static void put_uint32(char* to, std::size_t value) noexcept {
+        for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+            to[i] = static_cast<char>((value >> (8U * i)) & 0xffU);  // NOLINT
         }
-        while (received < static_cast<std::int64_t>(size)) {
-            auto s = ::recv(socket_, to + received, size - received, 0);  // NOLINT
-            if (s == 0) {
-                return false;
+    }
+    static void put_result_set_header(char* to, std::uint16_t slot, unsigned char writer, std::size_t length) noexcept {
+        to[0] = static_cast<char>(RESPONSE_RESULT_SET_PAYLOAD);  // NOLINT
+        put_uint16(&to[1], slot);  // NOLINT
+        to[1 + sizeof(std::uint16_t)] = static_cast<char>(writer);  // NOLINT
+        put_uint32(&to[2 + sizeof(std::uint16_t)], length);  // NOLINT
+    }
+
+    void release_slot(unsigned int slot) {
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            if (sending_.at(slot) != sending_status::sending) {
+                lock.unlock();
+                LOG_LP(ERROR) << "slot " << slot << " is already not sending";
+                return;
             }
-            received += s;
+            sending_.at(slot) = sending_status::closed;
+        }
+        wake_sender();  // to discard the frames of the slot held for the credit
+    }
+
+    /**
+     * @brief returns true only to the first caller after the client has closed the result set of the slot,
+     *  which is to send the early eor.
+     */
+    bool finish_closed_slot(std::uint16_t slot) {
+        std::unique_lock<std::mutex> lock(slot_mutex_);
+        if (sending_.at(slot) != sending_status::closed) {
+            return false;
         }
+        sending_.at(slot) = sending_status::finished;
         return true;
     }
 
-    void send_response(unsigned char info, std::uint16_t slot, std::string_view payload, bool force = false) {  // a support function, assumes caller hold lock
-        char buffer[sizeof(std::uint16_t)];  // NOLINT
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (session_closed_ && !force) {
+    /**
+     * @brief add the credit in the payload of REQUEST_RESULT_SET_CREDIT to the slot.
+     * @details the payload consists of the bytes the client has consumed and the number of RESPONSE_RESULT_SET_HELLO
+     *  the client has received for the slot, both in 4 bytes little endian. The credit tagged by another number
+     *  is for a previous result set of the slot, and is discarded as the window of the result set has been given anew.
+     */
+    void grant_credit(std::uint16_t slot, std::string_view payload) {
+        if (payload.length() != 2 * sizeof(std::uint32_t)) {
+            LOG_LP(ERROR) << "illegal credit of slot " << static_cast<std::uint32_t>(slot) << " is ignored";
             return;
         }
-        ::send(socket_, &info, 1, MSG_NOSIGNAL);
-        buffer[0] = slot & 0xff;  // NOLINT
-        buffer[1] = (slot / 0x100) & 0xff;  // NOLINT
-        ::send(socket_, &buffer[0], sizeof(std::uint16_t), MSG_MORE | MSG_NOSIGNAL);
-        send_payload(payload);
-    }
-    void send_payload(std::string_view payload, bool msg_more = false) const {  // a support function, assumes caller hold lock
-        unsigned int length = payload.length();
-        char buffer[4];  // NOLINT
-        buffer[0] = length & 0xff;  // NOLINT
-        buffer[1] = (length / 0x100) & 0xff;  // NOLINT
-        buffer[2] = (length / 0x10000) & 0xff;  // NOLINT
-        buffer[3] = (length / 0x1000000) & 0xff;  // NOLINT
-        if (length > 0) {
-            ::send(socket_, &buffer[0], sizeof(length), MSG_MORE | MSG_NOSIGNAL);
-            ::send(socket_, payload.data(), length, msg_more ? (MSG_MORE | MSG_NOSIGNAL) : MSG_NOSIGNAL);
-        } else {
-            ::send(socket_, &buffer[0], sizeof(length), msg_more ? (MSG_MORE | MSG_NOSIGNAL) : MSG_NOSIGNAL);
+        std::uint32_t bytes = 0;
+        std::uint32_t generation = 0;
+        for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+            bytes |= static_cast<std::uint32_t>(strip(payload.at(i)) << (8U * i));
+            generation |= static_cast<std::uint32_t>(strip(payload.at(sizeof(std::uint32_t) + i)) << (8U * i));
         }
+        {
+            std::unique_lock<std::mutex> lock(slot_mutex_);
+            if (window_ == 0 || slot >= credits_.size()) {
+                lock.unlock();
+                LOG_LP(ERROR) << "illegal credit of slot " << static_cast<std::uint32_t>(slot) << " is ignored";
+                return;
+            }
+            if (generation != generations_.at(slot)) {
+                VLOG_LP(log_trace) << "credit for the previous result set of slot " << static_cast<std::uint32_t>(slot) << " is discarded";
+                return;
+            }
+            credits_.at(slot) += bytes;
+        }
+        wake_sender();  // to send the frames of the slot held for the credit
     }
 
-    void release_slot(unsigned int slot) {
-        if (sending_.at(slot) != sending_status::sending) {
-            LOG_LP(ERROR) << "slot " << slot << " is already not sending";
-            return;
+    /**
+     * @brief returns whether the result set frames of the slot can be sent, assumes caller hold slot_mutex_.
+     * @details an entry larger than the credit left is sent as long as the credit is positive,
+     *  which is paid by the credit granted afterwards, thus a window smaller than an entry does not stop the result set.
+     */
+    [[nodiscard]] bool has_credit(std::uint16_t slot) const {
+        return window_ == 0 || credits_.at(slot) > 0;
+    }
+    void consume_credit(std::uint16_t slot, std::size_t bytes) {  // a support function, assumes caller hold slot_mutex_
+        if (window_ > 0) {
+            credits_.at(slot) -= static_cast<std::int64_t>(bytes);
         }
-        sending_.at(slot) = sending_status::closed;
     }
 };
 
@@ -406,30 +1014,46 @@ public:
      * @brief Construct a new object.
      */
     connection_socket() = delete;
-    connection_socket(std::uint32_t port, std::size_t timeout, std::size_t socket_limit) : socket_limit_(socket_limit), timeout_(timeout) {
+    connection_socket(std::uint32_t port, std::size_t timeout, std::size_t socket_limit, const socket_options& options)
+        : socket_limit_(socket_limit), timeout_(timeout), options_(options) {
         // create a pipe
         if (pipe(&pair_[0]) != 0) {
             throw std::runtime_error("cannot create a pipe");
         }
 
         // create a socket
-        socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
-        const int enable = 1;
-        if (setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) < 0) {
-            LOG_LP(ERROR) << "setsockopt() fail";
+        socket_ = ::socket(options_.ipv6_ ? AF_INET6 : AF_INET, SOCK_STREAM, 0);
+        if (socket_ < 0) {
+            throw std::runtime_error("cannot create a socket");
         }
+        options_.apply_to_listener(socket_);
 
         // Map the address and the port to the socket
-        struct sockaddr_in socket_address{};
-        socket_address.sin_family = AF_INET;
-        socket_address.sin_port = htons(port);
-        socket_address.sin_addr.s_addr = INADDR_ANY;
-        if (bind(socket_, (struct sockaddr *) &socket_address, sizeof(socket_address)) != 0) {  // NOLINT
+        int rv{};
+        if (options_.ipv6_) {
+            struct sockaddr_in6 socket_address{};
+            socket_address.sin6_family = AF_INET6;
+            socket_address.sin6_port = htons(port);
+            socket_address.sin6_addr = in6addr_any;
+            rv = bind(socket_, (struct sockaddr *) &socket_address, sizeof(socket_address));  // NOLINT
+        } else {
+            struct sockaddr_in socket_address{};
+            socket_address.sin_family = AF_INET;
+            socket_address.sin_port = htons(port);
+            socket_address.sin_addr.s_addr = INADDR_ANY;
+            rv = bind(socket_, (struct sockaddr *) &socket_address, sizeof(socket_address));  // NOLINT
+        }
+        if (rv != 0) {
             throw std::runtime_error("bind error, probably another server is running on the same port");
         }
         // listen the port
         listen(socket_, SOMAXCONN);
+#ifdef ENABLE_IO_URING
+        acceptor_ = uring_acceptor::create(socket_, pair_[0]);
+#endif
     }
+    connection_socket(std::uint32_t port, std::size_t timeout, std::size_t socket_limit) : connection_socket(port, timeout, socket_limit, socket_options{}) {}
+    connection_socket(std::uint32_t port, std::size_t timeout, const socket_options& options) :  connection_socket(port, timeout, default_socket_limit, options) {}
     connection_socket(std::uint32_t port, std::size_t timeout) :  connection_socket(port, timeout, default_socket_limit) {}
     explicit connection_socket(std::uint32_t port) :  connection_socket(port, 1000, default_socket_limit) {}  // for tests
     ~connection_socket() = default;
@@ -445,6 +1069,15 @@ public:
     std::unique_ptr<stream_socket> accept(const std::function<void(void)>& cleanup = [](){} ) {
         cleanup();
 
+#ifdef ENABLE_IO_URING
+        if (acceptor_) {
+            if (auto stream = accept_by_uring(cleanup); stream) {
+                return std::move(stream.value());
+            }
+            LOG_LP(INFO) << "the multishot accept of io_uring is not supported, use accept() instead";
+            acceptor_ = nullptr;
+        }
+#endif
         while (true) {
             struct timeval tv{};
             tv.tv_sec = static_cast<std::int64_t>(timeout_ / 1000);            // sec
@@ -460,27 +1093,93 @@ public:
             }
             if (FD_ISSET(socket_, &fds_)) {  // NOLINT
                 // Accept a connection request
-                struct sockaddr_in address{};
-                unsigned int len = sizeof(address);
+                struct sockaddr_storage address{};
+                socklen_t len = sizeof(address);
                 int ts = ::accept(socket_, (struct sockaddr *)&address, &len);  // NOLINT
                 if (ts == -1) {
                     throw std::runtime_error("accept error");
                 }
-                std::stringstream ss{};
-                ss << inet_ntoa(address.sin_addr) << ":" << ntohs(address.sin_port);
-                return std::make_unique<stream_socket>(ts, ss.str(), this);
+                return accepted(ts, address);
             }
             if (FD_ISSET(pair_[0], &fds_)) {  //  NOLINT
-                char trash{};
-                if (read(pair_[0], &trash, sizeof(trash)) <= 0) {
-                    throw std::runtime_error("pipe connection error");
-                }
+                consume_terminate_request();
                 return nullptr;
             }
             throw std::runtime_error("select error");
         }
     }
 
+    /**
+     * @brief let the sessions accepted afterwards send the large result sets with MSG_ZEROCOPY
+     */
+    void enable_zerocopy() {
+        if (!zerocopy_stats_) {
+            zerocopy_stats_ = std::make_shared<zerocopy_stats>();
+        }
+    }
+
+    /**
+     * @brief returns the statistics of MSG_ZEROCOPY, nullptr if it is not enabled
+     */
+    [[nodiscard]] std::shared_ptr<zerocopy_stats> zerocopy_statistics() const noexcept {
+        return zerocopy_stats_;
+    }
+
+    /**
+     * @brief let the sessions compress the result sets by the codec agreed in the handshake
+     * @param level the compression level, 0 means the default of the codec
+     */
+    void enable_compression(int level) {
+        compression_level_ = level;
+        if (!compression_stats_) {
+            compression_stats_ = std::make_shared<compression_stats>();
+        }
+    }
+
+    /**
+     * @brief returns the statistics of the compression, nullptr if it is not enabled
+     */
+    [[nodiscard]] std::shared_ptr<compression_stats> compression_statistics() const noexcept {
+        return compression_stats_;
+    }
+
+    /**
+     * @brief set the limit of the bytes queued to be sent in a session accepted afterwards
+     */
+    void set_send_queue_limit(std::size_t limit) noexcept {
+        send_queue_limit_ = limit;
+    }
+
+    /**
+     * @brief let this object accept the sessions with the settings of the other, sharing the statistics,
+     *  used by the acceptors listening the same port with SO_REUSEPORT
+     */
+    void share_settings(const connection_socket& other) {
+        zerocopy_stats_ = other.zerocopy_stats_;
+        compression_level_ = other.compression_level_;
+        compression_stats_ = other.compression_stats_;
+        send_queue_stats_ = other.send_queue_stats_;
+        send_queue_limit_ = other.send_queue_limit_;
+    }
+
+    /**
+     * @brief returns the statistics of the send queues of all the sessions
+     */
+    [[nodiscard]] std::shared_ptr<send_queue_stats> send_queue_statistics() const noexcept {
+        return send_queue_stats_;
+    }
+
+    /**
+     * @brief returns whether the connections are accepted by io_uring, for diagnostic
+     */
+    [[nodiscard]] bool uses_io_uring() const noexcept {
+#ifdef ENABLE_IO_URING
+        return acceptor_ != nullptr;
+#else
+        return false;
+#endif
+    }
+
     void request_terminate() {
         if (write(pair_[1], "q", 1) <= 0) {
             LOG_LP(ERROR) << "fail to request terminate";
@@ -501,9 +1200,81 @@ private:
     std::mutex num_mutex_{};
     std::condition_variable num_condition_{};
     std::size_t timeout_;
+    const socket_options options_;
+    std::shared_ptr<zerocopy_stats> zerocopy_stats_{};
+    std::shared_ptr<send_queue_stats> send_queue_stats_{std::make_shared<send_queue_stats>()};
+    std::size_t send_queue_limit_{send_queue::default_limit};
+    int compression_level_{};
+    std::shared_ptr<compression_stats> compression_stats_{};
+
+#ifdef ENABLE_IO_URING
+    std::unique_ptr<uring_acceptor> acceptor_{};
+
+    /**
+     * @brief accept a connection by the multishot accept of io_uring
+     * @return nullopt if the multishot accept is not supported by the kernel
+     */
+    std::optional<std::unique_ptr<stream_socket>> accept_by_uring(const std::function<void(void)>& cleanup) {
+        while (true) {
+            int ts{};
+            switch (acceptor_->accept(timeout_, is_socket_available(), ts)) {
+            case uring_acceptor::accept_result::accepted:
+            {
+                // the multishot accept does not tell the address of the peer
+                struct sockaddr_storage address{};
+                socklen_t len = sizeof(address);
+                if (getpeername(ts, (struct sockaddr *)&address, &len) != 0) {  // NOLINT
+                    LOG_LP(INFO) << "getpeername() fail, errno = " << errno;
+                }
+                return accepted(ts, address);
+            }
+            case uring_acceptor::accept_result::timeout:
+                cleanup();
+                continue;
+            case uring_acceptor::accept_result::terminate:
+                consume_terminate_request();
+                return std::unique_ptr<stream_socket>{};
+            case uring_acceptor::accept_result::unsupported:
+                return std::nullopt;
+            }
+        }
+    }
+#endif
 
     friend class stream_socket;
 
+    std::unique_ptr<stream_socket> accepted(int ts, const struct sockaddr_storage& address) {
+        options_.apply(ts);
+        return std::make_unique<stream_socket>(ts, peer_name(address), this);
+    }
+    static std::string peer_name(const struct sockaddr_storage& address) {
+        std::array<char, INET6_ADDRSTRLEN> name{};
+        std::stringstream ss{};
+        if (address.ss_family == AF_INET6) {
+            struct sockaddr_in6 in6{};
+            std::memcpy(&in6, &address, sizeof(in6));
+            if (IN6_IS_ADDR_V4MAPPED(&in6.sin6_addr)) {  // NOLINT
+                // an IPv4 client connecting to the dual-stack socket, shown as before
+                struct in_addr in{};
+                std::memcpy(&in, &in6.sin6_addr.s6_addr[12], sizeof(in));  // NOLINT
+                ss << inet_ntop(AF_INET, &in, name.data(), name.size());
+            } else {
+                ss << "[" << inet_ntop(AF_INET6, &in6.sin6_addr, name.data(), name.size()) << "]";
+            }
+            ss << ":" << ntohs(in6.sin6_port);
+            return ss.str();
+        }
+        struct sockaddr_in in{};
+        std::memcpy(&in, &address, sizeof(in));
+        ss << inet_ntop(AF_INET, &in.sin_addr, name.data(), name.size()) << ":" << ntohs(in.sin_port);
+        return ss.str();
+    }
+    void consume_terminate_request() {
+        char trash{};
+        if (read(pair_[0], &trash, sizeof(trash)) <= 0) {
+            throw std::runtime_error("pipe connection error");
+        }
+    }
     [[nodiscard]] bool is_socket_available() {
         return num_open_.load() < socket_limit_;
     }
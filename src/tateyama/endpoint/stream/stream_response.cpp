@@ -15,6 +15,7 @@
  */
 #include <exception>
 #include <string>
+#include <vector>
 
 #include <glog/logging.h>
 
@@ -172,6 +173,7 @@ tateyama::status stream_data_channel::release(tateyama::api::server::writer& wrt
     {
         std::unique_lock lock{mutex_};
         if (auto itr = data_writers_.find(dynamic_cast<stream_writer*>(&wrt)); itr != data_writers_.end()) {
+            (*itr)->flush();
             data_writers_.erase(itr);
             return tateyama::status::ok;
         }
@@ -180,19 +182,63 @@ tateyama::status stream_data_channel::release(tateyama::api::server::writer& wrt
 }
 
 void stream_data_channel::shutdown() {
+    {
+        std::unique_lock lock{mutex_};
+        for (auto&& wrt : data_writers_) {  // the records committed to the writers not released precede RESULT_SET_BYE
+            wrt->flush();
+        }
+    }
     stream_.send_result_set_bye(get_slot());
 }
 
 // class writer
+stream_writer::~stream_writer() {
+    if (entry_ != nullptr) {
+        stream_.release_entry(entry_);
+    }
+}
+
+std::vector<char>& stream_writer::bytes() {
+    if (entry_ == nullptr) {
+        entry_ = stream_.allocate_entry(slot_);
+    }
+    return entry_->bytes_;
+}
+
+void stream_writer::flush_if_full() {
+    if (entry_->bytes_.size() >= flush_size) {
+        flush();
+    }
+}
+
+void stream_writer::flush() {
+    if (entry_ == nullptr) {
+        return;
+    }
+    if (record_) {  // the record not committed is not sent
+        entry_->bytes_.resize(record_.value());
+        record_ = std::nullopt;
+    }
+    if (entry_->bytes_.empty()) {
+        return;
+    }
+    stream_.send(slot_, writer_id_, entry_);
+    entry_ = nullptr;
+}
+
 tateyama::status stream_writer::write(char const* data, std::size_t length) {
     if (stream_.is_sending(slot_)) {
         VLOG_LP(log_trace) << static_cast<const void*>(this);  //NOLINT
 
         if (data != nullptr && length > 0) {
-            if (buffer_.capacity() < buffer_.size() + length) {
-                buffer_.reserve(buffer_.size() + length + buffer_size);
+            auto& buffer = bytes();
+            if (!record_) {
+                record_ = stream_socket::open_record(buffer);
+            }
+            if (buffer.capacity() < buffer.size() + length) {
+                buffer.reserve(buffer.size() + length + buffer_size);
             }
-            buffer_.insert(buffer_.end(), data, data + length); //NOLINT
+            buffer.insert(buffer.end(), data, data + length); //NOLINT
         }
     } else {
         VLOG_LP(log_trace) << static_cast<const void*>(this) << " client already closed the result set channel";  //NOLINT
@@ -204,12 +250,35 @@ tateyama::status stream_writer::commit() {
     if (stream_.is_sending(slot_)) {
         VLOG_LP(log_trace) << static_cast<const void*>(this);  //NOLINT
 
-        if (!buffer_.empty()) {
-            stream_.send(slot_, writer_id_, {buffer_.data(), buffer_.size()});
-            buffer_.clear();
-        } else {
-            stream_.send(slot_, writer_id_, {});
+        auto& buffer = bytes();
+        stream_socket::close_record(buffer, record_ ? record_.value() : stream_socket::open_record(buffer), slot_, writer_id_);
+        record_ = std::nullopt;
+        flush_if_full();
+    } else {
+        VLOG_LP(log_trace) << static_cast<const void*>(this) << " client already closed the result set channel";  //NOLINT
+    }
+    return tateyama::status::ok;
+}
+
+tateyama::status stream_writer::write_records(std::string_view const* records, std::size_t count) {
+    if (count == 0) {
+        return tateyama::status::ok;
+    }
+    if (stream_.is_sending(slot_)) {
+        VLOG_LP(log_trace) << static_cast<const void*>(this) << " " << count << " records";  //NOLINT
+
+        auto& buffer = bytes();
+        std::size_t i = 0;
+        if (record_) {  // the first record follows the data written but not committed yet
+            buffer.insert(buffer.end(), records[0].begin(), records[0].end());  // NOLINT
+            stream_socket::close_record(buffer, record_.value(), slot_, writer_id_);
+            record_ = std::nullopt;
+            i++;
+        }
+        for (; i < count; i++) {
+            stream_socket::append_record(buffer, slot_, writer_id_, records[i]);  // NOLINT
         }
+        flush_if_full();
     } else {
         VLOG_LP(log_trace) << static_cast<const void*>(this) << " client already closed the result set channel";  //NOLINT
     }
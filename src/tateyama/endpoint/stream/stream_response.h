@@ -20,6 +20,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <optional>
 
 #include "tateyama/endpoint/common/response.h"
 #include "tateyama/endpoint/common/pointer_comp.h"
@@ -34,6 +35,9 @@ class stream_data_channel;
 
 /**
  * @brief writer object for stream_endpoint
+ * @details the writer fills the result set frames into an entry of the send queue owned by this writer,
+ *  and passes it to the send queue of the session when the records committed reach flush_size or the writer is released,
+ *  thus the writers do not contend with each other and the frames are sent by large buffers.
  */
 class alignas(64) stream_writer : public tateyama::api::server::writer {
     friend stream_data_channel;
@@ -41,14 +45,26 @@ class alignas(64) stream_writer : public tateyama::api::server::writer {
 public:
     explicit stream_writer(stream_socket& stream, std::uint16_t slot, unsigned char writer_id)
         : stream_(stream), slot_(slot), writer_id_(writer_id) {}
+    ~stream_writer() override;
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    stream_writer(stream_writer const&) = delete;
+    stream_writer(stream_writer&&) = delete;
+    stream_writer& operator = (stream_writer const&) = delete;
+    stream_writer& operator = (stream_writer&&) = delete;
+
     tateyama::status write(char const* data, std::size_t length) override;
     tateyama::status commit() override;
+    tateyama::status write_records(std::string_view const* records, std::size_t count) override;
 
 private:
     stream_socket& stream_;
     std::uint16_t slot_;
     unsigned char writer_id_;
-    std::vector<char> buffer_{};
+    send_queue::entry* entry_{};
+    std::optional<std::size_t> record_{};  // the offset of the frame of the record written but not committed yet
     /**
      * @brief Buffer size for storing stream data.
      *
@@ -56,6 +72,16 @@ private:
      * of stream data before sending it.
      */
     static constexpr std::size_t buffer_size = 65536;
+    /**
+     * @brief the bytes of the records committed, at which the entry is passed to the send queue.
+     * @details not less than zerocopy_sender::threshold so that the entry is sent with MSG_ZEROCOPY if enabled,
+     *  and within send_queue::max_free_entry_capacity so that the entry is reused after being sent.
+     */
+    static constexpr std::size_t flush_size = 512UL * 1024UL;
+
+    std::vector<char>& bytes();
+    void flush_if_full();
+    void flush();
 };
 
 /**
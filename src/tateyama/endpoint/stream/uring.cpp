@@ -0,0 +1,261 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef ENABLE_IO_URING
+
+#include <sys/poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <glog/logging.h>
+#include <tateyama/logging.h>
+#include "tateyama/logging_helper.h"
+#include "uring.h"
+
+namespace tateyama::endpoint::stream {
+
+// class uring_acceptor
+std::unique_ptr<uring_acceptor> uring_acceptor::create(int socket, int terminate) {
+    auto acceptor = std::unique_ptr<uring_acceptor>(new uring_acceptor(socket, terminate));
+    if (auto rv = io_uring_queue_init(entries, &acceptor->ring_, 0); rv != 0) {
+        VLOG_LP(log_debug) << "io_uring is not available, errno = " << -rv;
+        return nullptr;
+    }
+    acceptor->initialized_ = true;
+    return acceptor;
+}
+
+uring_acceptor::~uring_acceptor() {
+    if (initialized_) {
+        io_uring_queue_exit(&ring_);
+    }
+    for (auto socket : accepted_) {
+        ::close(socket);
+    }
+}
+
+uring_acceptor::accept_result uring_acceptor::accept(std::size_t timeout_ms, bool available, int& socket) {
+    while (accepted_.empty()) {
+        if (!terminate_armed_) {
+            if (auto* sqe = io_uring_get_sqe(&ring_); sqe != nullptr) {
+                io_uring_prep_poll_add(sqe, terminate_, POLLIN);
+                io_uring_sqe_set_data64(sqe, terminate_key);
+                terminate_armed_ = true;
+            }
+        }
+        if (available && !accept_armed_) {
+            if (auto* sqe = io_uring_get_sqe(&ring_); sqe != nullptr) {
+                io_uring_prep_multishot_accept(sqe, socket_, nullptr, nullptr, 0);
+                io_uring_sqe_set_data64(sqe, accept_key);
+                accept_armed_ = true;
+            }
+        }
+        if (!available && accept_armed_ && !cancelling_) {
+            // stop accepting until a socket is closed, as the select() in connection_socket does
+            if (auto* sqe = io_uring_get_sqe(&ring_); sqe != nullptr) {
+                io_uring_prep_cancel64(sqe, accept_key, 0);
+                io_uring_sqe_set_data64(sqe, cancel_key);
+                cancelling_ = true;
+            }
+        }
+        if (auto rv = io_uring_submit(&ring_); rv < 0) {
+            throw std::runtime_error("io_uring_submit error");
+        }
+
+        struct __kernel_timespec ts{};
+        ts.tv_sec = static_cast<std::int64_t>(timeout_ms / 1000);
+        ts.tv_nsec = static_cast<std::int64_t>((timeout_ms % 1000) * 1000000);
+        struct io_uring_cqe* cqe{};
+        if (auto rv = io_uring_wait_cqe_timeout(&ring_, &cqe, &ts); rv < 0) {
+            if (rv == -ETIME || rv == -EINTR) {
+                return accept_result::timeout;
+            }
+            throw std::runtime_error("io_uring_wait_cqe_timeout error");
+        }
+        auto key = io_uring_cqe_get_data64(cqe);
+        auto res = cqe->res;
+        auto more = (cqe->flags & IORING_CQE_F_MORE) != 0;  // NOLINT(hicpp-signed-bitwise)
+        io_uring_cqe_seen(&ring_, cqe);
+
+        switch (key) {
+        case accept_key:
+            if (!more) {
+                accept_armed_ = false;
+                cancelling_ = false;
+            }
+            if (res >= 0) {
+                accepted_.emplace_back(res);
+                accepted_once_ = true;
+                break;
+            }
+            if (res == -EINVAL && !accepted_once_) {
+                return accept_result::unsupported;
+            }
+            if (res != -ECANCELED) {
+                throw std::runtime_error("accept error");
+            }
+            break;
+        case terminate_key:
+            terminate_armed_ = false;
+            return accept_result::terminate;
+        default:  // completion of the cancel request
+            break;
+        }
+    }
+    socket = accepted_.front();
+    accepted_.pop_front();
+    return accept_result::accepted;
+}
+
+// class uring_sender
+bool uring_sender::supported() {
+    static const bool available = [](){
+        struct io_uring ring{};
+        if (io_uring_queue_init(1, &ring, 0) != 0) {
+            VLOG_LP(log_debug) << "io_uring is not available";
+            return false;
+        }
+        bool send_zc = false;
+        if (auto* probe = io_uring_get_probe_ring(&ring); probe != nullptr) {
+            send_zc = io_uring_opcode_supported(probe, IORING_OP_SEND_ZC) != 0;
+            io_uring_free_probe(probe);
+        }
+        io_uring_queue_exit(&ring);
+        VLOG_LP(log_debug) << "IORING_OP_SEND_ZC is " << (send_zc ? "" : "not ") << "available";
+        return send_zc;
+    }();
+    return available;
+}
+
+std::unique_ptr<uring_sender> uring_sender::create() {
+    auto sender = std::unique_ptr<uring_sender>(new uring_sender());
+    if (io_uring_queue_init(entries, &sender->ring_, 0) != 0) {
+        return nullptr;
+    }
+    sender->initialized_ = true;
+    return sender;
+}
+
+uring_sender::~uring_sender() {
+    if (initialized_) {
+        io_uring_queue_exit(&ring_);
+    }
+}
+
+bool uring_sender::send(int socket, struct iovec* iov, std::size_t count, bool msg_more) {
+    while (count > 0) {
+        // a sendmsg for each run of the small iovecs and a send_zc for each large payload, linked in this order
+        std::size_t ops = 0;
+        std::size_t i = 0;
+        struct io_uring_sqe* last{};
+        while (i < count && ops < entries) {
+            auto* sqe = io_uring_get_sqe(&ring_);
+            if (sqe == nullptr) {
+                break;
+            }
+            if (iov[i].iov_len >= zero_copy_threshold) {  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                bool more = (i + 1) < count || msg_more;
+                io_uring_prep_send_zc(sqe, socket, iov[i].iov_base, iov[i].iov_len, more ? (MSG_MORE | MSG_NOSIGNAL) : MSG_NOSIGNAL, 0);  // NOLINT
+                lengths_.at(ops) = iov[i].iov_len;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                i++;
+            } else {
+                std::size_t j = i;
+                std::size_t length = 0;
+                while (j < count && iov[j].iov_len < zero_copy_threshold) {  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    length += iov[j].iov_len;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                    j++;
+                }
+                auto& msg = messages_.at(ops);
+                msg = {};
+                msg.msg_iov = &iov[i];  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                msg.msg_iovlen = j - i;
+                bool more = j < count || msg_more;
+                io_uring_prep_sendmsg(sqe, socket, &msg, more ? (MSG_MORE | MSG_NOSIGNAL) : MSG_NOSIGNAL);  // NOLINT(hicpp-signed-bitwise)
+                lengths_.at(ops) = length;
+                i = j;
+            }
+            io_uring_sqe_set_data64(sqe, ops);
+            io_uring_sqe_set_flags(sqe, IOSQE_IO_LINK);
+            last = sqe;
+            ops++;
+        }
+        if (last == nullptr) {
+            return false;
+        }
+        io_uring_sqe_set_flags(last, 0);
+        if (io_uring_submit(&ring_) < 0) {
+            return false;
+        }
+
+        // the payloads are in use by the kernel until the notification of each send_zc arrives
+        std::size_t completed = 0;
+        std::size_t notifications = 0;
+        while (completed < ops || notifications > 0) {
+            struct io_uring_cqe* cqe{};
+            if (auto rv = io_uring_wait_cqe(&ring_, &cqe); rv < 0) {
+                if (rv == -EINTR) {
+                    continue;
+                }
+                LOG_LP(ERROR) << "io_uring_wait_cqe error, errno = " << -rv;
+                return false;
+            }
+            if ((cqe->flags & IORING_CQE_F_NOTIF) != 0) {  // NOLINT(hicpp-signed-bitwise)
+                notifications--;
+            } else {
+                results_.at(io_uring_cqe_get_data64(cqe)) = cqe->res;
+                completed++;
+                if ((cqe->flags & IORING_CQE_F_MORE) != 0) {  // NOLINT(hicpp-signed-bitwise)
+                    notifications++;
+                }
+            }
+            io_uring_cqe_seen(&ring_, cqe);
+        }
+
+        // a partial send breaks the chain and the following requests are canceled, they are sent again
+        std::size_t sent = 0;
+        for (std::size_t op = 0; op < ops; op++) {
+            auto res = results_.at(op);
+            if (res < 0) {
+                if (res == -ECANCELED) {
+                    break;
+                }
+                return false;  // the disconnection is to be detected by the receiver side
+            }
+            sent += static_cast<std::size_t>(res);
+            if (static_cast<std::size_t>(res) < lengths_.at(op)) {
+                break;
+            }
+        }
+        if (sent == 0) {
+            return false;
+        }
+        while (count > 0 && sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            ++iov;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            --count;
+        }
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + sent;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            iov->iov_len -= sent;
+        }
+    }
+    return true;
+}
+
+}  // namespace tateyama::endpoint::stream
+
+#endif  // ENABLE_IO_URING
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#ifdef ENABLE_IO_URING
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <array>
+#include <deque>
+#include <memory>
+
+#include <liburing.h>
+
+namespace tateyama::endpoint::stream {
+
+/**
+ * @brief accepts the connections of the listen socket by a multishot accept of io_uring,
+ *  which keeps accepting the connections without a system call for each of them.
+ */
+class uring_acceptor {
+public:
+    enum class accept_result : std::uint8_t {
+        /**
+         * @brief a connection has been accepted.
+         */
+        accepted = 0U,
+
+        /**
+         * @brief no connection has been accepted within the timeout.
+         */
+        timeout,
+
+        /**
+         * @brief the termination has been requested.
+         */
+        terminate,
+
+        /**
+         * @brief the kernel does not support the multishot accept, the caller should use accept() instead.
+         */
+        unsupported,
+    };
+
+    /**
+     * @brief create an acceptor of the listen socket
+     * @param socket the socket listening
+     * @param terminate the descriptor becoming readable when the termination is requested
+     * @return the acceptor, or nullptr if io_uring is not available
+     */
+    static std::unique_ptr<uring_acceptor> create(int socket, int terminate);
+
+    ~uring_acceptor();
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    uring_acceptor(uring_acceptor const&) = delete;
+    uring_acceptor(uring_acceptor&&) = delete;
+    uring_acceptor& operator = (uring_acceptor const&) = delete;
+    uring_acceptor& operator = (uring_acceptor&&) = delete;
+
+    /**
+     * @brief wait for a connection
+     * @param timeout_ms the timeout in milliseconds
+     * @param available false if no more connections should be accepted now, due to the limit of the sockets
+     * @param socket the socket accepted, which is set when accepted is returned
+     */
+    accept_result accept(std::size_t timeout_ms, bool available, int& socket);
+
+private:
+    static constexpr unsigned entries = 8;
+    static constexpr std::uint64_t accept_key = 1;
+    static constexpr std::uint64_t terminate_key = 2;
+    static constexpr std::uint64_t cancel_key = 3;
+
+    struct io_uring ring_{};
+    bool initialized_{};
+    const int socket_;
+    const int terminate_;
+    bool accept_armed_{};
+    bool cancelling_{};
+    bool terminate_armed_{};
+    bool accepted_once_{};
+    std::deque<int> accepted_{};
+
+    uring_acceptor(int socket, int terminate) noexcept : socket_(socket), terminate_(terminate) {}
+};
+
+/**
+ * @brief sends the frames containing large payloads by IORING_OP_SEND_ZC of io_uring, the kernel transmits
+ *  such payloads without copying them into the socket buffer. The frames are sent by a chain of linked requests.
+ */
+class uring_sender {
+public:
+    /**
+     * @brief the payloads not less than this are sent without copying.
+     */
+    static constexpr std::size_t zero_copy_threshold = 64UL * 1024UL;
+
+    /**
+     * @brief returns whether io_uring and IORING_OP_SEND_ZC are available on this system, which is probed once.
+     */
+    [[nodiscard]] static bool supported();
+
+    /**
+     * @brief create a sender
+     * @return the sender, or nullptr if io_uring is not available
+     */
+    static std::unique_ptr<uring_sender> create();
+
+    ~uring_sender();
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    uring_sender(uring_sender const&) = delete;
+    uring_sender(uring_sender&&) = delete;
+    uring_sender& operator = (uring_sender const&) = delete;
+    uring_sender& operator = (uring_sender&&) = delete;
+
+    /**
+     * @brief send the frames in the iovecs, continuing after a partial send.
+     * @details this returns after the kernel has released the payloads, thus the caller can reuse them.
+     * @param socket the socket to send
+     * @param iov the iovecs, which are modified when the frames are partially sent
+     * @param count the number of the iovecs
+     * @param msg_more true if the caller will send the following frames soon
+     * @return false if the frames cannot be sent, e.g. the socket has been closed
+     */
+    bool send(int socket, struct iovec* iov, std::size_t count, bool msg_more);
+
+private:
+    static constexpr unsigned entries = 32;
+
+    struct io_uring ring_{};
+    bool initialized_{};
+    std::array<struct msghdr, entries> messages_{};
+    std::array<std::size_t, entries> lengths_{};
+    std::array<std::int32_t, entries> results_{};
+
+    uring_sender() = default;
+};
+
+}  // namespace tateyama::endpoint::stream
+
+#endif  // ENABLE_IO_URING
@@ -0,0 +1,245 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+namespace tateyama::endpoint::stream {
+
+/**
+ * @brief the statistics of the result set frames sent with MSG_ZEROCOPY, shared by all the sessions.
+ */
+class zerocopy_stats {
+public:
+    void add_bytes(std::size_t bytes) noexcept {
+        bytes_.fetch_add(bytes);
+    }
+    void add_fallback() noexcept {
+        fallbacks_.fetch_add(1);
+    }
+
+    /**
+     * @brief returns the bytes sent with MSG_ZEROCOPY
+     */
+    [[nodiscard]] std::size_t bytes() const noexcept {
+        return bytes_.load();
+    }
+
+    /**
+     * @brief returns the number of the occasions where the frames have been copied,
+     *  because SO_ZEROCOPY is not supported, the buffers are exhausted, or the kernel has copied them.
+     */
+    [[nodiscard]] std::size_t fallbacks() const noexcept {
+        return fallbacks_.load();
+    }
+
+private:
+    std::atomic_size_t bytes_{};
+    std::atomic_size_t fallbacks_{};
+};
+
+/**
+ * @brief sends the result set frames of a session with MSG_ZEROCOPY.
+ * @details the buffers of the frames are handed over to this object, as the kernel refers to them
+ *  until it notifies the completion through the error queue of the socket. The buffers are released
+ *  after the completion, and the sender waits for a completion when too many buffers are in flight.
+ *  This object is not thread safe, the caller is supposed to hold the lock of the socket.
+ */
+class zerocopy_sender {
+public:
+    /**
+     * @brief the buffers smaller than this are sent by the ordinary sends
+     */
+    static constexpr std::size_t threshold = 64UL * 1024UL;
+
+    /**
+     * @brief the maximum number of the buffers in flight
+     */
+    static constexpr std::size_t max_buffers = 8;
+
+    /**
+     * @brief the time to wait for a buffer to be released by the kernel, in milliseconds
+     */
+    static constexpr int wait_timeout = 2000;
+
+    zerocopy_sender(int socket, zerocopy_stats& stats) : socket_(socket), stats_(stats) {
+        const int enable = 1;
+        available_ = setsockopt(socket_, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) == 0;
+        if (!available_) {
+            stats_.add_fallback();
+        }
+    }
+
+    /**
+     * @brief returns false if SO_ZEROCOPY is not supported by the socket
+     */
+    [[nodiscard]] bool available() const noexcept {
+        return available_;
+    }
+
+    /**
+     * @brief wait for a completion if all the buffers are in flight, to be called before send().
+     * @return false if no buffer has been released within wait_timeout, the caller should send the frames by copying then
+     */
+    bool reserve() {
+        reclaim();
+        if (in_flight_.size() >= max_buffers) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_timeout);
+            while (in_flight_.size() >= max_buffers) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) {
+                    stats_.add_fallback();
+                    return false;
+                }
+                struct pollfd fds{socket_, 0, 0};  // POLLERR is reported when the error queue is not empty
+                poll(&fds, 1, static_cast<int>(remaining));
+                reclaim();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief send the frames in the buffer, which is kept until the kernel notifies the completion.
+     * @param buffer the buffer of the frames
+     * @param msg_more true if the caller will send the following frames soon
+     */
+    void send(std::vector<char>&& buffer, bool msg_more) {
+        std::size_t offset = 0;
+        std::uint32_t calls = 0;
+        while (offset < buffer.size()) {
+            auto flags = MSG_ZEROCOPY | MSG_NOSIGNAL | (msg_more ? MSG_MORE : 0);  // NOLINT(hicpp-signed-bitwise)
+            auto sent = ::send(socket_, buffer.data() + offset, buffer.size() - offset, flags);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == ENOBUFS) {  // exceeds the optmem limit for the notifications, the rest is copied
+                    stats_.add_fallback();
+                    send_copying(buffer.data() + offset, buffer.size() - offset, msg_more);  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+                }
+                break;  // the disconnection is to be detected by the receiver side
+            }
+            offset += static_cast<std::size_t>(sent);
+            calls++;
+        }
+        if (calls > 0) {
+            stats_.add_bytes(offset);
+            in_flight_.emplace_back(in_flight{std::move(buffer), next_, next_ + calls - 1, calls});
+            next_ += calls;
+        }
+    }
+
+    /**
+     * @brief returns the number of the buffers in flight, for diagnostic
+     */
+    [[nodiscard]] std::size_t in_flight_buffers() const noexcept {
+        return in_flight_.size();
+    }
+
+private:
+    class in_flight {
+    public:
+        std::vector<char> buffer_;  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::uint32_t first_;  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::uint32_t last_;  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::uint32_t pending_;  // NOLINT(misc-non-private-member-variables-in-classes)
+    };
+
+    const int socket_;
+    zerocopy_stats& stats_;
+    bool available_{};
+    std::uint32_t next_{};  // the sequence number given to the next send() with MSG_ZEROCOPY by the kernel
+    std::deque<in_flight> in_flight_{};
+
+    // reads the completion notifications from the error queue and releases the buffers completed
+    void reclaim() {
+        while (!in_flight_.empty()) {
+            char control[128];  // NOLINT
+            struct msghdr msg{};
+            msg.msg_control = &control[0];
+            msg.msg_controllen = sizeof(control);
+            if (recvmsg(socket_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {  // NOLINT(hicpp-signed-bitwise)
+                break;
+            }
+            for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {  // NOLINT
+                if (!((cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) || (cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))) {
+                    continue;
+                }
+                struct sock_extended_err err{};
+                std::memcpy(&err, CMSG_DATA(cmsg), sizeof(err));  // NOLINT
+                if (err.ee_errno != 0 || err.ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                    continue;
+                }
+                if ((err.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {  // NOLINT(hicpp-signed-bitwise)
+                    stats_.add_fallback();
+                }
+                complete(err.ee_info, err.ee_data);
+            }
+        }
+        while (!in_flight_.empty() && in_flight_.front().pending_ == 0) {
+            in_flight_.pop_front();
+        }
+    }
+    // the sends numbered from lo to hi have been completed, the numbers wrap around at 2^32 and are compared
+    // by the distance from the first send in flight, which is less than 2^31 as the buffers in flight are few
+    void complete(std::uint32_t lo, std::uint32_t hi) {
+        if (in_flight_.empty()) {
+            return;
+        }
+        const std::uint32_t base = in_flight_.front().first_;
+        std::uint32_t range_lo = lo - base;
+        const std::uint32_t range_hi = hi - base;
+        if (range_hi < range_lo) {  // lo precedes the first send in flight, the sends before it have been counted already
+            range_lo = 0;
+        }
+        for (auto&& e : in_flight_) {
+            auto from = std::max(static_cast<std::uint32_t>(e.first_ - base), range_lo);
+            auto to = std::min(static_cast<std::uint32_t>(e.last_ - base), range_hi);
+            if (from <= to) {
+                e.pending_ -= (to - from + 1);
+            }
+        }
+    }
+    void send_copying(const char* data, std::size_t length, bool msg_more) const {
+        while (length > 0) {
+            auto sent = ::send(socket_, data, length, MSG_NOSIGNAL | (msg_more ? MSG_MORE : 0));  // NOLINT(hicpp-signed-bitwise)
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += sent;  // NOLINT(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+            length -= static_cast<std::size_t>(sent);
+        }
+    }
+};
+
+}  // namespace tateyama::endpoint::stream
@@ -32,6 +32,7 @@
 #include <tateyama/proto/core/request.pb.h>
 #include <tateyama/proto/core/response.pb.h>
 #include <tateyama/proto/diagnostics.pb.h>
+#include <tateyama/utils/protobuf_arena.h>
 
 namespace tateyama::framework {
 
@@ -66,7 +67,7 @@ static bool service_(
 ) {
     namespace ns = proto::core::request;
     auto data = req->payload();
-    ns::Request rq{};
+    auto& rq = *utils::request_arena::create<ns::Request>();
     if(! rq.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
         VLOG_LP(log_error) << "request parse error";
         return false;
@@ -92,6 +93,8 @@ bool routing_service::operator()(std::shared_ptr<request> req, std::shared_ptr<r
         LOG_LP(ERROR) << "routing service is not setup, or framework is running on standalone mode";
         return false;
     }
+    // the messages of the request are allocated on the arena of this thread until the service returns
+    utils::request_arena::scope arena_scope{};
     if (req->service_id() == tag) {
         // must be UpdateExpirationTime
         return service_(req, res);
@@ -21,6 +21,7 @@
 
 #include <tateyama/proto/metrics/request.pb.h>
 #include <tateyama/proto/metrics/response.pb.h>
+#include <tateyama/utils/protobuf_arena.h>
 
 namespace tateyama::metrics::service {
 
@@ -38,14 +39,15 @@ bool tateyama::metrics::service::core::operator()(const std::shared_ptr<request>
         return false;
     }
 
-    tateyama::proto::metrics::request::Request rq{};
+    tateyama::utils::request_arena::scope arena_scope{};
+    auto& rq = *tateyama::utils::request_arena::create<tateyama::proto::metrics::request::Request>();
     auto data = req->payload();
     if(!rq.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
         LOG(ERROR) << "request parse error";
         return false;
     }
 
-    tateyama::proto::metrics::response::MetricsInformation rs{};
+    auto& rs = *tateyama::utils::request_arena::create<tateyama::proto::metrics::response::MetricsInformation>();
     switch(rq.command_case()) {
     case tateyama::proto::metrics::request::Request::kList:
         resource_->core().list(rs);
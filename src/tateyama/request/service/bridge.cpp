@@ -24,6 +24,7 @@
 #include <tateyama/proto/request/request.pb.h>
 #include <tateyama/proto/request/response.pb.h>
 #include <tateyama/proto/diagnostics.pb.h>
+#include <tateyama/utils/protobuf_arena.h>
 
 #include "tateyama/endpoint/common/listener_common.h"
 #include "bridge.h"
@@ -60,7 +61,8 @@ bool bridge::operator()(std::shared_ptr<request> req, std::shared_ptr<response>
         return false;
     }
 
-    tateyama::proto::request::request::Request rq{};
+    tateyama::utils::request_arena::scope arena_scope{};
+    auto& rq = *tateyama::utils::request_arena::create<tateyama::proto::request::request::Request>();
     auto data = req->payload();
     if(!rq.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
         LOG(ERROR) << "request parse error";
@@ -71,7 +73,7 @@ bool bridge::operator()(std::shared_ptr<request> req, std::shared_ptr<response>
     switch(rq.command_case()) {
     case tateyama::proto::request::request::Request::CommandCase::kListRequest:
     {
-        tateyama::proto::request::response::ListRequest rs{};
+        auto& rs = *tateyama::utils::request_arena::create<tateyama::proto::request::response::ListRequest>();
         auto &lr = rq.list_request();
         std::optional<std::uint32_t> top_opt{};
         std::optional<std::uint32_t> service_id_opt{};
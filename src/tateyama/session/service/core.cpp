@@ -25,6 +25,8 @@
 #include <tateyama/proto/session/response.pb.h>
 #include <tateyama/proto/session/diagnostic.pb.h>
 
+#include <tateyama/utils/protobuf_arena.h>
+
 #include "tateyama/session/resource/context_impl.h"
 #include "tateyama/endpoint/common/worker_common.h"
 
@@ -52,7 +54,8 @@ bool tateyama::session::service::core::operator()(const std::shared_ptr<request>
     try {
 
         bool return_code =true;
-        tateyama::proto::session::request::Request rq{};
+        tateyama::utils::request_arena::scope arena_scope{};
+        auto& rq = *tateyama::utils::request_arena::create<tateyama::proto::session::request::Request>();
 
         auto data = req->payload();
         if(!rq.ParseFromArray(data.data(), static_cast<int>(data.size()))) {
@@ -65,7 +68,7 @@ bool tateyama::session::service::core::operator()(const std::shared_ptr<request>
         switch(rq.command_case()) {
         case tateyama::proto::session::request::Request::kSessionGet:
         {
-            tateyama::proto::session::response::SessionGet rs{};
+            auto& rs = *tateyama::utils::request_arena::create<tateyama::proto::session::response::SessionGet>();
             auto& cmd = rq.session_get();
             auto rv = resource_->get(cmd.session_specifier(), rs.mutable_success(), req->session_info());
             if (!rv) {
@@ -80,7 +83,7 @@ bool tateyama::session::service::core::operator()(const std::shared_ptr<request>
 
         case tateyama::proto::session::request::Request::kSessionList:
         {
-            tateyama::proto::session::response::SessionList rs{};
+            auto& rs = *tateyama::utils::request_arena::create<tateyama::proto::session::response::SessionList>();
             auto rv = resource_->list(rs.mutable_success(), session_id, req->session_info());
             if (!rv) {
                 res->body(rs.SerializeAsString());
@@ -111,6 +114,9 @@ bool tateyama::session::service::core::operator()(const std::shared_ptr<request>
             std::shared_ptr<tateyama::session::session_context> session_context{};
             auto rv = resource_->session_shutdown(cmd.session_specifier(), type, session_context, req->session_info());
             if (!rv) {
+                if (auto worker = reinterpret_cast<tateyama::session::resource::session_context_impl*>(session_context.get())->get_session_worker(); worker) {  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                    worker->wake_up();
+                }
                 std::thread th([res, session_context]{
                     while (true) {
                         auto* session_context_impl = reinterpret_cast<tateyama::session::resource::session_context_impl*>(session_context.get());  // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <tateyama/utils/protobuf_arena.h>
+
+#include <memory>
+#include <stdexcept>
+
+namespace tateyama::utils {
+
+namespace {
+
+class thread_arena {
+public:
+    thread_arena() : block_(std::make_unique<char[]>(request_arena::initial_block_size)), arena_(options(block_.get())) {  // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    }
+
+    google::protobuf::Arena* get() {
+        if (depth_ == 0) {
+            throw std::logic_error("no request_arena::scope is active on this thread");
+        }
+        return &arena_;
+    }
+    void enter() noexcept {
+        ++depth_;
+    }
+    void leave() noexcept {
+        if (--depth_ == 0) {
+            arena_.Reset();  // the initial block, which is owned by block_, is kept
+        }
+    }
+    [[nodiscard]] std::size_t space_used() const noexcept {
+        return arena_.SpaceUsed();
+    }
+
+private:
+    std::unique_ptr<char[]> block_;  // NOLINT(cppcoreguidelines-avoid-c-arrays)
+    google::protobuf::Arena arena_;
+    std::size_t depth_{};
+
+    static google::protobuf::ArenaOptions options(char* block) noexcept {
+        google::protobuf::ArenaOptions opts{};
+        opts.initial_block = block;
+        opts.initial_block_size = request_arena::initial_block_size;
+        opts.max_block_size = request_arena::max_block_size;
+        return opts;
+    }
+};
+
+thread_arena& current() {
+    thread_local thread_arena arena{};
+    return arena;
+}
+
+}  // namespace
+
+request_arena::scope::scope() {
+    current().enter();
+}
+
+request_arena::scope::~scope() {
+    current().leave();
+}
+
+google::protobuf::Arena* request_arena::arena() {
+    return current().get();
+}
+
+std::size_t request_arena::space_used() noexcept {
+    return current().space_used();
+}
+
+}  // namespace tateyama::utils
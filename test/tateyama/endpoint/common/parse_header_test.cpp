@@ -0,0 +1,104 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tateyama/endpoint/common/endpoint_proto_utils.h"
+#include "tateyama/endpoint/header_utils.h"
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::common {
+
+using blobs_map_type = std::map<std::string, std::pair<std::variant<std::string, proto::framework::common::BlobRelayReference>, bool>>;
+
+class parse_header_test: public ::testing::Test {
+protected:
+    static constexpr std::string_view payload{"request_payload"};
+
+    static std::string request(std::size_t session_id, std::size_t service_id, std::set<std::tuple<std::string, std::string, bool>>* blobs = nullptr) {
+        std::stringstream ss{};
+        EXPECT_TRUE(append_request_header(ss, payload, request_header_content{session_id, service_id, blobs}));
+        return ss.str();
+    }
+    static std::string request(::tateyama::proto::framework::request::Header const& hdr, std::string_view body) {
+        std::stringstream ss{};
+        EXPECT_TRUE(utils::SerializeDelimitedToOstream(hdr, std::addressof(ss)));
+        EXPECT_TRUE(utils::PutDelimitedBodyToOstream(body, std::addressof(ss)));
+        return ss.str();
+    }
+};
+
+TEST_F(parse_header_test, no_blobs) {
+    for (std::size_t id : {std::size_t{0}, std::size_t{1}, std::size_t{127}, std::size_t{128}, std::size_t{1} << 40U}) {
+        auto message = request(id, id + 1);
+        parse_result result{};
+        ASSERT_TRUE(details::parse_header_fast(message, result));
+        EXPECT_EQ(result.session_id_, id);
+        EXPECT_EQ(result.service_id_, id + 1);
+        EXPECT_EQ(result.service_message_version_major_, request_header_content::FRAMEWORK_SERVICE_MESSAGE_VERSION_MAJOR);
+        EXPECT_EQ(result.service_message_version_minor_, request_header_content::FRAMEWORK_SERVICE_MESSAGE_VERSION_MINOR);
+        EXPECT_EQ(result.payload_, payload);
+
+        blobs_map_type blobs{};
+        parse_result full{};
+        ASSERT_TRUE(parse_header(message, full, blobs));
+        EXPECT_EQ(full.session_id_, id);
+        EXPECT_EQ(full.payload_, payload);
+        EXPECT_TRUE(blobs.empty());
+    }
+}
+
+TEST_F(parse_header_test, with_blobs) {
+    std::set<std::tuple<std::string, std::string, bool>> blobs{{"channel", "/tmp/blob_file", false}};
+    auto message = request(10, 3, &blobs);
+    parse_result result{};
+    EXPECT_FALSE(details::parse_header_fast(message, result));
+
+    blobs_map_type map{};
+    ASSERT_TRUE(parse_header(message, result, map));
+    EXPECT_EQ(result.session_id_, 10);
+    EXPECT_EQ(result.service_id_, 3);
+    EXPECT_EQ(result.payload_, payload);
+    ASSERT_EQ(map.size(), 1);
+    EXPECT_EQ(std::get<std::string>(map.at("channel").first), "/tmp/blob_file");
+}
+
+TEST_F(parse_header_test, empty_body) {
+    ::tateyama::proto::framework::request::Header hdr{};
+    hdr.set_session_id(1);
+    auto message = request(hdr, "");
+    parse_result result{};
+    EXPECT_FALSE(details::parse_header_fast(message, result));
+
+    // the result is left to the protobuf path
+    blobs_map_type map{};
+    parse_result expected{};
+    ::tateyama::proto::framework::request::Header parsed{};
+    google::protobuf::io::ArrayInputStream in{message.data(), static_cast<int>(message.size())};
+    ASSERT_TRUE(utils::ParseDelimitedFromZeroCopyStream(std::addressof(parsed), std::addressof(in), nullptr));
+    EXPECT_EQ(parse_header(message, result, map), utils::GetDelimitedBodyFromZeroCopyStream(std::addressof(in), nullptr, expected.payload_));
+}
+
+TEST_F(parse_header_test, broken) {
+    auto message = request(1, 2);
+    blobs_map_type map{};
+    for (std::size_t len = 0; len < message.size(); len++) {
+        parse_result result{};
+        EXPECT_FALSE(details::parse_header_fast(std::string_view(message.data(), len), result));
+        EXPECT_FALSE(parse_header(std::string_view(message.data(), len), result, map));
+    }
+}
+
+}
@@ -0,0 +1,239 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+
+#include <tateyama/framework/component_ids.h>
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::common::wire {
+
+// plays a client writing the entry directly into the shared memory
+class admin_channel_test_peer {
+public:
+    static void set_lengths(admin_channel::entry const& e, std::size_t credential_length, std::size_t payload_length) {
+        auto& entry = const_cast<admin_channel::entry&>(e);  // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        entry.credential_length_.store(credential_length);
+        entry.payload_length_.store(payload_length);
+    }
+};
+
+}
+
+namespace tateyama::endpoint::ipc {
+
+using admin_channel = tateyama::common::wire::admin_channel;
+
+static constexpr std::string_view database_name = "admin_channel_test";
+static constexpr std::size_t threads = 8;
+static constexpr std::size_t admin_sessions = 2;
+static constexpr std::size_t buffer_size = 1024;
+static constexpr std::size_t clients = 16;
+static constexpr std::size_t requests = 200;
+
+class admin_channel_test : public ::testing::Test {
+    void SetUp() override {
+        container_ = std::make_unique<bootstrap::connection_container>(database_name, threads, admin_sessions, buffer_size);
+        channel_ = container_->get_admin_channel();
+    }
+    void TearDown() override {
+        if (server_.joinable()) {
+            channel_->interrupt();
+            server_.join();
+        }
+    }
+
+protected:
+    std::unique_ptr<bootstrap::connection_container> container_{};
+    admin_channel* channel_{};
+    std::thread server_{};
+    std::atomic_bool stop_{};
+
+    // echoes the payload tagged by the client id
+    void start_echo_server() {
+        server_ = std::thread([this]{
+            while (!stop_.load()) {
+                auto idx = channel_->take(100 * 1000);
+                if (idx == admin_channel::no_entry) {
+                    continue;
+                }
+                admin_channel::request_image image{};
+                ASSERT_TRUE(channel_->copy_request(idx, image));
+                auto response = std::to_string(image.client_id_) + ":" + image.payload_;
+                channel_->respond(idx, response, false);
+            }
+        });
+    }
+    static std::size_t acquire(admin_channel& channel, std::uint64_t client_id) {
+        while (true) {
+            try {
+                return channel.acquire(client_id);
+            } catch (std::runtime_error&) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+TEST_F(admin_channel_test, no_admin_channel) {
+    bootstrap::connection_container container("admin_channel_test_none", threads, admin_sessions);
+    EXPECT_EQ(container.get_admin_channel(), nullptr);
+}
+
+TEST_F(admin_channel_test, multiplexed) {
+    ASSERT_NE(channel_, nullptr);
+    EXPECT_EQ(channel_->entries(), admin_sessions * bootstrap::connection_container::admin_channel_entries_per_session);
+    start_echo_server();
+
+    std::vector<std::thread> client_threads{};
+    std::atomic_size_t received{};
+    for (std::size_t c = 1; c <= clients; c++) {
+        client_threads.emplace_back([this, c, &received]{
+            boost::interprocess::managed_shared_memory shm(boost::interprocess::open_only, std::string(database_name).c_str());
+            auto* channel = shm.find<admin_channel>(admin_channel::name).first;
+            ASSERT_NE(channel, nullptr);
+            for (std::size_t n = 0; n < requests; n++) {
+                auto idx = acquire(*channel, c);
+                auto payload = std::to_string(n);
+                channel->request(idx, tateyama::framework::service_id_metrics, "", payload);
+                auto const& e = channel->receive(idx, 10 * 1000 * 1000);
+                EXPECT_FALSE(e.is_error());
+                EXPECT_EQ(e.response(), std::to_string(c) + ":" + payload);
+                channel->release(idx);
+                received++;
+            }
+        });
+    }
+    for (auto&& t : client_threads) {
+        t.join();
+    }
+    EXPECT_EQ(received.load(), clients * requests);
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+    stop_.store(true);
+}
+
+TEST_F(admin_channel_test, timeout) {
+    auto idx = channel_->acquire(1);
+    channel_->request(idx, tateyama::framework::service_id_session, "", "request");
+    EXPECT_THROW(static_cast<void>(channel_->receive(idx, 100 * 1000)), std::runtime_error);
+    EXPECT_EQ(channel_->entries_in_use(), 1);
+
+    // the server gives back the entry abandoned
+    auto taken = channel_->take(0);
+    EXPECT_EQ(taken, admin_channel::no_entry);
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+}
+
+TEST_F(admin_channel_test, timeout_while_serving) {
+    auto idx = channel_->acquire(1);
+    channel_->request(idx, tateyama::framework::service_id_session, "", "request");
+    auto taken = channel_->take(0);
+    ASSERT_EQ(taken, idx);
+    EXPECT_THROW(static_cast<void>(channel_->receive(idx, 100 * 1000)), std::runtime_error);
+
+    EXPECT_TRUE(channel_->respond(taken, "response", false));
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+}
+
+TEST_F(admin_channel_test, response_too_large) {
+    auto idx = channel_->acquire(1);
+    channel_->request(idx, tateyama::framework::service_id_request, "", "request");
+    auto taken = channel_->take(0);
+    ASSERT_EQ(taken, idx);
+    EXPECT_FALSE(channel_->respond(taken, std::string(buffer_size + 1, 'a'), false));
+    EXPECT_TRUE(channel_->respond(taken, "error", true));
+
+    auto const& e = channel_->receive(idx);
+    EXPECT_TRUE(e.is_error());
+    EXPECT_EQ(e.response(), "error");
+    channel_->release(idx);
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+}
+
+TEST_F(admin_channel_test, request_too_large) {
+    auto idx = channel_->acquire(1);
+    EXPECT_THROW(channel_->request(idx, tateyama::framework::service_id_request, "credential", std::string(buffer_size, 'a')), std::runtime_error);
+}
+
+TEST_F(admin_channel_test, reclaim) {
+    static constexpr std::uint64_t exited = 2;
+    auto left = channel_->acquire(exited);
+    auto idx = channel_->acquire(1);
+    channel_->request(idx, tateyama::framework::service_id_request, "", "request");
+    auto taken = channel_->take(0);
+    EXPECT_TRUE(channel_->respond(taken, "response", false));
+    EXPECT_EQ(channel_->entries_in_use(), 2);
+
+    // the entries of the live client are untouched, even the responded one
+    EXPECT_EQ(channel_->reclaim([](std::uint64_t id){ return id != exited; }), 1);
+    EXPECT_EQ(channel_->entries_in_use(), 1);
+    EXPECT_EQ(channel_->at(left).get_state(), admin_channel::entry::state::free);
+    EXPECT_EQ(channel_->receive(idx).response(), "response");
+    channel_->release(idx);
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+}
+
+TEST_F(admin_channel_test, oversized_lengths) {
+    auto idx = channel_->acquire(1);
+    channel_->request(idx, tateyama::framework::service_id_request, "credential", "request");
+    auto taken = channel_->take(0);
+    ASSERT_EQ(taken, idx);
+
+    admin_channel::request_image image{};
+    ASSERT_TRUE(channel_->copy_request(taken, image));
+    EXPECT_EQ(image.service_id_, tateyama::framework::service_id_request);
+    EXPECT_EQ(image.credential_, "credential");
+    EXPECT_EQ(image.payload_, "request");
+
+    // the lengths rewritten by the client are rejected, including the ones overflowing the sum
+    tateyama::common::wire::admin_channel_test_peer::set_lengths(channel_->at(taken), buffer_size, 1);
+    EXPECT_FALSE(channel_->copy_request(taken, image));
+    tateyama::common::wire::admin_channel_test_peer::set_lengths(channel_->at(taken), 1, buffer_size);
+    EXPECT_FALSE(channel_->copy_request(taken, image));
+    tateyama::common::wire::admin_channel_test_peer::set_lengths(channel_->at(taken), UINT64_MAX, 2);
+    EXPECT_FALSE(channel_->copy_request(taken, image));
+    EXPECT_EQ(image.payload_, "request");  // left unchanged
+    tateyama::common::wire::admin_channel_test_peer::set_lengths(channel_->at(taken), 0, buffer_size);
+    EXPECT_TRUE(channel_->copy_request(taken, image));
+    EXPECT_EQ(image.payload_.length(), buffer_size);
+
+    EXPECT_TRUE(channel_->respond(taken, "error", true));
+    channel_->release(idx);
+    EXPECT_EQ(channel_->entries_in_use(), 0);
+}
+
+TEST_F(admin_channel_test, admin_slot_budget) {
+    // the requests being served and the admin sessions take the slots from the same pool
+    auto& connection_queue = container_->get_connection_queue();
+    std::vector<std::size_t> slots{};
+    while (true) {
+        try {
+            slots.emplace_back(connection_queue.acquire_admin_slot());
+        } catch (std::runtime_error&) {
+            break;
+        }
+    }
+    EXPECT_GE(slots.size(), admin_sessions);
+    EXPECT_THROW(static_cast<void>(connection_queue.request_admin()), std::runtime_error);
+
+    for (auto sid : slots) {
+        connection_queue.release_admin_slot(sid);
+    }
+    EXPECT_NO_THROW(static_cast<void>(connection_queue.request_admin()));
+}
+
+}
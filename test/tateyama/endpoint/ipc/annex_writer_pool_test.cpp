@@ -0,0 +1,154 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::ipc {
+
+using client_resultset_wires = bootstrap::server_wire_container_impl::resultset_wires_container_impl;
+
+static constexpr std::size_t datachannel_buffer_size = 4 * 1024;
+static constexpr std::size_t writers = 8;
+static constexpr std::size_t records = 500;
+static constexpr std::size_t record_size = 100;
+static constexpr std::string_view resultset_name = "resultset_1";
+
+class annex_writer_pool_test : public ::testing::Test {
+    void SetUp() override {
+        rv_ = system("if [ -f /dev/shm/annex_writer_pool_test ]; then rm -f /dev/shm/annex_writer_pool_test*; fi ");
+        pool_ = std::make_shared<bootstrap::annex_writer_pool>(2);
+        wire_ = std::make_unique<bootstrap::server_wire_container_impl>("annex_writer_pool_test", "dummy_mutex_file_name", datachannel_buffer_size, writers, [](){}, nullptr, pool_);
+    }
+    void TearDown() override {
+        rv_ = system("if [ -f /dev/shm/annex_writer_pool_test ]; then rm -f /dev/shm/annex_writer_pool_test*; fi ");
+    }
+
+    int rv_;
+
+protected:
+    std::shared_ptr<bootstrap::annex_writer_pool> pool_{};
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_{};
+
+    std::size_t read_records(client_resultset_wires& client) {
+        std::vector<std::size_t> next(writers);
+        std::size_t received{};
+        while (true) {
+            std::string r{};
+            while (r.length() < record_size) {
+                auto chunk = client.get_chunk();
+                if (chunk.empty()) {
+                    break;
+                }
+                r += chunk;
+            }
+            if (r.empty()) {
+                break;
+            }
+            client.dispose(0);
+            EXPECT_EQ(r.length(), record_size);
+            std::size_t writer = r.back() - 'a';
+            if (writer >= writers) {
+                ADD_FAILURE() << "unexpected record " << r;
+                break;
+            }
+            EXPECT_EQ(r, record(writer, next.at(writer)++));
+            received++;
+        }
+        return received;
+    }
+    static std::string record(std::size_t writer, std::size_t n) {
+        std::string r(record_size, static_cast<char>('a' + writer));
+        auto s = std::to_string(n);
+        r.replace(0, s.length(), s);
+        return r;
+    }
+    void write_records(server_wire_container::resultset_wires_container& rs, std::size_t writer) {
+        auto w = rs.acquire();
+        for (std::size_t n = 0; n < records; n++) {
+            auto r = record(writer, n);
+            w->write(r.data(), r.length());
+            w->flush();
+        }
+        auto* wp = w.get();
+        wp->release(std::move(w));
+    }
+};
+
+TEST_F(annex_writer_pool_test, slow_client) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    std::vector<std::thread> threads{};
+    for (std::size_t i = 0; i < writers; i++) {
+        threads.emplace_back([this, &rs, i]{ write_records(*rs, i); });
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    rs->set_eor();
+    EXPECT_GT(pool_->buffered_bytes(), 0);
+
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+    auto received = read_records(*client);
+    EXPECT_EQ(received, writers * records);
+    EXPECT_TRUE(client->is_eor());
+    EXPECT_EQ(pool_->buffered_bytes(), 0);
+    EXPECT_EQ(pool_->stalled_tasks(), 0);
+    EXPECT_GT(pool_->stall_time(), 0);
+    EXPECT_TRUE(rs->is_disposable());
+}
+
+TEST_F(annex_writer_pool_test, closed_by_client) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    write_records(*rs, 0);
+    EXPECT_GT(pool_->buffered_bytes(), 0);
+    EXPECT_FALSE(rs->is_disposable());
+
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+    rs->force_close();
+    for (std::size_t i = 0; i < 1000 && !rs->is_disposable(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(rs->is_disposable());
+    EXPECT_EQ(pool_->buffered_bytes(), 0);
+    EXPECT_EQ(pool_->stalled_tasks(), 0);
+}
+
+TEST_F(annex_writer_pool_test, spill_beyond_limit) {
+    pool_->set_memory_limit(4 * datachannel_buffer_size, 2 * datachannel_buffer_size, "");
+
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    std::vector<std::thread> threads{};
+    for (std::size_t i = 0; i < writers; i++) {
+        threads.emplace_back([this, &rs, i]{ write_records(*rs, i); });
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    rs->set_eor();
+    EXPECT_LE(pool_->heap_bytes(), 4 * datachannel_buffer_size);
+    EXPECT_GT(pool_->spilled_bytes(), 0);
+
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+    EXPECT_EQ(read_records(*client), writers * records);
+    EXPECT_TRUE(client->is_eor());
+    EXPECT_EQ(pool_->buffered_bytes(), 0);
+    EXPECT_EQ(pool_->heap_bytes(), 0);
+    EXPECT_EQ(pool_->spilled_bytes(), 0);
+}
+
+}
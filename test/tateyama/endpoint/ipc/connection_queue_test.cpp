@@ -20,12 +20,14 @@
 #include <thread>
 
 #include "tateyama/endpoint/ipc/bootstrap/server_wires_impl.h"
+#include "tateyama/endpoint/ipc/bootstrap/session_setup_pool.h"
 
 namespace tateyama::endpoint::ipc {
 
 static constexpr std::string_view database_name = "connection_queue_test";
 static constexpr std::size_t threads = 104;
 static constexpr std::uint8_t admin_sessions = 1;
+static constexpr auto setup_time = std::chrono::milliseconds(20);
 
 class connection_queue_test : public ::testing::Test {
     class listener {
@@ -47,6 +49,23 @@ class connection_queue_test : public ::testing::Test {
                 if (connection_queue.is_terminated()) {
                     break;
                 }
+                if (setup_pool_ != nullptr) {
+                    auto index = connection_queue.take();
+                    setup_pool_->submit([this, &connection_queue, index, session_id]{
+                        std::this_thread::sleep_for(setup_time);
+                        auto idx = tateyama::common::wire::connection_queue::reset_admin(index);
+                        {
+                            std::lock_guard<std::mutex> lock(mtx_sessions_);
+                            EXPECT_EQ(sessions_.at(idx), inactive_session_id);
+                            sessions_.at(idx) = session_id;
+                        }
+                        if (auto elapsed = connection_queue.elapsed(index); elapsed) {
+                            setup_pool_->record_accept(elapsed.value());
+                        }
+                        connection_queue.accept_taken(index, session_id);
+                    });
+                    continue;
+                }
                 std::size_t index = connection_queue.slot();
                 auto idx = tateyama::common::wire::connection_queue::reset_admin(index);
                 if (reject_) {
@@ -57,13 +76,19 @@ class connection_queue_test : public ::testing::Test {
                     connection_queue.accept(index, session_id);
                 }
             }
+            if (setup_pool_ != nullptr) {
+                setup_pool_->stop();
+            }
             connection_queue.confirm_terminated();
         }
 
         void disconnect(std::size_t index, std::size_t session_id) {
             auto idx = tateyama::common::wire::connection_queue::reset_admin(index);
-            EXPECT_EQ(sessions_.at(idx), session_id);
-            sessions_.at(idx) = inactive_session_id;
+            {
+                std::lock_guard<std::mutex> lock(mtx_sessions_);
+                EXPECT_EQ(sessions_.at(idx), session_id);
+                sessions_.at(idx) = inactive_session_id;
+            }
             container_.get_connection_queue().disconnect(index);
         }
 
@@ -71,10 +96,16 @@ class connection_queue_test : public ::testing::Test {
             reject_ = true;
         }
 
+        void set_setup_pool(tateyama::endpoint::ipc::bootstrap::session_setup_pool* pool) {
+            setup_pool_ = pool;
+        }
+
     private:
         tateyama::endpoint::ipc::bootstrap::connection_container& container_;
         std::vector<std::size_t> sessions_{};
+        std::mutex mtx_sessions_{};
         bool reject_{};
+        tateyama::endpoint::ipc::bootstrap::session_setup_pool* setup_pool_{};
     };
 
     void SetUp() override {
@@ -122,12 +153,24 @@ protected:
         listener_->set_reject_mode();
     }
 
+    tateyama::endpoint::ipc::bootstrap::session_setup_pool& set_setup_pool(std::size_t setup_threads) {
+        setup_pool_ = std::make_unique<tateyama::endpoint::ipc::bootstrap::session_setup_pool>(setup_threads);
+        listener_->set_setup_pool(setup_pool_.get());
+        return *setup_pool_;
+    }
+
 private:
+    std::unique_ptr<tateyama::endpoint::ipc::bootstrap::session_setup_pool> setup_pool_{};
     std::unique_ptr<tateyama::endpoint::ipc::bootstrap::connection_container> container_ { };
     std::unique_ptr<listener> listener_{};
     std::thread listener_thread_;
 };
 
+TEST_F(connection_queue_test, layout_version) {
+    boost::interprocess::managed_shared_memory managed_shm(boost::interprocess::open_only, std::string(database_name).c_str());
+    EXPECT_EQ(tateyama::common::wire::connection_layout(managed_shm), tateyama::common::wire::connection_layout_version);
+}
+
 TEST_F(connection_queue_test, normal_session_limit) {
     std::vector<std::size_t> session_ids{};
 
@@ -197,4 +240,31 @@ TEST_F(connection_queue_test, many) {
     }
 }
 
+TEST_F(connection_queue_test, parallel_setup) {
+    static constexpr std::size_t setup_threads = 8;
+    static constexpr std::size_t clients = 32;
+    auto& pool = set_setup_pool(setup_threads);
+
+    std::vector<std::thread> cthreads{};
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < clients; i++) {
+        cthreads.emplace_back([this](){
+            std::size_t slot{};
+            auto sid = connect(slot);
+            EXPECT_NE(sid, UINT64_MAX);
+            disconnect(slot, sid);
+        });
+    }
+    for (auto& thread: cthreads) {
+        thread.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    // the sessions are set up in parallel, rather than one after another by the listener
+    EXPECT_LT(elapsed, setup_time * clients / 2);
+    EXPECT_EQ(pool.accepted(), clients);
+    EXPECT_GE(pool.accept_latency_max(), std::chrono::duration_cast<std::chrono::microseconds>(setup_time).count());
+    EXPECT_GT(pool.accept_latency_average(), 0);
+}
+
 }
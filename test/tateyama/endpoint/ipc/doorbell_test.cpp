@@ -0,0 +1,193 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+#include <set>
+#include <vector>
+#include <atomic>
+
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::ipc {
+
+static constexpr std::string_view database_name = "doorbell_test";
+static constexpr std::string_view session_name = "doorbell_test-1";
+static constexpr std::size_t threads = 8;
+static constexpr std::uint8_t admin_sessions = 1;
+static constexpr std::size_t slot_index = 3;
+static constexpr std::int64_t timeout = 100 * 1000;  // 100 ms
+
+class doorbell_test : public ::testing::Test {
+    static constexpr std::size_t datachannel_buffer_size = 64 * 1024;
+
+    void SetUp() override {
+        rv_ = system("if [ -f /dev/shm/doorbell_test ]; then rm -f /dev/shm/doorbell_test*; fi ");
+        container_ = std::make_unique<bootstrap::connection_container>(database_name, threads, admin_sessions);
+        wire_ = std::make_unique<bootstrap::server_wire_container_impl>(session_name, "dummy_mutex_file_name", datachannel_buffer_size, 16);
+        wire_->enable_doorbell(slot_index);
+        request_wire_ = static_cast<bootstrap::server_wire_container_impl::wire_container_impl*>(wire_->get_request_wire());
+
+        // client side
+        managed_shm_ = std::make_unique<boost::interprocess::managed_shared_memory>(boost::interprocess::open_only, std::string(session_name).c_str());
+        client_wire_ = managed_shm_->find<tateyama::common::wire::unidirectional_message_wire>(tateyama::common::wire::request_wire_name).first;
+    }
+    void TearDown() override {
+        rv_ = system("if [ -f /dev/shm/doorbell_test ]; then rm -f /dev/shm/doorbell_test*; fi ");
+    }
+
+    int rv_;
+
+protected:
+    std::unique_ptr<bootstrap::connection_container> container_{};
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_{};
+    bootstrap::server_wire_container_impl::wire_container_impl* request_wire_{};
+
+    std::unique_ptr<boost::interprocess::managed_shared_memory> managed_shm_{};
+    tateyama::common::wire::unidirectional_message_wire* client_wire_{};
+
+    tateyama::common::wire::connection_queue::doorbell& doorbell() {
+        return container_->get_connection_queue().get_doorbell();
+    }
+    void client_write(const std::string& message, tateyama::common::wire::message_header::index_type index) {
+        client_wire_->write(client_wire_->get_bip_address(managed_shm_.get()), message.data(), tateyama::common::wire::message_header(index, message.length()));
+        if (client_wire_->arm_doorbell()) {
+            doorbell().ring(client_wire_->doorbell_slot());
+        }
+    }
+};
+
+TEST_F(doorbell_test, attach) {
+    EXPECT_FALSE(request_wire_->doorbell_attached());
+    EXPECT_TRUE(client_wire_->attach_doorbell());
+    EXPECT_TRUE(request_wire_->doorbell_attached());
+    EXPECT_EQ(client_wire_->doorbell_slot(), slot_index);
+}
+
+TEST_F(doorbell_test, ring_once_until_disarmed) {
+    EXPECT_TRUE(client_wire_->attach_doorbell());
+    EXPECT_FALSE(request_wire_->has_request());
+
+    client_write("request_1", 1);
+    client_write("request_2", 2);
+    EXPECT_EQ(doorbell().wait(timeout), slot_index);
+    EXPECT_EQ(doorbell().wait(timeout), tateyama::common::wire::connection_queue::doorbell::no_slot);
+
+    request_wire_->disarm_doorbell();
+    for (std::size_t i = 1; i <= 2; i++) {
+        EXPECT_TRUE(request_wire_->has_request());
+        auto h = request_wire_->peep();
+        EXPECT_EQ(h.get_idx(), i);
+        request_wire_->payload();
+        request_wire_->dispose();
+    }
+    EXPECT_FALSE(request_wire_->has_request());
+
+    client_write("request_3", 3);
+    EXPECT_EQ(doorbell().wait(timeout), slot_index);
+    EXPECT_TRUE(request_wire_->has_request());
+}
+
+TEST_F(doorbell_test, wake_up_waiting_thread) {
+    std::size_t slot{tateyama::common::wire::connection_queue::doorbell::no_slot};
+    std::thread th([this, &slot](){
+        slot = doorbell().wait(10 * 1000 * 1000);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    doorbell().ring(slot_index);
+    th.join();
+    EXPECT_EQ(slot, slot_index);
+}
+
+TEST_F(doorbell_test, interrupt) {
+    std::size_t slot{};
+    std::thread th([this, &slot](){
+        slot = doorbell().wait(10 * 1000 * 1000);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    doorbell().interrupt();
+    th.join();
+    EXPECT_EQ(slot, tateyama::common::wire::connection_queue::doorbell::no_slot);
+}
+
+TEST_F(doorbell_test, coalesce) {
+    std::size_t slots = threads + admin_sessions;
+    for (std::size_t n = 0; n < 2; n++) {
+        for (std::size_t i = 0; i < slots; i++) {
+            doorbell().ring(i);
+        }
+    }
+    doorbell().ring(slots);  // out of range
+    std::set<std::size_t> taken{};
+    for (std::size_t i = 0; i < slots; i++) {
+        auto slot = doorbell().wait(timeout);
+        EXPECT_LT(slot, slots);
+        taken.emplace(slot);
+    }
+    EXPECT_EQ(taken.size(), slots);
+    EXPECT_EQ(doorbell().wait(timeout), tateyama::common::wire::connection_queue::doorbell::no_slot);
+}
+
+TEST_F(doorbell_test, take_in_turn) {
+    doorbell().ring(1);
+    doorbell().ring(5);
+    EXPECT_EQ(doorbell().wait(timeout), 1);
+    doorbell().ring(1);  // rung again before the other slot is taken
+    EXPECT_EQ(doorbell().wait(timeout), 5);
+    EXPECT_EQ(doorbell().wait(timeout), 1);
+}
+
+TEST_F(doorbell_test, concurrent_rings) {
+    static constexpr std::size_t rings = 10000;
+    std::size_t slots = threads + admin_sessions;
+    std::vector<std::atomic_size_t> pending(slots);
+    std::atomic_size_t served{};
+    std::atomic_bool done{};
+
+    std::vector<std::thread> io_threads{};
+    for (std::size_t t = 0; t < 2; t++) {
+        io_threads.emplace_back([this, &pending, &served, &done]{
+            while (!done.load()) {
+                if (auto slot = doorbell().wait(timeout); slot != tateyama::common::wire::connection_queue::doorbell::no_slot) {
+                    served += pending.at(slot).exchange(0);
+                }
+            }
+        });
+    }
+    std::vector<std::thread> clients{};
+    for (std::size_t c = 0; c < slots; c++) {
+        clients.emplace_back([this, &pending, c]{
+            for (std::size_t n = 0; n < rings; n++) {
+                pending.at(c)++;
+                doorbell().ring(c);
+            }
+        });
+    }
+    for (auto&& c : clients) {
+        c.join();
+    }
+    for (std::size_t n = 0; n < 100 && served.load() < slots * rings; n++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(served.load(), slots * rings);  // every ring is followed by a wake up taking the slot
+    done.store(true);
+    doorbell().interrupt();
+    for (auto&& t : io_threads) {
+        t.join();
+    }
+}
+
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::ipc {
+
+static constexpr std::size_t datachannel_buffer_size = 4 * 1024;
+static constexpr std::size_t resultsets = 64;
+
+class garbage_collector_test : public ::testing::Test {
+    void SetUp() override {
+        rv_ = system("if [ -f /dev/shm/garbage_collector_test ]; then rm -f /dev/shm/garbage_collector_test*; fi ");
+        auto pool = std::make_shared<bootstrap::resultset_buffer_pool>(bootstrap::server_wire_container_impl::resultset_buffer_size(datachannel_buffer_size), resultsets, 0);
+        wire_ = std::make_unique<bootstrap::server_wire_container_impl>("garbage_collector_test", "dummy_mutex_file_name", datachannel_buffer_size, resultsets, [](){}, pool);
+    }
+    void TearDown() override {
+        rv_ = system("if [ -f /dev/shm/garbage_collector_test ]; then rm -f /dev/shm/garbage_collector_test*; fi ");
+    }
+
+    int rv_;
+
+protected:
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_{};
+
+    static std::string name(std::size_t i) {
+        return "resultset_" + std::to_string(i);
+    }
+    void put(std::size_t i) {
+        auto rs = wire_->create_resultset_wires(name(i), 1);
+        auto w = rs->acquire();
+        w->write("record", 6);
+        w->flush();
+        auto* wp = w.get();
+        wp->release(std::move(w));
+        rs->set_eor();
+        wire_->get_garbage_collector()->put(std::move(rs));
+    }
+    void close_by_client(std::size_t i) {
+        wire_->create_resultset_wires_for_client(name(i))->force_close();
+    }
+};
+
+TEST_F(garbage_collector_test, retire_closed) {
+    auto* gc = wire_->get_garbage_collector();
+    for (std::size_t i = 0; i < resultsets; i++) {
+        put(i);
+    }
+    gc->dump();
+    EXPECT_FALSE(gc->empty());
+    EXPECT_EQ(wire_->resultset_buffers(), resultsets);
+
+    for (std::size_t i = 0; i < resultsets; i += 2) {
+        close_by_client(i);
+    }
+    gc->dump();
+    EXPECT_EQ(wire_->resultset_buffers(), resultsets / 2);
+
+    for (std::size_t i = 1; i < resultsets; i += 2) {
+        close_by_client(i);
+    }
+    gc->dump();
+    EXPECT_EQ(wire_->resultset_buffers(), 0);
+    EXPECT_TRUE(gc->empty());
+}
+
+TEST_F(garbage_collector_test, put_while_dump) {
+    auto* gc = wire_->get_garbage_collector();
+    std::atomic_bool stop{};
+    std::thread th([gc, &stop](){
+        while (!stop.load()) {
+            gc->dump();
+        }
+    });
+    std::vector<std::thread> threads{};
+    for (std::size_t t = 0; t < 4; t++) {
+        threads.emplace_back([this, t](){
+            for (std::size_t i = t; i < resultsets; i += 4) {
+                put(i);
+                close_by_client(i);
+            }
+        });
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    stop.store(true);
+    th.join();
+    gc->dump();
+    EXPECT_TRUE(gc->empty());
+    EXPECT_EQ(wire_->resultset_buffers(), 0);
+}
+
+TEST_F(garbage_collector_test, force_close) {
+    auto* gc = wire_->get_garbage_collector();
+    put(0);
+    gc->force_close();
+    EXPECT_TRUE(gc->empty());
+    EXPECT_TRUE(wire_->create_resultset_wires_for_client(name(0))->is_closed());
+
+    put(1);  // put after force_close
+    EXPECT_TRUE(wire_->create_resultset_wires_for_client(name(1))->is_closed());
+}
+
+}
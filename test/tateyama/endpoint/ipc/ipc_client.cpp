@@ -26,6 +26,7 @@ ipc_client::ipc_client(std::shared_ptr<tateyama::api::configuration::whole> cons
     //
     session_name_ = database_name_ + "-" + std::to_string(session_id_);
     swc_ = std::make_unique < tsubakuro::common::wire::session_wire_container > (session_name_);
+    swc_->use_doorbell(container_->get_connection_queue());
     request_wire_ = &swc_->get_request_wire();
     response_wire_ = &swc_->get_response_wire();
 
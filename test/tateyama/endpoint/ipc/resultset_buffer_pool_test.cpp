@@ -0,0 +1,105 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::ipc {
+
+static constexpr std::size_t datachannel_buffer_size = 64 * 1024;
+static constexpr std::size_t max_datachannel_buffers = 4;
+static constexpr std::size_t max_datachannel_buffers_total = 6;
+
+class resultset_buffer_pool_test : public ::testing::Test {
+    void SetUp() override {
+        rv_ = system("if [ -f /dev/shm/resultset_buffer_pool_test-1 ]; then rm -f /dev/shm/resultset_buffer_pool_test-*; fi ");
+        pool_ = std::make_shared<bootstrap::resultset_buffer_pool>(bootstrap::server_wire_container_impl::resultset_buffer_size(datachannel_buffer_size), max_datachannel_buffers, max_datachannel_buffers_total);
+        wire_1_ = std::make_unique<bootstrap::server_wire_container_impl>("resultset_buffer_pool_test-1", "dummy_mutex_file_name", datachannel_buffer_size, max_datachannel_buffers, [](){}, pool_);
+        wire_2_ = std::make_unique<bootstrap::server_wire_container_impl>("resultset_buffer_pool_test-2", "dummy_mutex_file_name", datachannel_buffer_size, max_datachannel_buffers, [](){}, pool_);
+    }
+    void TearDown() override {
+        rv_ = system("if [ -f /dev/shm/resultset_buffer_pool_test-1 ]; then rm -f /dev/shm/resultset_buffer_pool_test-*; fi ");
+    }
+
+    int rv_;
+
+protected:
+    std::shared_ptr<bootstrap::resultset_buffer_pool> pool_{};
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_1_{};
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_2_{};
+};
+
+TEST_F(resultset_buffer_pool_test, no_resultset) {
+    EXPECT_EQ(pool_->in_use(), 0);
+    EXPECT_EQ(pool_->bytes_in_use(), 0);
+    EXPECT_EQ(wire_1_->resultset_buffers(), 0);
+}
+
+TEST_F(resultset_buffer_pool_test, reclaim_on_close) {
+    {
+        auto rs = wire_1_->create_resultset_wires("resultset_1", max_datachannel_buffers);
+        EXPECT_EQ(pool_->in_use(), 1);
+
+        auto w1 = rs->acquire();
+        EXPECT_EQ(pool_->in_use(), 1);  // the reserved buffer
+        auto w2 = rs->acquire();
+        auto w3 = rs->acquire();
+        EXPECT_EQ(pool_->in_use(), 3);
+        EXPECT_EQ(wire_1_->resultset_buffers(), 3);
+        EXPECT_EQ(pool_->bytes_in_use(), 3 * pool_->buffer_size());
+    }
+    EXPECT_EQ(pool_->in_use(), 0);
+    EXPECT_EQ(wire_1_->resultset_buffers(), 0);
+    EXPECT_EQ(pool_->peak(), 3);
+    EXPECT_EQ(pool_->rejected(), 0);
+}
+
+TEST_F(resultset_buffer_pool_test, session_quota) {
+    auto rs = wire_1_->create_resultset_wires("resultset_1", max_datachannel_buffers);
+    std::vector<server_wire_container::unq_p_resultset_wire_conteiner> writers{};
+    for (std::size_t i = 0; i < max_datachannel_buffers; i++) {
+        writers.emplace_back(rs->acquire());
+    }
+    EXPECT_THROW(rs->acquire(), std::runtime_error);
+    EXPECT_THROW(wire_1_->create_resultset_wires("resultset_2", max_datachannel_buffers), std::runtime_error);
+    EXPECT_EQ(pool_->rejected(), 2);
+
+    // the quota of the other session is not affected
+    auto rs2 = wire_2_->create_resultset_wires("resultset_1", max_datachannel_buffers);
+    EXPECT_EQ(pool_->in_use(), max_datachannel_buffers + 1);
+}
+
+TEST_F(resultset_buffer_pool_test, shared_capacity) {
+    auto rs1 = wire_1_->create_resultset_wires("resultset_1", max_datachannel_buffers);
+    std::vector<server_wire_container::unq_p_resultset_wire_conteiner> writers{};
+    for (std::size_t i = 0; i < max_datachannel_buffers; i++) {
+        writers.emplace_back(rs1->acquire());
+    }
+    auto rs2 = wire_2_->create_resultset_wires("resultset_1", max_datachannel_buffers);
+    writers.emplace_back(rs2->acquire());
+    writers.emplace_back(rs2->acquire());
+    EXPECT_EQ(pool_->in_use(), max_datachannel_buffers_total);
+    EXPECT_THROW(rs2->acquire(), std::runtime_error);
+    EXPECT_EQ(pool_->rejected(), 1);
+
+    writers.clear();
+    rs1 = nullptr;
+    EXPECT_EQ(pool_->in_use(), 2);
+    writers.emplace_back(rs2->acquire());
+    EXPECT_EQ(pool_->in_use(), 3);
+}
+
+}
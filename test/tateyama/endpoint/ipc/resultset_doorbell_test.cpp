@@ -0,0 +1,138 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <set>
+#include <thread>
+
+#include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::ipc {
+
+static constexpr std::size_t datachannel_buffer_size = 64 * 1024;
+static constexpr std::size_t writers = 70;  // spans two words of the ready bitmap
+static constexpr std::size_t records = 100;
+static constexpr std::string_view resultset_name = "resultset_1";
+
+class resultset_doorbell_test : public ::testing::Test {
+    void SetUp() override {
+        rv_ = system("if [ -f /dev/shm/resultset_doorbell_test ]; then rm -f /dev/shm/resultset_doorbell_test*; fi ");
+        wire_ = std::make_unique<bootstrap::server_wire_container_impl>("resultset_doorbell_test", "dummy_mutex_file_name", datachannel_buffer_size, writers, [](){});
+    }
+    void TearDown() override {
+        rv_ = system("if [ -f /dev/shm/resultset_doorbell_test ]; then rm -f /dev/shm/resultset_doorbell_test*; fi ");
+    }
+
+    int rv_;
+
+protected:
+    std::unique_ptr<bootstrap::server_wire_container_impl> wire_{};
+
+    static std::string record(std::size_t writer, std::size_t n) {
+        return std::to_string(writer) + ":" + std::to_string(n);
+    }
+};
+
+TEST_F(resultset_doorbell_test, many_writers) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    std::vector<server_wire_container::unq_p_resultset_wire_conteiner> ws{};
+    for (std::size_t i = 0; i < writers; i++) {
+        ws.emplace_back(rs->acquire());
+    }
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+
+    std::vector<std::thread> threads{};
+    for (std::size_t i = 0; i < writers; i++) {
+        threads.emplace_back([this, &ws, i]{
+            for (std::size_t n = 0; n < records; n++) {
+                auto r = record(i, n);
+                ws.at(i)->write(r.data(), r.length());
+                ws.at(i)->flush();
+            }
+        });
+    }
+
+    std::set<std::string> received{};
+    while (received.size() < writers * records) {
+        auto chunk = client->get_chunk(10 * 1000 * 1000);
+        ASSERT_FALSE(chunk.empty());
+        received.emplace(chunk);
+        client->dispose(0);
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    for (std::size_t i = 0; i < writers; i++) {
+        for (std::size_t n = 0; n < records; n++) {
+            EXPECT_TRUE(received.find(record(i, n)) != received.end());
+        }
+    }
+    for (auto&& w : ws) {
+        auto* wp = w.get();
+        wp->release(std::move(w));
+    }
+    rs->set_eor();
+    EXPECT_TRUE(client->get_chunk().empty());
+    EXPECT_TRUE(client->is_eor());
+}
+
+TEST_F(resultset_doorbell_test, publish_sealed_records_at_once) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    auto w = rs->acquire();
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+    boost::interprocess::managed_shared_memory managed_shm(boost::interprocess::open_only, "resultset_doorbell_test");
+    auto* shm_wires = managed_shm.find<tateyama::common::wire::shm_resultset_wires>(std::string(resultset_name).c_str()).first;
+    ASSERT_NE(shm_wires, nullptr);
+
+    auto rung = shm_wires->doorbell().load();
+    for (std::size_t n = 0; n < records; n++) {
+        auto r = record(0, n);
+        w->write(r.data(), r.length());
+        w->seal();
+    }
+    EXPECT_EQ(shm_wires->doorbell().load(), rung);
+    EXPECT_THROW(client->get_chunk(100 * 1000), std::runtime_error);
+
+    w->flush();
+    EXPECT_EQ(shm_wires->doorbell().load(), rung + 1);
+    for (std::size_t n = 0; n < records; n++) {
+        EXPECT_EQ(client->get_chunk(), record(0, n));
+        client->dispose(0);
+    }
+}
+
+TEST_F(resultset_doorbell_test, wake_up_on_eor) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+
+    std::thread th([&rs](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        rs->set_eor();
+    });
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(client->get_chunk(10 * 1000 * 1000).empty());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    th.join();
+}
+
+TEST_F(resultset_doorbell_test, timeout) {
+    auto rs = wire_->create_resultset_wires(resultset_name, writers);
+    auto client = wire_->create_resultset_wires_for_client(resultset_name);
+
+    EXPECT_THROW(client->get_chunk(100 * 1000), std::runtime_error);
+}
+
+}
@@ -130,6 +130,22 @@ TEST_F(loopback_data_writer_test, drop_commit) {
     EXPECT_EQ(commit[0], std::string { test_data[0] + test_data[1] });
 }
 
+TEST_F(loopback_data_writer_test, write_records) {
+    std::vector<std::string_view> test_data = { "hello", "this is a pen", "", "bye" };
+    tateyama::endpoint::loopback::loopback_data_writer writer { };
+
+    EXPECT_EQ(writer.write("prefix:", 7), tateyama::status::ok);
+    EXPECT_EQ(writer.write_records(test_data.data(), test_data.size()), tateyama::status::ok);
+    const auto &commit = writer.committed_data();
+    EXPECT_EQ(commit.size(), 3);
+    EXPECT_EQ(commit[0], "prefix:hello");
+    EXPECT_EQ(commit[1], test_data[1]);
+    EXPECT_EQ(commit[2], test_data[3]);
+
+    EXPECT_EQ(writer.write_records(test_data.data(), 0), tateyama::status::ok);
+    EXPECT_EQ(commit.size(), 3);
+}
+
 TEST_F(loopback_data_writer_test, binary) {
     const int len = 256;
     char data[len]; // NOLINT
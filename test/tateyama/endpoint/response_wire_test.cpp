@@ -15,6 +15,7 @@
  */
 #include <thread>
 #include <future>
+#include <vector>
 
 #include <tateyama/status.h>
 #include <tateyama/api/server/request.h>
@@ -164,4 +165,232 @@ TEST_F(response_wire_test, large_messege_does_not_receive_timeout) {
     TEST_TIMEOUT_SUCCESS_END(1000)
 }
 
+TEST_F(response_wire_test, serialize_in_wire) {
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+
+    for (std::size_t n = 0; n < 1000; n++) {
+        std::size_t length = 113 + (n * 37) % 1500;  // lengths vary so that some messages wrap around the ring buffer
+        response_test_message_.resize(length);
+        char *p = response_test_message_.data();
+        for (std::size_t i = 0; i < length; i++) {
+            *(p++) = (i * 7 + n)  % 255;
+        }
+        tateyama::common::wire::message_header::index_type index = n % 13;
+
+        response_wire.write(tateyama::common::wire::response_header(index, length, 1),
+                            [this](char* out){ std::memcpy(out, response_test_message_.data(), response_test_message_.length()); },
+                            false);
+
+        response_wire.await();
+        EXPECT_EQ(index, response_wire.get_idx());
+        EXPECT_EQ(length, response_wire.get_length());
+
+        std::string recv_message;
+        recv_message.resize(length);
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(memcmp(response_test_message_.data(), recv_message.data(), length), 0);
+    }
+}
+
+TEST_F(response_wire_test, serializer_throws) {
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+
+    EXPECT_THROW(response_wire.write(tateyama::common::wire::response_header(1, 100, 1),
+                                     [](char*){ throw std::runtime_error("serialize failure"); },
+                                     false), std::runtime_error);
+
+    std::string message(200, 'a');
+    response_wire.write(tateyama::common::wire::response_header(2, message.length(), 1),
+                        [&message](char* out){ std::memcpy(out, message.data(), message.length()); },
+                        false);
+
+    // the region left by the exception is published as a pad record, which is discarded by the client
+    response_wire.await();
+    EXPECT_EQ(2, response_wire.get_idx());
+    std::string recv_message;
+    recv_message.resize(response_wire.get_length());
+    response_wire.read(recv_message.data());
+    EXPECT_EQ(recv_message, message);
+}
+
+TEST_F(response_wire_test, wait_for_slow_writer) {
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+
+    std::promise<void> reserved{};
+    std::atomic_bool filled{};
+    std::thread slow([&response_wire, &reserved, &filled]{
+        response_wire.write(tateyama::common::wire::response_header(1, 100, 1),
+                            [&reserved, &filled](char* out){
+                                reserved.set_value();
+                                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                                std::memset(out, 'a', 100);
+                                filled.store(true);
+                            },
+                            false);
+    });
+    reserved.get_future().wait();
+    std::thread fast([&response_wire]{
+        response_wire.write(tateyama::common::wire::response_header(2, 100, 1),
+                            [](char* out){ std::memset(out, 'b', 100); },
+                            false);
+    });
+    fast.join();  // the writer behind parks its message without waiting for the slow writer
+    EXPECT_FALSE(filled.load());
+
+    for (std::size_t idx = 1; idx <= 2; idx++) {
+        response_wire.await();
+        EXPECT_EQ(idx, response_wire.get_idx());
+        std::string recv_message;
+        recv_message.resize(response_wire.get_length());
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(recv_message, std::string(100, static_cast<char>('a' + idx - 1)));
+    }
+    slow.join();
+}
+
+TEST_F(response_wire_test, parking_slots_exhausted) {
+    static constexpr std::size_t messages = 100;
+
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+
+    std::promise<void> reserved{};
+    std::thread slow([&response_wire, &reserved]{
+        response_wire.write(tateyama::common::wire::response_header(0, 16, 1),
+                            [&reserved](char* out){
+                                reserved.set_value();
+                                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                                std::memset(out, 'a', 16);
+                            },
+                            false);
+    });
+    reserved.get_future().wait();
+    std::thread fast([&response_wire]{
+        for (std::size_t n = 1; n <= messages; n++) {  // the writer waits for its turn once all the parking slots are taken
+            response_wire.write(tateyama::common::wire::response_header(n, 16, 1),
+                                [](char* out){ std::memset(out, 'b', 16); },
+                                false);
+        }
+    });
+
+    for (std::size_t idx = 0; idx <= messages; idx++) {
+        response_wire.await();
+        EXPECT_EQ(idx, response_wire.get_idx());
+        std::string recv_message;
+        recv_message.resize(response_wire.get_length());
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(recv_message, std::string(16, idx == 0 ? 'a' : 'b'));
+    }
+    slow.join();
+    fast.join();
+}
+
+TEST_F(response_wire_test, multiple_writers) {
+    static constexpr std::size_t writers = 8;
+    static constexpr std::size_t messages = 2000;
+
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+
+    std::vector<std::thread> threads{};
+    for (std::size_t w = 0; w < writers; w++) {
+        threads.emplace_back([&response_wire, w]{
+            for (std::size_t n = 0; n < messages; n++) {
+                std::string message(16 + (n * 31 + w) % 700, static_cast<char>('a' + w));
+                if (n % 2 == 0) {
+                    response_wire.write(message.data(), tateyama::common::wire::response_header(w, message.length(), 1), true);
+                } else {
+                    response_wire.write(tateyama::common::wire::response_header(w, message.length(), 1),
+                                        [&message](char* out){ std::memcpy(out, message.data(), message.length()); },
+                                        true);
+                }
+            }
+        });
+    }
+
+    std::vector<std::size_t> received(writers);
+    for (std::size_t i = 0; i < writers * messages; i++) {
+        response_wire.await();
+        auto w = response_wire.get_idx();
+        ASSERT_LT(w, writers);
+        auto n = received.at(w)++;
+        EXPECT_EQ(response_wire.get_length(), 16 + (n * 31 + w) % 700);
+
+        std::string recv_message;
+        recv_message.resize(response_wire.get_length());
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(recv_message, std::string(recv_message.length(), static_cast<char>('a' + w)));
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    for (auto&& r : received) {
+        EXPECT_EQ(r, messages);
+    }
+}
+
+TEST_F(response_wire_test, grow) {
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+    auto initial_capacity = response_wire.capacity();
+
+    auto send_and_receive = [&response_wire](std::size_t n, std::size_t length){
+        std::string message(length, static_cast<char>('a' + n));
+        std::thread th([&response_wire, &message, n]{
+            response_wire.write(message.data(), tateyama::common::wire::response_header(n, message.length(), 1), true);
+        });
+        response_wire.await();
+        EXPECT_EQ(n, response_wire.get_idx());
+        EXPECT_EQ(length, response_wire.get_length());
+
+        std::string recv_message;
+        recv_message.resize(response_wire.get_length());
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(recv_message, message);
+        th.join();
+    };
+
+    send_and_receive(0, 20000);
+    EXPECT_EQ(response_wire.capacity(), initial_capacity);  // does not grow on the first message larger than the buffer
+
+    for (std::size_t n = 1; n < 8; n++) {
+        send_and_receive(n, 20000 + n * 10000);
+    }
+    EXPECT_GT(response_wire.capacity(), initial_capacity);
+    EXPECT_LE(response_wire.capacity(), 64 * 1024);
+}
+
+TEST_F(response_wire_test, grow_while_writing) {
+    static constexpr std::size_t writers = 4;
+    static constexpr std::size_t messages = 50;
+
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+    auto initial_capacity = response_wire.capacity();
+
+    std::vector<std::thread> threads{};
+    for (std::size_t w = 0; w < writers; w++) {
+        threads.emplace_back([&response_wire, w]{
+            for (std::size_t n = 0; n < messages; n++) {
+                std::string message(100 + (n * 7919 + w * 1000) % 30000, static_cast<char>('a' + w));
+                response_wire.write(message.data(), tateyama::common::wire::response_header(w, message.length(), 1), true);
+            }
+        });
+    }
+
+    std::vector<std::size_t> received(writers);
+    for (std::size_t i = 0; i < writers * messages; i++) {
+        response_wire.await();
+        auto w = response_wire.get_idx();
+        ASSERT_LT(w, writers);
+        auto n = received.at(w)++;
+        EXPECT_EQ(response_wire.get_length(), 100 + (n * 7919 + w * 1000) % 30000);
+
+        std::string recv_message;
+        recv_message.resize(response_wire.get_length());
+        response_wire.read(recv_message.data());
+        EXPECT_EQ(recv_message, std::string(recv_message.length(), static_cast<char>('a' + w)));
+    }
+    for (auto&& t : threads) {
+        t.join();
+    }
+    EXPECT_GT(response_wire.capacity(), initial_capacity);
+}
+
 }  // namespace tateyama::api::endpoint::ipc
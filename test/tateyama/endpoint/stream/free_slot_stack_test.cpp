@@ -0,0 +1,84 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+#include <vector>
+#include <atomic>
+
+#include "tateyama/endpoint/stream/bootstrap/free_slot_stack.h"
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::stream::bootstrap {
+
+class free_slot_stack_test : public ::testing::Test {
+};
+
+TEST_F(free_slot_stack_test, pop_push) {
+    free_slot_stack slots{3};
+    EXPECT_EQ(slots.pop(), 0);
+    EXPECT_EQ(slots.pop(), 1);
+    EXPECT_EQ(slots.pop(), 2);
+    EXPECT_FALSE(slots.pop());
+
+    slots.push(1);
+    EXPECT_EQ(slots.pop(), 1);
+    EXPECT_FALSE(slots.pop());
+}
+
+TEST_F(free_slot_stack_test, empty) {
+    free_slot_stack slots{0};
+    EXPECT_FALSE(slots.pop());
+}
+
+TEST_F(free_slot_stack_test, concurrent) {
+    static constexpr std::size_t size = 16;
+    static constexpr std::size_t threads = 8;
+    static constexpr std::size_t loops = 100000;
+    free_slot_stack slots{size};
+    std::vector<std::atomic_bool> in_use(size);
+    std::atomic_size_t conflicts{};
+
+    std::vector<std::thread> workers{};
+    for (std::size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&]{
+            for (std::size_t i = 0; i < loops; i++) {
+                if (auto slot = slots.pop(); slot) {
+                    if (in_use.at(slot.value()).exchange(true)) {
+                        conflicts++;
+                    }
+                    in_use.at(slot.value()).store(false);
+                    slots.push(slot.value());
+                }
+            }
+        });
+    }
+    for (auto&& w : workers) {
+        w.join();
+    }
+    EXPECT_EQ(conflicts.load(), 0);
+
+    // all the slots are back
+    std::vector<bool> popped(size);
+    for (std::size_t i = 0; i < size; i++) {
+        auto slot = slots.pop();
+        ASSERT_TRUE(slot);
+        EXPECT_FALSE(popped.at(slot.value()));
+        popped.at(slot.value()) = true;
+    }
+    EXPECT_FALSE(slots.pop());
+}
+
+}  // namespace tateyama::endpoint::stream::bootstrap
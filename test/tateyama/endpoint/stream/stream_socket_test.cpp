@@ -0,0 +1,734 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <thread>
+#include <future>
+
+#ifdef ENABLE_STREAM_COMPRESSION
+#include <lz4.h>
+#include <zstd.h>
+#endif
+
+#include "tateyama/endpoint/stream/stream.h"
+
+#include <gtest/gtest.h>
+
+namespace tateyama::endpoint::stream {
+
+static constexpr std::uint32_t port_for_test = 12350;
+static constexpr unsigned char request_session_payload = 2;
+static constexpr unsigned char request_result_set_bye_ok = 3;
+static constexpr unsigned char request_session_bye = 4;
+static constexpr unsigned char request_alive_check = 5;
+static constexpr unsigned char request_result_set_credit = 6;
+static constexpr unsigned char response_session_payload = 1;
+static constexpr unsigned char response_result_set_payload = 2;
+static constexpr unsigned char response_result_set_bye = 6;
+static constexpr unsigned char response_result_set_compressed_payload = 9;
+
+class stream_socket_test : public ::testing::Test {
+    void SetUp() override {
+        connection_socket_ = std::make_unique<connection_socket>(port_for_test);
+        auto accepted = std::async(std::launch::async, [this]{ return connection_socket_->accept(); });
+
+        client_ = connect_client(port_for_test);
+        ASSERT_GE(client_, 0);
+        stream_ = accepted.get();
+        ASSERT_NE(stream_, nullptr);
+    }
+    void TearDown() override {
+        if (client_ >= 0) {
+            ::close(client_);
+        }
+        stream_ = nullptr;
+        connection_socket_->close();
+    }
+
+protected:
+    std::unique_ptr<connection_socket> connection_socket_{};
+    std::unique_ptr<stream_socket> stream_{};
+    int client_{-1};
+
+    // connects a client to the port of the loopback address, returns -1 on failure
+    static int connect_client(std::uint32_t port) {
+        int client = ::socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(client, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0) {  // NOLINT
+            ::close(client);
+            return -1;
+        }
+        return client;
+    }
+    // reconnects the client to get a session reflecting the settings of connection_socket_ changed by the test
+    void reconnect() {
+        ::close(client_);
+        client_ = connect_client(port_for_test);
+        ASSERT_GE(client_, 0);
+        stream_ = connection_socket_->accept();
+        ASSERT_NE(stream_, nullptr);
+    }
+    static std::string frame(unsigned char info, std::uint16_t slot, std::string_view payload) {
+        std::string f{};
+        f.push_back(static_cast<char>(info));
+        f.push_back(static_cast<char>(slot & 0xffU));
+        f.push_back(static_cast<char>((slot >> 8U) & 0xffU));
+        if (info != request_alive_check) {
+            auto length = static_cast<std::uint32_t>(payload.length());
+            for (std::size_t i = 0; i < sizeof(length); i++) {
+                f.push_back(static_cast<char>((length >> (8U * i)) & 0xffU));
+            }
+            f.append(payload);
+        }
+        return f;
+    }
+    void write(std::string_view bytes) const {
+        ASSERT_EQ(::send(client_, bytes.data(), bytes.length(), 0), static_cast<ssize_t>(bytes.length()));
+    }
+    std::string read(std::size_t length) const {
+        std::string bytes(length, '\0');
+        std::size_t received = 0;
+        while (received < length) {
+            auto s = ::recv(client_, bytes.data() + received, length - received, 0);  // NOLINT
+            if (s <= 0) {
+                break;
+            }
+            received += s;
+        }
+        bytes.resize(received);
+        return bytes;
+    }
+    std::uint32_t read_uint(std::size_t length) const {
+        auto bytes = read(length);
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < bytes.length(); i++) {
+            value |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes.at(i))) << (8U * i);
+        }
+        return value;
+    }
+    // reads a RESPONSE_RESULT_SET_PAYLOAD frame and returns its payload
+    std::string read_record(std::uint16_t slot, unsigned char writer) const {
+        EXPECT_EQ(read_uint(1), response_result_set_payload);
+        EXPECT_EQ(read_uint(sizeof(std::uint16_t)), slot);
+        EXPECT_EQ(read_uint(1), writer);
+        return read(read_uint(sizeof(std::uint32_t)));
+    }
+    stream_socket::await_result try_await(std::uint16_t& slot, std::string& payload) {
+        for (std::size_t i = 0; i < 1000; i++) {
+            if (auto rv = stream_->try_await(slot, payload); rv != stream_socket::await_result::would_block) {
+                return rv;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return stream_socket::await_result::would_block;
+    }
+};
+
+TEST_F(stream_socket_test, pipelined) {
+    static constexpr std::size_t requests = 200;
+    std::string bytes{};
+    for (std::size_t i = 0; i < requests; i++) {
+        bytes += frame(request_session_payload, static_cast<std::uint16_t>(i), "request_" + std::to_string(i));
+        bytes += frame(request_alive_check, 0, "");
+    }
+    write(bytes);
+
+    for (std::size_t i = 0; i < requests; i++) {
+        std::uint16_t slot{};
+        std::string payload{};
+        ASSERT_EQ(try_await(slot, payload), stream_socket::await_result::payload);
+        EXPECT_EQ(slot, i);
+        EXPECT_EQ(payload, "request_" + std::to_string(i));
+    }
+    std::uint16_t slot{};
+    std::string payload{};
+    EXPECT_EQ(stream_->try_await(slot, payload), stream_socket::await_result::would_block);
+}
+
+TEST_F(stream_socket_test, partial_frame) {
+    auto bytes = frame(request_session_payload, 3, std::string(100 * 1024, 'a'));
+    write(std::string_view(bytes).substr(0, 5));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::uint16_t slot{};
+    std::string payload{};
+    EXPECT_EQ(stream_->try_await(slot, payload), stream_socket::await_result::would_block);
+
+    write(std::string_view(bytes).substr(5));
+    ASSERT_EQ(try_await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(slot, 3);
+    EXPECT_EQ(payload, std::string(100 * 1024, 'a'));
+}
+
+TEST_F(stream_socket_test, mixed_with_await) {
+    write(frame(request_session_payload, 1, "first") + frame(request_session_payload, 2, ""));
+
+    std::uint16_t slot{};
+    std::string payload{};
+    ASSERT_EQ(stream_->await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(payload, "first");
+    ASSERT_EQ(try_await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(slot, 2);
+    EXPECT_TRUE(payload.empty());
+}
+
+TEST_F(stream_socket_test, await_pipelined) {
+    static constexpr std::size_t requests = 100;
+    std::string bytes{};
+    for (std::size_t i = 0; i < requests; i++) {
+        bytes += frame(request_session_payload, static_cast<std::uint16_t>(i), "request_" + std::to_string(i));
+    }
+    write(bytes);
+
+    std::string payload{};
+    for (std::size_t i = 0; i < requests; i++) {
+        std::uint16_t slot{};
+        ASSERT_EQ(stream_->await(slot, payload), stream_socket::await_result::payload);
+        EXPECT_EQ(slot, i);
+        EXPECT_EQ(payload, "request_" + std::to_string(i));
+    }
+}
+
+TEST_F(stream_socket_test, await_large_request) {
+    std::string large(3 * 1024 * 1024, 'b');  // larger than the inbound buffer retained
+    auto writer = std::async(std::launch::async, [this, &large]{
+        write(frame(request_session_payload, 1, "small") + frame(request_session_payload, 2, large) + frame(request_session_payload, 3, "next"));
+    });
+
+    std::uint16_t slot{};
+    std::string payload{};
+    ASSERT_EQ(stream_->await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(payload, "small");
+    ASSERT_EQ(stream_->await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(slot, 2);
+    EXPECT_EQ(payload, large);
+    ASSERT_EQ(stream_->await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(slot, 3);
+    EXPECT_EQ(payload, "next");
+    writer.get();
+}
+
+TEST_F(stream_socket_test, termination_request) {
+    write(frame(request_session_bye, 0, ""));
+
+    std::uint16_t slot{};
+    std::string payload{};
+    EXPECT_EQ(try_await(slot, payload), stream_socket::await_result::termination_request);
+}
+
+TEST_F(stream_socket_test, socket_closed) {
+    write(frame(request_session_payload, 1, "last"));
+    ::close(client_);
+    client_ = -1;
+
+    std::uint16_t slot{};
+    std::string payload{};
+    ASSERT_EQ(try_await(slot, payload), stream_socket::await_result::payload);
+    EXPECT_EQ(payload, "last");
+    EXPECT_EQ(try_await(slot, payload), stream_socket::await_result::socket_closed);
+}
+
+TEST_F(stream_socket_test, send_response) {
+    stream_->send(7, "response", true);
+
+    EXPECT_EQ(read_uint(1), response_session_payload);
+    EXPECT_EQ(read_uint(sizeof(std::uint16_t)), 7);
+    EXPECT_EQ(read(read_uint(sizeof(std::uint32_t))), "response");
+}
+
+TEST_F(stream_socket_test, send_records) {
+    static constexpr std::size_t records = 300;  // more than the records sent by a sendmsg()
+    stream_->send_result_set_hello(3, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+    std::vector<std::string> bodies{};
+    for (std::size_t i = 0; i < records; i++) {
+        bodies.emplace_back(i % 10 == 0 ? "" : "record_" + std::to_string(i));
+    }
+    std::vector<std::string_view> payloads(bodies.begin(), bodies.end());
+    stream_->send(3, 1, payloads.data(), payloads.size());
+
+    for (std::size_t i = 0; i < records; i++) {
+        if (!bodies.at(i).empty()) {
+            EXPECT_EQ(read_record(3, 1), bodies.at(i));
+        }
+        EXPECT_TRUE(read_record(3, 1).empty());  // delimiter
+    }
+}
+
+TEST_F(stream_socket_test, send_large_record) {
+    std::string body(8 * 1024 * 1024, 'x');  // larger than the socket buffer, sent by multiple writes
+    stream_->send_result_set_hello(0, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+    auto sender = std::async(std::launch::async, [this, &body]{ stream_->send(0, 2, body); });
+    EXPECT_EQ(read_record(0, 2), body);
+    EXPECT_TRUE(read_record(0, 2).empty());
+    sender.get();
+}
+
+TEST_F(stream_socket_test, accept_connections) {
+    static constexpr std::size_t connections = 4;
+    std::vector<int> clients{};
+    for (std::size_t i = 0; i < connections; i++) {
+        clients.emplace_back(connect_client(port_for_test));
+        ASSERT_GE(clients.back(), 0);
+    }
+    for (std::size_t i = 0; i < connections; i++) {
+        auto stream = connection_socket_->accept();
+        ASSERT_NE(stream, nullptr);
+        EXPECT_EQ(stream->connection_info().rfind("127.0.0.1:", 0), 0);
+    }
+    for (auto c : clients) {
+        ::close(c);
+    }
+}
+
+TEST_F(stream_socket_test, terminate_accept) {
+    auto accepted = std::async(std::launch::async, [this]{ return connection_socket_->accept(); });
+    connection_socket_->request_terminate();
+    EXPECT_EQ(accepted.get(), nullptr);
+}
+
+TEST_F(stream_socket_test, send_zerocopy) {
+    // reconnect to get a session sending with MSG_ZEROCOPY
+    connection_socket_->enable_zerocopy();
+    ASSERT_NO_FATAL_FAILURE(reconnect());
+    stream_->send_result_set_hello(1, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+    static constexpr std::size_t records = 3000;  // queued as an entry larger than the threshold
+    std::vector<std::string> bodies{};
+    for (std::size_t i = 0; i < records; i++) {
+        bodies.emplace_back(1000, static_cast<char>('a' + (i % 26)));
+    }
+    std::vector<std::string_view> payloads(bodies.begin(), bodies.end());
+    auto sender = std::async(std::launch::async, [this, &payloads]{ stream_->send(1, 0, payloads.data(), payloads.size()); });
+    for (std::size_t i = 0; i < records; i++) {
+        ASSERT_EQ(read_record(1, 0), bodies.at(i));
+        ASSERT_TRUE(read_record(1, 0).empty());
+    }
+    sender.get();
+
+    auto stats = connection_socket_->zerocopy_statistics();
+    ASSERT_NE(stats, nullptr);
+    EXPECT_GT(stats->bytes() + stats->fallbacks(), 0);
+}
+
+TEST_F(stream_socket_test, send_queue_writers) {
+    // reconnect to get a session with a small send queue, so that the writers wait for the queue to be drained
+    connection_socket_->set_send_queue_limit(64 * 1024);
+    ASSERT_NO_FATAL_FAILURE(reconnect());
+
+    static constexpr std::uint16_t slots = 4;
+    static constexpr std::size_t batches = 200;
+    static constexpr std::size_t records_per_batch = 10;
+    for (std::uint16_t slot = 0; slot < slots; slot++) {
+        stream_->send_result_set_hello(slot, "rs");
+        static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+    }
+    std::vector<std::future<void>> writers{};
+    for (std::uint16_t slot = 0; slot < slots; slot++) {
+        writers.emplace_back(std::async(std::launch::async, [this, slot]{
+            for (std::size_t b = 0; b < batches; b++) {
+                std::vector<std::string> bodies{};
+                for (std::size_t r = 0; r < records_per_batch; r++) {
+                    bodies.emplace_back(std::to_string(b * records_per_batch + r) + std::string(1000, 'x'));
+                }
+                std::vector<std::string_view> payloads(bodies.begin(), bodies.end());
+                stream_->send(slot, 0, payloads.data(), payloads.size());
+            }
+        }));
+    }
+
+    // the records of a slot arrive in the order written, each followed by a delimiter
+    std::vector<std::size_t> received(slots);
+    std::vector<bool> delimiter_expected(slots);
+    for (std::size_t n = 0; n < slots * batches * records_per_batch * 2; n++) {
+        ASSERT_EQ(read_uint(1), response_result_set_payload);
+        auto slot = read_uint(sizeof(std::uint16_t));
+        ASSERT_LT(slot, slots);
+        EXPECT_EQ(read_uint(1), 0);
+        auto payload = read(read_uint(sizeof(std::uint32_t)));
+        if (delimiter_expected.at(slot)) {
+            ASSERT_TRUE(payload.empty());
+            delimiter_expected.at(slot) = false;
+            continue;
+        }
+        ASSERT_EQ(payload, std::to_string(received.at(slot)) + std::string(1000, 'x'));
+        received.at(slot)++;
+        delimiter_expected.at(slot) = true;
+    }
+    for (auto&& w : writers) {
+        w.get();
+    }
+    for (std::uint16_t slot = 0; slot < slots; slot++) {
+        EXPECT_EQ(received.at(slot), batches * records_per_batch);
+    }
+    EXPECT_EQ(connection_socket_->send_queue_statistics()->queued_bytes(), 0);
+}
+
+TEST_F(stream_socket_test, send_response_after_records) {
+    stream_->send_result_set_hello(2, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+    std::string body(1024 * 1024, 'y');
+    auto sender = std::async(std::launch::async, [this, &body]{
+        stream_->send(2, 0, body);
+        stream_->send_result_set_bye(2);
+    });
+    EXPECT_EQ(read_record(2, 0), body);
+    EXPECT_TRUE(read_record(2, 0).empty());
+    EXPECT_EQ(read_uint(1), response_result_set_bye);  // follows the records queued
+    EXPECT_EQ(read_uint(sizeof(std::uint16_t)), 2);
+    sender.get();
+}
+
+TEST_F(stream_socket_test, response_not_behind_records) {
+    stream_->send_result_set_hello(0, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+    // more records than the socket buffers hold, the writer is blocked as the client does not read them yet
+    static constexpr std::size_t batches = 100;
+    static constexpr std::size_t records_per_batch = 10;
+    std::string body(10000, 'r');
+    auto writer = std::async(std::launch::async, [this, &body]{
+        std::vector<std::string_view> payloads(records_per_batch, body);
+        for (std::size_t b = 0; b < batches; b++) {
+            stream_->send(0, 0, payloads.data(), payloads.size());
+        }
+        stream_->send_result_set_bye(0);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto responder = std::async(std::launch::async, [this]{ stream_->send(9, "response", true); });
+
+    // the response is sent between the frames in flight, not after all the records queued
+    std::size_t received = 0;
+    std::size_t received_before_response = 0;
+    bool responded = false;
+    while (true) {
+        auto info = read_uint(1);
+        auto slot = read_uint(sizeof(std::uint16_t));
+        if (info == response_session_payload) {
+            EXPECT_EQ(slot, 9);
+            EXPECT_EQ(read(read_uint(sizeof(std::uint32_t))), "response");
+            received_before_response = received;
+            responded = true;
+            continue;
+        }
+        if (info == response_result_set_bye) {
+            EXPECT_EQ(slot, 0);
+            EXPECT_EQ(read_uint(sizeof(std::uint32_t)), 0);
+            break;
+        }
+        ASSERT_EQ(info, response_result_set_payload);
+        EXPECT_EQ(read_uint(1), 0);
+        auto payload = read(read_uint(sizeof(std::uint32_t)));
+        if (!payload.empty()) {
+            ASSERT_EQ(payload, body);
+            received++;
+        }
+    }
+    writer.get();
+    responder.get();
+    EXPECT_TRUE(responded);
+    EXPECT_EQ(received, batches * records_per_batch);
+    EXPECT_LT(received_before_response, received);
+}
+
+TEST_F(stream_socket_test, socket_options) {
+    socket_options options{};
+    options.tcp_keepalive_ = true;
+    options.tcp_keepalive_idle_ = 30;
+    options.send_buffer_size_ = 256 * 1024;
+    options.ipv6_ = true;
+    auto dual_stack = std::make_unique<connection_socket>(port_for_test + 1, 1000, options);
+
+    // an IPv4 client connects to the dual-stack socket
+    int client = connect_client(port_for_test + 1);
+    ASSERT_GE(client, 0);
+    auto stream = dual_stack->accept();
+    ASSERT_NE(stream, nullptr);
+    EXPECT_EQ(stream->connection_info().rfind("127.0.0.1:", 0), 0);
+
+    int value{};
+    socklen_t len = sizeof(value);
+    ASSERT_EQ(getsockopt(stream->native_handle(), SOL_TCP, TCP_NODELAY, &value, &len), 0);
+    EXPECT_NE(value, 0);
+    ASSERT_EQ(getsockopt(stream->native_handle(), SOL_SOCKET, SO_KEEPALIVE, &value, &len), 0);
+    EXPECT_NE(value, 0);
+    ASSERT_EQ(getsockopt(stream->native_handle(), SOL_TCP, TCP_KEEPIDLE, &value, &len), 0);
+    EXPECT_EQ(value, 30);
+    ASSERT_EQ(getsockopt(stream->native_handle(), SOL_SOCKET, SO_SNDBUF, &value, &len), 0);
+    EXPECT_GE(value, 256 * 1024);  // the kernel doubles the value given
+
+    ::close(client);
+    stream = nullptr;
+    dual_stack->close();
+}
+
+TEST_F(stream_socket_test, reuseport) {
+    // two sockets listen the same port
+    stream_ = nullptr;
+    connection_socket_->close();
+    socket_options options{};
+    options.reuseport_ = true;
+    connection_socket_ = std::make_unique<connection_socket>(port_for_test + 2, 1000, options);
+    auto second = std::make_unique<connection_socket>(port_for_test + 2, 1000, options);
+    second->share_settings(*connection_socket_);
+    EXPECT_EQ(second->send_queue_statistics(), connection_socket_->send_queue_statistics());
+
+    static constexpr std::size_t connections = 8;
+    std::atomic_size_t accepted{};
+    auto acceptor = [&accepted](connection_socket& socket){
+        while (socket.accept() != nullptr) {
+            accepted++;
+        }
+    };
+    std::thread first_thread(acceptor, std::ref(*connection_socket_));
+    std::thread second_thread(acceptor, std::ref(*second));
+    std::vector<int> clients{};
+    for (std::size_t i = 0; i < connections; i++) {
+        clients.emplace_back(connect_client(port_for_test + 2));
+        ASSERT_GE(clients.back(), 0);
+    }
+    for (std::size_t i = 0; i < 100 && accepted.load() < connections; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    connection_socket_->request_terminate();
+    second->request_terminate();
+    first_thread.join();
+    second_thread.join();
+    EXPECT_EQ(accepted.load(), connections);
+    for (auto c : clients) {
+        ::close(c);
+    }
+    second->close();
+}
+
+TEST_F(stream_socket_test, flow_control) {
+    static constexpr std::uint32_t window = 16 * 1024;
+    stream_->enable_flow_control(window);
+    for (std::uint16_t slot = 0; slot < 2; slot++) {
+        stream_->send_result_set_hello(slot, "rs");
+        static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+    }
+
+    static constexpr std::size_t records = 100;
+    auto body = [](std::size_t i){ return std::to_string(i) + std::string(1000, 'x'); };
+    auto writer = std::async(std::launch::async, [this, &body]{
+        for (std::size_t i = 0; i < records; i++) {
+            stream_->send(0, 0, body(i));
+        }
+    });
+    // the writer does not wait for the credit, the records beyond it are held by the session
+    ASSERT_EQ(writer.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    writer.get();
+
+    // neither the response nor the other result set waits for the credit of slot 0
+    stream_->send(1, 0, std::string_view("other"));
+    stream_->send(7, "response", true);
+    std::size_t received = 0;
+    std::size_t consumed = 0;
+    while (true) {
+        auto info = read_uint(1);
+        auto slot = read_uint(sizeof(std::uint16_t));
+        if (info == response_session_payload) {
+            EXPECT_EQ(slot, 7);
+            EXPECT_EQ(read(read_uint(sizeof(std::uint32_t))), "response");
+            break;
+        }
+        ASSERT_EQ(info, response_result_set_payload);
+        EXPECT_EQ(read_uint(1), 0);
+        auto payload = read(read_uint(sizeof(std::uint32_t)));
+        if (slot == 1) {
+            EXPECT_TRUE(payload == "other" || payload.empty());
+            continue;
+        }
+        ASSERT_EQ(slot, 0);
+        consumed += 1 + sizeof(std::uint16_t) + 1 + sizeof(std::uint32_t) + payload.length();
+        if (!payload.empty()) {
+            EXPECT_EQ(payload, body(received));
+            received++;
+        }
+    }
+    EXPECT_LT(received, records);
+    EXPECT_LE(consumed, window + 2 * 1024);  // an entry beyond the credit left at most
+
+    // the client grants the credit as it consumes the records, which is received by the session
+    auto receiver = std::async(std::launch::async, [this]{
+        std::uint16_t slot{};
+        std::string payload{};
+        stream_socket::await_result rv{};
+        while ((rv = stream_->await(slot, payload)) == stream_socket::await_result::timeout);
+        return rv;
+    });
+    auto grant = [this](std::size_t bytes, std::uint32_t generation = 1){  // for the result set of the first RESPONSE_RESULT_SET_HELLO
+        std::string credit(2 * sizeof(std::uint32_t), '\0');
+        for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+            credit.at(i) = static_cast<char>((bytes >> (8U * i)) & 0xffU);
+            credit.at(sizeof(std::uint32_t) + i) = static_cast<char>((generation >> (8U * i)) & 0xffU);
+        }
+        write(frame(request_result_set_credit, 0, credit));
+    };
+    grant(records * 2 * 1024, 0);  // late credit for a previous result set of the slot
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    char c{};
+    EXPECT_LT(::recv(client_, &c, 1, MSG_DONTWAIT), 0);  // still held
+    grant(consumed);
+    while (received < records) {
+        auto payload = read_record(0, 0);
+        EXPECT_EQ(payload, body(received));
+        received++;
+        EXPECT_TRUE(read_record(0, 0).empty());
+        grant(2 * (1 + sizeof(std::uint16_t) + 1 + sizeof(std::uint32_t)) + payload.length());
+    }
+    write(frame(request_session_bye, 0, ""));
+    EXPECT_EQ(receiver.get(), stream_socket::await_result::termination_request);  // the credit frames are consumed by the session
+}
+
+TEST_F(stream_socket_test, held_records_discarded_on_close) {
+    stream_->enable_flow_control(16 * 1024);
+    stream_->send_result_set_hello(0, "rs");
+    static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+    auto receiver = std::async(std::launch::async, [this]{
+        std::uint16_t slot{};
+        std::string payload{};
+        stream_socket::await_result rv{};
+        while ((rv = stream_->await(slot, payload)) == stream_socket::await_result::timeout);
+        return rv;
+    });
+
+    std::string body(1000, 'h');
+    for (std::size_t i = 0; i < 100; i++) {
+        stream_->send(0, 0, body);
+    }
+    EXPECT_GT(connection_socket_->send_queue_statistics()->queued_bytes(), 0);  // held for the credit
+
+    // the client closes the result set, then the records held are discarded and the next record ends the result set
+    write(frame(request_result_set_bye_ok, 0, ""));
+    for (std::size_t i = 0; i < 1000 && connection_socket_->send_queue_statistics()->queued_bytes() > 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(connection_socket_->send_queue_statistics()->queued_bytes(), 0);
+    stream_->send(0, 0, body);
+    while (true) {
+        auto info = read_uint(1);
+        ASSERT_EQ(read_uint(sizeof(std::uint16_t)), 0);
+        if (info == response_result_set_bye) {
+            EXPECT_EQ(read_uint(sizeof(std::uint32_t)), 0);
+            break;
+        }
+        ASSERT_EQ(info, response_result_set_payload);
+        EXPECT_EQ(read_uint(1), 0);
+        static_cast<void>(read(read_uint(sizeof(std::uint32_t))));
+    }
+    write(frame(request_session_bye, 0, ""));
+    EXPECT_EQ(receiver.get(), stream_socket::await_result::termination_request);
+}
+
+#ifdef ENABLE_STREAM_COMPRESSION
+TEST_F(stream_socket_test, send_compressed) {
+    connection_socket_->enable_compression(0);
+    for (auto type : {compression_type::lz4, compression_type::zstd}) {
+        // reconnect to get a session compressing the result sets
+        ASSERT_NO_FATAL_FAILURE(reconnect());
+        stream_->enable_compression(type);
+        EXPECT_EQ(stream_->compression(), type);
+        stream_->send_result_set_hello(4, "rs");
+        static_cast<void>(read(1 + sizeof(std::uint16_t) + sizeof(std::uint32_t) + 2));
+
+        static constexpr std::size_t records = 2000;
+        std::vector<std::string> bodies{};
+        for (std::size_t i = 0; i < records; i++) {
+            bodies.emplace_back("record_" + std::to_string(i) + std::string(200, 'z'));
+        }
+        std::vector<std::string_view> payloads(bodies.begin(), bodies.end());
+        auto sender = std::async(std::launch::async, [this, &payloads]{ stream_->send(4, 1, payloads.data(), payloads.size()); });
+
+        // the frames decompressed are the same as the ones sent uncompressed
+        std::string frames{};
+        std::size_t compressed = 0;
+        std::size_t expected = 0;
+        for (std::size_t i = 0; i < records; i++) {
+            expected += 2 * (1 + sizeof(std::uint16_t) + 1 + sizeof(std::uint32_t)) + bodies.at(i).length();
+        }
+        while (frames.length() < expected) {
+            auto info = read_uint(1);
+            ASSERT_EQ(read_uint(sizeof(std::uint16_t)), 4);
+            if (info == response_result_set_payload) {
+                frames.push_back(static_cast<char>(info));
+                frames.append("\x04\x00", 2);
+                frames.append(read(1 + sizeof(std::uint32_t)));
+                auto length = frames.length() - sizeof(std::uint32_t);
+                std::uint32_t size = 0;
+                for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+                    size |= static_cast<std::uint32_t>(static_cast<unsigned char>(frames.at(length + i))) << (8U * i);
+                }
+                frames.append(read(size));
+                continue;
+            }
+            ASSERT_EQ(info, response_result_set_compressed_payload);
+            EXPECT_EQ(read_uint(1), 0);
+            auto block = read(read_uint(sizeof(std::uint32_t)));
+            ASSERT_GT(block.length(), sizeof(std::uint32_t));
+            std::uint32_t size = 0;
+            for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+                size |= static_cast<std::uint32_t>(static_cast<unsigned char>(block.at(i))) << (8U * i);
+            }
+            std::string decompressed(size, '\0');
+            auto* src = block.data() + sizeof(std::uint32_t);  // NOLINT
+            auto src_size = block.length() - sizeof(std::uint32_t);
+            if (type == compression_type::lz4) {
+                ASSERT_EQ(LZ4_decompress_safe(src, decompressed.data(), static_cast<int>(src_size), static_cast<int>(size)), static_cast<int>(size));
+            } else {
+                ASSERT_EQ(ZSTD_decompress(decompressed.data(), size, src, src_size), size);
+            }
+            frames.append(decompressed);
+            compressed++;
+        }
+        sender.get();
+        EXPECT_GT(compressed, 0);
+
+        std::size_t offset = 0;
+        auto take_record = [&frames, &offset]() {
+            EXPECT_EQ(static_cast<unsigned char>(frames.at(offset)), response_result_set_payload);
+            EXPECT_EQ(frames.at(offset + 1), 4);
+            EXPECT_EQ(frames.at(offset + 3), 1);
+            offset += 1 + sizeof(std::uint16_t) + 1;
+            std::uint32_t size = 0;
+            for (std::size_t i = 0; i < sizeof(std::uint32_t); i++) {
+                size |= static_cast<std::uint32_t>(static_cast<unsigned char>(frames.at(offset + i))) << (8U * i);
+            }
+            offset += sizeof(std::uint32_t);
+            auto record = frames.substr(offset, size);
+            offset += size;
+            return record;
+        };
+        for (std::size_t i = 0; i < records; i++) {
+            ASSERT_EQ(take_record(), bodies.at(i));
+            ASSERT_TRUE(take_record().empty());
+        }
+        EXPECT_EQ(offset, frames.length());
+    }
+    auto stats = connection_socket_->compression_statistics();
+    ASSERT_NE(stats, nullptr);
+    EXPECT_LT(stats->ratio(), 1.0);
+}
+#endif
+
+}
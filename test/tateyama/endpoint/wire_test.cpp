@@ -20,6 +20,7 @@
 #include <tateyama/api/server/response.h>
 
 #include <tateyama/endpoint/ipc/bootstrap/server_wires_impl.h>
+#include <tsubakuro/common/wire/udf_wires.h>
 
 #include <gtest/gtest.h>
 
@@ -130,4 +131,61 @@ TEST_F(wire_test, large_messege) {
     th.join();
 }
 
+TEST_F(wire_test, concurrent_loop) {
+    static constexpr std::size_t messages = 100000;
+
+    auto* request_wire = static_cast<bootstrap::server_wire_container_impl::wire_container_impl*>(wire_->get_request_wire());
+
+    std::thread th([request_wire]{
+        for (std::size_t n = 0; n < messages; n++) {
+            auto message = std::to_string(n);
+            request_wire->write(message.data(), message.length(), n % 11);
+        }
+    });
+    for (std::size_t n = 0; n < messages; n++) {
+        auto h = request_wire->peep();
+        EXPECT_EQ(n % 11, h.get_idx());
+        std::string recv_message(request_wire->payload());
+        EXPECT_EQ(std::to_string(n), recv_message);
+        request_wire->dispose();
+    }
+    th.join();
+}
+
+TEST_F(wire_test, layout_version) {
+    boost::interprocess::managed_shared_memory managed_shm(boost::interprocess::open_only, "tateyama-wire_test");
+    EXPECT_EQ(tateyama::common::wire::wire_layout(managed_shm), tateyama::common::wire::wire_layout_version);
+}
+
+TEST_F(wire_test, client_checks_layout_version) {
+    EXPECT_NO_THROW(tsubakuro::common::wire::session_wire_container("tateyama-wire_test"));
+
+    boost::interprocess::managed_shared_memory managed_shm(boost::interprocess::open_only, "tateyama-wire_test");
+    *managed_shm.find<std::uint32_t>(tateyama::common::wire::wire_layout_name).first = tateyama::common::wire::wire_layout_version + 1;
+    EXPECT_THROW(tsubakuro::common::wire::session_wire_container("tateyama-wire_test"), std::runtime_error);
+}
+
+TEST_F(wire_test, client_reads_grown_response_wire) {
+    tsubakuro::common::wire::session_wire_container client{"tateyama-wire_test"};
+    auto& client_response_wire = client.get_response_wire();
+    auto& response_wire = dynamic_cast<bootstrap::server_wire_container_impl::response_wire_container_impl&>(wire_->get_response_wire());
+    auto initial_capacity = response_wire.capacity();
+
+    for (std::size_t n = 0; n < 8; n++) {
+        std::string message(20000 + n * 10000, static_cast<char>('a' + n));
+        std::thread th([&response_wire, &message, n]{
+            response_wire.write(message.data(), tateyama::common::wire::response_header(n, message.length(), 1), true);
+        });
+        client_response_wire.await(0);
+        EXPECT_EQ(n, client_response_wire.get_idx());
+
+        std::string recv_message;
+        recv_message.resize(client_response_wire.get_length());
+        client_response_wire.read(reinterpret_cast<signed char*>(recv_message.data()));
+        EXPECT_EQ(recv_message, message);
+        th.join();
+    }
+    EXPECT_GT(response_wire.capacity(), initial_capacity);
+}
+
 }  // namespace tateyama::api::endpoint::ipc
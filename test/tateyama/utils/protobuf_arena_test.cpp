@@ -0,0 +1,77 @@
+/*
+ * Copyright 2018-2025 Project Tsurugi.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <tateyama/utils/protobuf_arena.h>
+
+#include <thread>
+
+#include <tateyama/proto/framework/response.pb.h>
+
+#include <gtest/gtest.h>
+
+namespace tateyama::utils {
+
+using header = ::tateyama::proto::framework::response::Header;
+
+class protobuf_arena_test : public ::testing::Test {};
+
+TEST_F(protobuf_arena_test, no_scope) {
+    EXPECT_THROW(static_cast<void>(request_arena::create<header>()), std::logic_error);
+}
+
+TEST_F(protobuf_arena_test, reset_by_outermost_scope) {
+    request_arena::scope outer{};
+    auto* hdr = request_arena::create<header>();
+    hdr->set_session_id(1);
+    auto used = request_arena::space_used();
+    EXPECT_GT(used, 0);
+    {
+        request_arena::scope inner{};
+        auto& blobs = *request_arena::create<header>()->mutable_blobs();
+        for (std::size_t i = 0; i < 1000; i++) {
+            blobs.add_blobs()->set_channel_name("channel_" + std::to_string(i));
+        }
+    }
+    // the inner scope does not reset the arena
+    EXPECT_EQ(hdr->session_id(), 1);
+    EXPECT_GT(request_arena::space_used(), used);
+}
+
+TEST_F(protobuf_arena_test, reused_over_requests) {
+    {
+        request_arena::scope scope{};
+        request_arena::create<header>()->set_session_id(1);
+        EXPECT_GT(request_arena::space_used(), 0);
+    }
+    EXPECT_EQ(request_arena::space_used(), 0);
+    {
+        request_arena::scope scope{};
+        auto* hdr = request_arena::create<header>();
+        EXPECT_EQ(hdr->session_id(), 0);
+    }
+}
+
+TEST_F(protobuf_arena_test, per_thread) {
+    request_arena::scope scope{};
+    auto* arena = request_arena::arena();
+    std::thread th([arena]{
+        EXPECT_THROW(static_cast<void>(request_arena::arena()), std::logic_error);
+        request_arena::scope scope{};
+        EXPECT_NE(request_arena::arena(), arena);
+    });
+    th.join();
+}
+
+}
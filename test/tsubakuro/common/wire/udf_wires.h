@@ -105,14 +105,28 @@ public:
         void write(const signed char* from, std::size_t length, message_header::index_type index) {
             const char *ptr = reinterpret_cast<const char*>(from);
             wire_->write(bip_buffer_, ptr, message_header(index, length));
+            ring();
         }
         void disconnect() {
             wire_->terminate();
+            ring();
+        }
+        void use_doorbell(connection_queue::doorbell* doorbell) {
+            if (wire_->attach_doorbell()) {
+                doorbell_ = doorbell;
+            }
         }
 
     private:
         unidirectional_message_wire* wire_{};
         char* bip_buffer_{};
+        connection_queue::doorbell* doorbell_{};
+
+        void ring() {
+            if (doorbell_ != nullptr && wire_->arm_doorbell()) {
+                doorbell_->ring(wire_->doorbell_slot());
+            }
+        }
     };
 
     class response_wire_container {
@@ -149,6 +163,9 @@ public:
     session_wire_container(std::string_view name) : db_name_(name) {
         try {
             managed_shared_memory_ = std::make_unique<boost::interprocess::managed_shared_memory>(boost::interprocess::open_only, db_name_.c_str());
+            if (auto version = wire_layout(*managed_shared_memory_); version != wire_layout_version) {
+                throw std::runtime_error("the session wire layout version " + std::to_string(version) + " is not supported");
+            }
             auto req_wire = managed_shared_memory_->find<unidirectional_message_wire>(request_wire_name).first;
             auto res_wire = managed_shared_memory_->find<unidirectional_response_wire>(response_wire_name).first;
             status_provider_ = managed_shared_memory_->find<status_provider>(status_provider_name).first;
@@ -186,6 +203,14 @@ public:
     session_wire_container& operator = (session_wire_container&&) = delete;
 
     request_wire_container& get_request_wire() { return request_wire_; }
+
+    /**
+     * @brief ring the doorbell of the connection_queue after each request, if the server provides it.
+     * @param queue the connection_queue which the session is connected via
+     */
+    void use_doorbell(connection_queue& queue) {
+        request_wire_.use_doorbell(&queue.get_doorbell());
+    }
     response_wire_container& get_response_wire() { return response_wire_; }
 
     resultset_wires_container* create_resultset_wire() {
@@ -236,6 +261,9 @@ public:
                 msg += db_name;
                 throw std::runtime_error(msg.c_str());
         }
+        if (auto version = connection_layout(*managed_shared_memory_); version != connection_layout_version) {
+            throw std::runtime_error("the connection layout version " + std::to_string(version) + " is not supported");
+        }
     }
 
     /**
@@ -23,9 +23,19 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <optional>
 #include <cstdint>
+#include <thread>
+#include <chrono>
+#include <climits>
+#include <cerrno>
+#include <ctime>
 #include <sys/file.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
 #include <boost/interprocess/managed_shared_memory.hpp>
+#include <boost/interprocess/offset_ptr.hpp>
 #include <boost/interprocess/sync/interprocess_condition.hpp>
 #include <boost/interprocess/sync/interprocess_mutex.hpp>
 #include <boost/interprocess/sync/interprocess_semaphore.hpp>
@@ -78,6 +88,12 @@ public:
     using msg_type = std::uint16_t;
     using length_type = std::uint32_t;
 
+    /**
+     * @brief the type of the record that carries no response and is discarded by the client,
+     *  left in the region whose writer has failed to fill it
+     */
+    static constexpr msg_type pad = 0xffff;
+
     static constexpr std::size_t size = sizeof(length_type) + sizeof(index_type) + sizeof(msg_type);
 
     response_header(index_type idx, length_type length, msg_type type) noexcept : idx_(idx), type_(type), length_(length) {}
@@ -137,6 +153,51 @@ private:
 static constexpr const char* request_wire_name = "request_wire";
 static constexpr const char* response_wire_name = "response_wire";
 static constexpr const char* status_provider_name = "status_provider";
+static constexpr const char* retire_counter_name = "retire_counter";
+static constexpr const char* wire_layout_name = "wire_layout";
+
+/**
+ * @brief the layout version of the wires in the session segment, bumped on every incompatible change of the layout.
+ *  version 1: the initial layout, told by the absence of wire_layout_name in the segment.
+ *  version 2: the fields of simple_wire written by the producer and the consumer are placed on separate cache lines.
+ *   The result set wires wake the reader by the ready bitmap and the doorbell futex word of unidirectional_simple_wires
+ *   instead of the interprocess condition.
+ *   The response wire may be replaced by a larger buffer referred to by unidirectional_response_wire::buffer_.
+ *  version 3: the response wire carries the pad records of response_header::pad, which the client discards.
+ */
+static constexpr std::uint32_t wire_layout_version = 3;
+
+/**
+ * @brief returns the layout version of the wires in the session segment, used by the client
+ *  to check that it can communicate with the server before touching the wires.
+ */
+inline std::uint32_t wire_layout(boost::interprocess::managed_shared_memory& managed_shm) {
+    if (auto* version = managed_shm.find<std::uint32_t>(wire_layout_name).first; version) {
+        return *version;
+    }
+    return 1;
+}
+
+static constexpr const char* connection_layout_name = "connection_layout";
+
+/**
+ * @brief the layout version of the connection_queue in the connection segment, bumped on every incompatible change of the layout.
+ *  version 1: the initial layout, told by the absence of connection_layout_name in the segment.
+ *  version 2: the client waits for the acceptance of its slot on the futex word of connection_queue::element
+ *   instead of the interprocess condition, records the time of its request in the element, and rings the doorbell.
+ */
+static constexpr std::uint32_t connection_layout_version = 2;
+
+/**
+ * @brief returns the layout version of the connection_queue in the connection segment, used by the client
+ *  to check that it can communicate with the server before requesting a session.
+ */
+inline std::uint32_t connection_layout(boost::interprocess::managed_shared_memory& managed_shm) {
+    if (auto* version = managed_shm.find<std::uint32_t>(connection_layout_name).first; version) {
+        return *version;
+    }
+    return 1;
+}
 
 /**
  * @brief One-to-one unidirectional communication of charactor stream with header T
@@ -210,7 +271,7 @@ public:
             {
                 boost::interprocess::scoped_lock lock(m_mutex_);
                 wait_for_read_ = true;
-                c_empty_.wait(lock, [this, msg_length](){ return stored() >= msg_length; });
+                c_empty_.wait(lock, [this, msg_length](){ return has_stored(msg_length); });
                 wait_for_read_ = false;
             }
             read_from_buffer(top, base, read_address(base), msg_length);
@@ -256,7 +317,33 @@ public:
 
 protected:
     [[nodiscard]] std::size_t stored() const { return (pushed_.load() - poped_.load()); }  //NOLINT
-    [[nodiscard]] std::size_t room() const { return capacity_ - stored(); }  //NOLINT
+    /**
+     * @brief check whether the ring has the data of length, used by the consumer.
+     *  pushed_ written by the producer is read only when the cached copy shows that the ring is short of the data.
+     */
+    [[nodiscard]] bool has_stored(std::size_t length) const {  //NOLINT
+        auto poped = poped_.load();
+        if (auto cached = pushed_cache_.load(std::memory_order_relaxed); cached >= poped && length <= cached - poped) {
+            return true;
+        }
+        auto pushed = pushed_.load();
+        pushed_cache_.store(pushed, std::memory_order_relaxed);
+        return length <= pushed - poped;
+    }
+    /**
+     * @brief check whether the ring has the room for the data of length, used by the producer.
+     *  poped_ written by the consumer is read only when the cached copy shows that the ring is short of the room.
+     *  The cached copy never goes ahead of poped_, so that it may underestimate the room but never overestimates it.
+     */
+    [[nodiscard]] bool has_room(std::size_t length) const {  //NOLINT
+        auto pushed = pushed_.load();
+        if (auto used = pushed - poped_cache_.load(std::memory_order_relaxed); used <= capacity_ && length <= capacity_ - used) {
+            return true;
+        }
+        auto poped = poped_.load();
+        poped_cache_.store(poped, std::memory_order_relaxed);
+        return length <= capacity_ - (pushed - poped);
+    }
     [[nodiscard]] std::size_t index(std::size_t n) const { return n % capacity_; }  //NOLINT
     [[nodiscard]] std::size_t max_payload_length() const { return capacity_ - T::size; }  //NOLINT
     [[nodiscard]] static std::size_t min(std::size_t a, std::size_t b) { return (a > b) ? b : a; }  //NOLINT
@@ -268,7 +355,7 @@ protected:
     void write(char* base, const char* from, T header, std::atomic_bool& closed) {
         std::size_t length = header.get_length() + T::size;
         auto msg_length = min(length, capacity_);
-        if (msg_length > room() && !closed.load()) { wait_to_write(msg_length, closed); }
+        if (!has_room(msg_length) && !closed.load()) { wait_to_write(msg_length, closed); }
         if (closed.load()) { return; }
         write_in_buffer(base, buffer_address(base, pushed_.load()), header.get_buffer(), T::size);
         if (msg_length > T::size) {
@@ -284,7 +371,7 @@ protected:
         }
         while (length > 0) {
             msg_length = min(length, capacity_);
-            if (msg_length > room() && !closed.load()) { wait_to_write(msg_length, closed); }
+            if (!has_room(msg_length) && !closed.load()) { wait_to_write(msg_length, closed); }
             if (closed.load()) { return; }
             write_in_buffer(base, buffer_address(base, pushed_.load()), from, msg_length);
             pushed_.fetch_add(msg_length);
@@ -301,7 +388,7 @@ protected:
         boost::interprocess::scoped_lock lock(m_mutex_);
         wait_for_write_ = true;
         std::atomic_thread_fence(std::memory_order_acq_rel);
-        c_full_.wait(lock, [this, length, &closed](){ return room() >= length || closed.load(); });
+        c_full_.wait(lock, [this, length, &closed](){ return has_room(length) || closed.load(); });
         wait_for_write_ = false;
     }
     void write_in_buffer(char *base, char* top, const char* from, std::size_t length) noexcept {
@@ -335,23 +422,37 @@ protected:
         }
     }
 
+    // The fields are grouped by the side writing them, and the groups are separated by a cache line
+    // so that the producer and the consumer do not bounce a cache line on every push and pop.
+    // The gap is used instead of alignas, as the segment manager does not align the objects to the cache line.
+
+    // set up by the server, read-mostly
     boost::interprocess::managed_shared_memory::handle_t buffer_handle_{};  //NOLINT
     std::size_t capacity_;  //NOLINT
 
+    // written by the producer
+    char producer_gap_[Alignment]{};  //NOLINT
     std::atomic_ulong pushed_{0};  //NOLINT
+    mutable std::atomic_ulong poped_cache_{0};  // the producer's copy of poped_  //NOLINT
+
+    // written by the consumer
+    char consumer_gap_[Alignment]{};  //NOLINT
     std::atomic_ulong poped_{0};  //NOLINT
+    mutable std::atomic_ulong pushed_cache_{0};  // the consumer's copy of pushed_  //NOLINT
+    T header_received_{};  // NOLINT
+private:
+    std::size_t need_dispose_{};
+    std::unique_ptr<std::string> copy_of_payload_{};  // in case of ring buffer wrap around
+protected:
 
+    // written by the side going to wait, which is rare
+    char waiter_gap_[Alignment]{};  //NOLINT
     std::atomic_bool wait_for_write_{};  //NOLINT
     std::atomic_bool wait_for_read_{};  //NOLINT
 
     boost::interprocess::interprocess_mutex m_mutex_{};  //NOLINT
     boost::interprocess::interprocess_condition c_empty_{};  //NOLINT
     boost::interprocess::interprocess_condition c_full_{};  //NOLINT
-    T header_received_{};  // NOLINT
-
-private:
-    std::size_t need_dispose_{};
-    std::unique_ptr<std::string> copy_of_payload_{};  // in case of ring buffer wrap around
 };
 
 static constexpr std::int64_t MAX_TIMEOUT = 10L * 365L * 24L * 3600L * 1000L * 1000L;
@@ -369,6 +470,34 @@ inline static std::int64_t n_cap(std::int64_t timeout) {
     return (timeout > (MAX_TIMEOUT * 1000)) ? (MAX_TIMEOUT * 1000) : timeout;
 }
 
+// futex on a word placed in the shared memory, not FUTEX_PRIVATE as the word is shared by the server and client processes
+static_assert(sizeof(std::atomic_uint32_t) == sizeof(std::uint32_t));
+/**
+ * @brief wait until the word is changed from the expected value
+ * @param timeout_us the timeout in microseconds
+ * @return false if timed out
+ */
+inline static bool futex_wait(std::atomic_uint32_t* word, std::uint32_t expected, std::int64_t timeout_us) {
+    timeout_us = u_cap(timeout_us);
+    struct timespec ts{static_cast<time_t>(timeout_us / (1000 * 1000)), static_cast<long>((timeout_us % (1000 * 1000)) * 1000)};  // NOLINT
+    if (::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0) != 0) {  // NOLINT
+        return errno != ETIMEDOUT;
+    }
+    return true;
+}
+/**
+ * @brief wake up all the threads waiting for the word
+ */
+inline static void futex_wake_all(std::atomic_uint32_t* word) {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);  // NOLINT
+}
+/**
+ * @brief wake up one of the threads waiting for the word
+ */
+inline static void futex_wake_one(std::atomic_uint32_t* word) {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);  // NOLINT
+}
+
 // for request
 class unidirectional_message_wire : public simple_wire<message_header> {
     constexpr static std::size_t watch_interval = 2;
@@ -386,7 +515,7 @@ public:
             bool termination_requested = termination_requested_.load();
             bool onetime_notification = onetime_notification_.load();
             std::atomic_thread_fence(std::memory_order_acq_rel);
-            if(stored() >= message_header::size) {
+            if(has_stored(message_header::size)) {
                 copy_header(base);
                 return header_received_;
             }
@@ -402,13 +531,20 @@ public:
             std::atomic_thread_fence(std::memory_order_acq_rel);
             if (!c_empty_.timed_wait(lock,
                                      boost::get_system_time() + boost::posix_time::microseconds(u_cap(u_round(watch_interval * 1000 * 1000))),
-                                     [this](){ return (stored() >= message_header::size) || termination_requested_.load() || onetime_notification_.load(); })) {
+                                     [this](){ return has_stored(message_header::size) || termination_requested_.load() || onetime_notification_.load(); })) {
                 wait_for_read_ = false;
                 throw std::runtime_error("request has not been received within the specified time");
             }
             wait_for_read_ = false;
         }
     }
+    /**
+     * @brief check whether a request message or a termination request has arrived, without blocking.
+     * @return true if the subsequent peep() returns without waiting
+     */
+    [[nodiscard]] bool has_request() const {
+        return has_stored(message_header::size) || termination_requested_.load();
+    }
     /**
      * @brief wake up the worker immediately.
      */
@@ -453,10 +589,52 @@ public:
         }
     }
 
+    /**
+     * @brief offer the doorbell of the connection_queue to the client, used by the server.
+     * @param slot the slot index of the session to be rung
+     */
+    void enable_doorbell(std::size_t slot) {
+        doorbell_slot_.store(slot);
+    }
+    /**
+     * @brief attach the client to the doorbell, used by the client.
+     * @return true if the server offers the doorbell and the client is expected to ring it after each write
+     */
+    bool attach_doorbell() {
+        if (doorbell_slot_.load() == no_doorbell) {
+            return false;
+        }
+        doorbell_attached_.store(true);
+        return true;
+    }
+    [[nodiscard]] bool doorbell_attached() const { return doorbell_attached_.load(); }
+    [[nodiscard]] std::size_t doorbell_slot() const { return doorbell_slot_.load(); }
+    /**
+     * @brief arm the doorbell, used by the client.
+     * @return true if the caller is responsible for ringing the doorbell
+     */
+    bool arm_doorbell() {
+        std::atomic_thread_fence(std::memory_order_acq_rel);
+        return !doorbell_armed_.exchange(true);
+    }
+    /**
+     * @brief disarm the doorbell before draining the request wire, used by the server.
+     */
+    void disarm_doorbell() {
+        doorbell_armed_.store(false);
+        std::atomic_thread_fence(std::memory_order_acq_rel);
+    }
+
+    static constexpr std::size_t no_doorbell = UINT64_MAX;
+
 private:
     std::atomic_bool termination_requested_{};
     std::atomic_bool onetime_notification_{};
     std::atomic_bool closed_{};
+
+    std::atomic_ulong doorbell_slot_{no_doorbell};
+    std::atomic_bool doorbell_attached_{};
+    std::atomic_bool doorbell_armed_{};
 };
 
 
@@ -465,49 +643,24 @@ class unidirectional_response_wire : public simple_wire<response_header> {
 public:
     constexpr static std::size_t watch_interval = 5;
 
-    unidirectional_response_wire(boost::interprocess::managed_shared_memory* managed_shm_ptr, std::size_t capacity) : simple_wire<response_header>(managed_shm_ptr, capacity) {}
+    unidirectional_response_wire(boost::interprocess::managed_shared_memory* managed_shm_ptr, std::size_t capacity) : simple_wire<response_header>(managed_shm_ptr, capacity), reserve_capacity_(capacity) {}
 
     /**
-     * @brief wait for response arrival and return its header.
+     * @brief wait for response arrival and return its header, the pad records are discarded.
      */
     response_header await(const char* base, std::int64_t timeout = 0) {
-        if (timeout == 0) {
-            timeout = watch_interval * 1000 * 1000;
-        }
-
         while (true) {
-            bool closed_shutdown = closed_.load() || shutdown_.load();
-            std::atomic_thread_fence(std::memory_order_acq_rel);
-            if(stored() >= response_header::size) {
-                break;
-            }
-            if (closed_shutdown) {
-                header_received_ = response_header(0, 0, 0);
+            await_record(base, timeout);
+            if (header_received_.get_type() != response_header::pad) {
                 return header_received_;
             }
-            {
+            poped_.fetch_add(response_header::size + header_received_.get_length());
+            std::atomic_thread_fence(std::memory_order_acq_rel);
+            if (wait_for_write_) {
                 boost::interprocess::scoped_lock lock(m_mutex_);
-                wait_for_read_ = true;
-                std::atomic_thread_fence(std::memory_order_acq_rel);
-
-                if (!c_empty_.timed_wait(lock, boost::get_system_time() + boost::posix_time::microseconds(u_cap(u_round(timeout))), [this](){ return (stored() >= response_header::size) || closed_.load() || shutdown_.load(); })) {
-                    wait_for_read_ = false;
-                    throw std::runtime_error("response has not been received within the specified time");
-                }
-                wait_for_read_ = false;
+                c_full_.notify_one();
             }
         }
-
-        if ((base + capacity_) >= (read_address(base) + response_header::size)) {  //NOLINT
-            header_received_ = response_header(read_address(base));  // normal case
-        } else {
-            char buf[response_header::size];  // in case for ring buffer full  //NOLINT
-            std::size_t first_part = capacity_ - index(poped_.load());
-            memcpy(buf, read_address(base), first_part);  //NOLINT
-            memcpy(buf + first_part, base, response_header::size - first_part);  //NOLINT
-            header_received_ = response_header(static_cast<char*>(buf));
-        }
-        return header_received_;
     }
     [[nodiscard]] response_header::length_type get_length() const {
         return header_received_.get_length();
@@ -518,6 +671,12 @@ public:
     [[nodiscard]] response_header::msg_type get_type() const {
         return header_received_.get_type();
     }
+    /**
+     * @brief read and pop the current response message, used by the client.
+     */
+    void read(char* top, const char* base) {
+        simple_wire<response_header>::read(top, current_buffer(base));
+    }
     /**
      * @brief close the response wire, used by the client.
      */
@@ -548,15 +707,196 @@ public:
      * @param header the header of the response message
      */
     void write(char* base, const char* from, response_header header) {
-        simple_wire<response_header>::write(base, from, header, closed_);
+        auto reserved = lock_reservation();
+        wait_for_turn(reserved);
+        simple_wire<response_header>::write(current_buffer(base), from, header, closed_);
+        unlock_reservation(pushed_.load());
+    }
+    /**
+     * @brief write response message if it can be written without waiting,
+     *  neither for the room nor for the writers reserved earlier, used by the non-blockable writers
+     * @param base the base address of the response wire
+     * @param from the response message to be written in the response wire
+     * @param header the header of the response message
+     * @return true if the response message has been written
+     */
+    bool try_write(char* base, const char* from, response_header header) {
+        auto reserved = reserved_.load();
+        if ((reserved & reservation_lock) != 0 || reserved != pushed_.load() || !reserved_.compare_exchange_strong(reserved, reserved | reservation_lock)) {
+            return false;
+        }
+        if (!has_room(response_header::size + header.get_length())) {
+            unlock_reservation(reserved);
+            return false;
+        }
+        simple_wire<response_header>::write(current_buffer(base), from, header, closed_);
+        unlock_reservation(pushed_.load());
+        return true;
+    }
+    /**
+     * @brief replace the buffer with the larger one if the client has read all the messages
+     *  and no writer has reserved the region, without waiting, used by the server.
+     *  Only the client that has accepted wire_layout_version on attaching to the session segment reads the wire,
+     *  and that version tells the client to read the buffer through buffer_.
+     * @param base the base address of the response wire
+     * @param buffer the new buffer allocated in the managed shared memory where this object resides,
+     *  whose capacity is a multiple of the current capacity
+     * @param capacity the capacity of the new buffer
+     * @return the buffer no longer used, which is to be deallocated by the caller,
+     *  or nullptr if the buffer has not been replaced as the response wire is in use
+     */
+    char* try_grow(char* base, char* buffer, std::size_t capacity) noexcept {
+        auto reserved = reserved_.load();
+        if ((reserved & reservation_lock) != 0 || reserved != pushed_.load() || reserved != poped_.load() || closed_.load()) {
+            return nullptr;
+        }
+        if (!reserved_.compare_exchange_strong(reserved, reserved | reservation_lock)) {
+            return nullptr;
+        }
+        // the response wire stays empty, as no writer can reserve the region and the client has nothing to read
+        char* old_buffer = current_buffer(base);
+        buffer_ = buffer;
+        capacity_ = capacity;
+        reserve_capacity_.store(capacity);
+        std::atomic_thread_fence(std::memory_order_release);
+        unlock_reservation(reserved);
+        return old_buffer;
+    }
+    /**
+     * @brief returns the capacity of the response wire.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return capacity_;
+    }
+    /**
+     * @brief reserve the region for the response message, this can be called by multiple writers concurrently.
+     *  The region reserved must be committed by commit() even if the writer fails to fill it,
+     *  as the messages reserved later are not published until its commit.
+     * @param length the length of the response message
+     * @param position the position of the region reserved
+     * @param contiguous true if the region of the message body must not wrap around the ring buffer
+     * @return true if the region has been reserved, false if the room is not available without waiting
+     */
+    bool try_reserve(response_header::length_type length, std::size_t& position, bool contiguous = false) {
+        std::size_t msg_length = response_header::size + length;
+        auto reserved = reserved_.load();
+        while (true) {
+            if ((reserved & reservation_lock) != 0 || closed_.load()) {
+                return false;
+            }
+            // the capacity older than the one swapped by try_grow() concurrently is still safe, as the new one is its multiple
+            auto capacity = reserve_capacity_.load();
+            if (contiguous && (reserved + response_header::size) % capacity + length > capacity) {
+                return false;
+            }
+            if ((reserved + msg_length) - poped_cache_.load(std::memory_order_relaxed) > capacity) {
+                auto poped = poped_.load();
+                poped_cache_.store(poped, std::memory_order_relaxed);
+                if ((reserved + msg_length) - poped > capacity) {
+                    return false;
+                }
+            }
+            if (reserved_.compare_exchange_weak(reserved, reserved + msg_length)) {
+                position = reserved;
+                return true;
+            }
+        }
     }
+    /**
+     * @brief get the address of the reserved region to which the response message is directly serialized
+     * @param base the base address of the response wire
+     * @param position the position given by try_reserve()
+     * @param length the length of the response message
+     * @return the address of the region, or nullptr if the region wraps around the ring buffer
+     */
+    char* reserved_address(char* base, std::size_t position, response_header::length_type length) {
+        base = current_buffer(base);
+        auto top = index(position + response_header::size);
+        if (top + length > capacity_) {  // ring buffer wrap around case
+            return nullptr;
+        }
+        return base + top;  // NOLINT
+    }
+    /**
+     * @brief copy the response message into the reserved region
+     * @param base the base address of the response wire
+     * @param position the position given by try_reserve()
+     * @param from the response message
+     * @param length the length of the response message
+     */
+    void write_reserved(char* base, std::size_t position, const char* from, response_header::length_type length) noexcept {
+        base = current_buffer(base);
+        write_in_buffer(base, buffer_address(base, position + response_header::size), from, length);
+    }
+    /**
+     * @brief write the header and publish the response message in the reserved region,
+     *  the messages are published in the order of reservation.
+     *  A message committed while the writers reserved earlier are still filling their regions is parked,
+     *  and is published by the writer committing the message just before it, so that the writer need not wait for its turn.
+     *  The client reads the messages published by pushed_ as before, which never goes beyond a region not committed yet.
+     * @param base the base address of the response wire
+     * @param position the position given by try_reserve()
+     * @param header the header of the response message
+     */
+    void commit(char* base, std::size_t position, response_header header) noexcept {
+        base = current_buffer(base);
+        write_in_buffer(base, buffer_address(base, position), header.get_buffer(), response_header::size);
+        auto end = position + response_header::size + header.get_length();
+        if (auto expected = position; !pushed_.compare_exchange_strong(expected, end) && !park(position, end)) {
+            wait_for_turn(position);  // all the parking slots are taken
+            pushed_.store(end);
+        }
+        publish_parked();
+        notify_turn();
+        std::atomic_thread_fence(std::memory_order_acq_rel);
+        if (wait_for_read_) {
+            boost::interprocess::scoped_lock lock(m_mutex_);
+            c_empty_.notify_one();
+        }
+    }
+
+    /**
+     * @brief the region reserved by try_reserve(), which is committed on destruction unless commit() has been called,
+     *  so that the messages reserved later are not held forever by a writer that has left the region by an exception.
+     *  The region left is published as a pad record, which the client discards.
+     */
+    class reservation {
+    public:
+        reservation(unidirectional_response_wire* wire, char* base, std::size_t position, response_header header) noexcept
+            : wire_(wire), base_(base), position_(position), header_(header) {}
+        ~reservation() {
+            if (wire_ != nullptr) {
+                wire_->commit(base_, position_, response_header(header_.get_idx(), header_.get_length(), response_header::pad));
+            }
+        }
+
+        reservation(reservation const&) = delete;
+        reservation(reservation&&) = delete;
+        reservation& operator = (reservation const&) = delete;
+        reservation& operator = (reservation&&) = delete;
+
+        /**
+         * @brief publish the response message written in the region
+         */
+        void commit() noexcept {
+            wire_->commit(base_, position_, header_);
+            wire_ = nullptr;
+        }
+
+    private:
+        unidirectional_response_wire* wire_;
+        char* base_;
+        std::size_t position_;
+        response_header header_;
+    };
+
     /**
      * @brief check buffer has space for the response message
      * @param header the header of the response message
      * @return true if the buffer has space for the response message
      */
     bool is_writable(response_header header) {
-        return room() >= header.get_length();
+        return has_room(header.get_length());
     }
     /**
      * @brief notify client of the client of the shutdown
@@ -580,12 +920,156 @@ public:
     }
 
 private:
+    static constexpr std::size_t reservation_lock = 1UL << 63UL;
+    static constexpr std::size_t turn_spin = 64;
+    static constexpr std::size_t turn_yield = 1024;
+    static constexpr std::size_t parking_slots = 64;
+    static constexpr std::size_t parking = ~0UL;  // the parking slot taken and being filled
+
     std::atomic_bool closed_{};
     std::atomic_bool shutdown_{};
+    boost::interprocess::offset_ptr<char> buffer_{};  // the buffer replaced by try_grow()
+    char reservation_gap_[Alignment]{};  // reserved_ is written on every response  //NOLINT
+    std::atomic_ulong reserved_{0};  // used by the server only
+    std::atomic_uint32_t turn_{0};  // bumped whenever pushed_ or reserved_ moves, used by the server only
+    std::atomic_uint32_t turn_waiters_{0};  // used by the server only
+    std::atomic_ulong reserve_capacity_;  // capacity_ read by try_reserve() without the reservation lock, used by the server only
+    std::atomic_ulong parked_count_{0};  // used by the server only
+    std::atomic_ulong parked_[parking_slots]{};  // the position + 1 of the message parked, or 0 if free, used by the server only  //NOLINT
+    std::atomic_ulong parked_end_[parking_slots]{};  // the end of the message parked, used by the server only  //NOLINT
+
+    // wait for the next record, which may be a pad record
+    response_header await_record(const char* base, std::int64_t timeout) {
+        if (timeout == 0) {
+            timeout = watch_interval * 1000 * 1000;
+        }
+
+        while (true) {
+            bool closed_shutdown = closed_.load() || shutdown_.load();
+            std::atomic_thread_fence(std::memory_order_acq_rel);
+            if(has_stored(response_header::size)) {
+                break;
+            }
+            if (closed_shutdown) {
+                header_received_ = response_header(0, 0, 0);
+                return header_received_;
+            }
+            {
+                boost::interprocess::scoped_lock lock(m_mutex_);
+                wait_for_read_ = true;
+                std::atomic_thread_fence(std::memory_order_acq_rel);
+
+                if (!c_empty_.timed_wait(lock, boost::get_system_time() + boost::posix_time::microseconds(u_cap(u_round(timeout))), [this](){ return has_stored(response_header::size) || closed_.load() || shutdown_.load(); })) {
+                    wait_for_read_ = false;
+                    throw std::runtime_error("response has not been received within the specified time");
+                }
+                wait_for_read_ = false;
+            }
+        }
+
+        base = current_buffer(base);
+        if ((base + capacity_) >= (read_address(base) + response_header::size)) {  //NOLINT
+            header_received_ = response_header(read_address(base));  // normal case
+        } else {
+            char buf[response_header::size];  // in case for ring buffer full  //NOLINT
+            std::size_t first_part = capacity_ - index(poped_.load());
+            memcpy(buf, read_address(base), first_part);  //NOLINT
+            memcpy(buf + first_part, base, response_header::size - first_part);  //NOLINT
+            header_received_ = response_header(static_cast<char*>(buf));
+        }
+        return header_received_;
+    }
+
+    template <typename C>
+    C* current_buffer(C* base) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer_) {
+            return buffer_.get();
+        }
+        return base;
+    }
+    std::size_t lock_reservation() noexcept {
+        std::size_t reserved{};
+        wait_until([this, &reserved](){  // lock the reservation against the concurrent writers
+            reserved = reserved_.load();
+            return (reserved & reservation_lock) == 0 && reserved_.compare_exchange_weak(reserved, reserved | reservation_lock);
+        });
+        return reserved;
+    }
+    void unlock_reservation(std::size_t reserved) noexcept {
+        reserved_.store(reserved);
+        notify_turn();
+    }
+    bool park(std::size_t position, std::size_t end) noexcept {
+        parked_count_.fetch_add(1);
+        for (auto i = 0UL; i < parking_slots; i++) {
+            if (std::size_t expected = 0; parked_[i].compare_exchange_strong(expected, parking)) {  //NOLINT
+                parked_end_[i].store(end);  //NOLINT
+                parked_[i].store(position + 1);  //NOLINT
+                return true;
+            }
+        }
+        parked_count_.fetch_sub(1);
+        return false;
+    }
+    // publish the messages parked which have come to their turn, any writer committing can publish them,
+    // as only the writer that takes the parking slot of the message at pushed_ moves pushed_
+    void publish_parked() noexcept {
+        while (parked_count_.load() > 0) {
+            auto pushed = pushed_.load();
+            bool published = false;
+            for (auto i = 0UL; i < parking_slots; i++) {
+                if (std::size_t expected = pushed + 1; parked_[i].load() == expected && parked_[i].compare_exchange_strong(expected, parking)) {  //NOLINT
+                    auto end = parked_end_[i].load();  //NOLINT
+                    parked_[i].store(0);  //NOLINT
+                    parked_count_.fetch_sub(1);
+                    pushed_.store(end);
+                    published = true;
+                    break;
+                }
+            }
+            if (!published) {
+                return;
+            }
+        }
+    }
+    void wait_for_turn(std::size_t position) noexcept {
+        wait_until([this, position](){  // the writers reserved earlier have not published yet
+            return pushed_.load(std::memory_order_acquire) == position;
+        });
+    }
+    // spin and yield for a while, then sleep on turn_ not to burn the cpu behind a writer descheduled or stalled
+    template <typename F>
+    void wait_until(F&& done) noexcept {
+        for (std::size_t spin = 0; spin < turn_spin + turn_yield; spin++) {
+            if (done()) {
+                return;
+            }
+            if (spin >= turn_spin) {
+                std::this_thread::yield();
+            }
+        }
+        turn_waiters_.fetch_add(1);
+        while (true) {
+            auto turn = turn_.load();
+            if (done()) {
+                break;
+            }
+            futex_wait(&turn_, turn, watch_interval * 1000 * 1000);
+        }
+        turn_waiters_.fetch_sub(1);
+    }
+    void notify_turn() noexcept {
+        turn_.fetch_add(1);
+        if (turn_waiters_.load() > 0) {
+            futex_wake_all(&turn_);
+        }
+    }
 };
 
 
-// for resultset
+// for resultset, the reader is woken by the doorbell only, which is told to the client by wire_layout_version,
+// as a client waiting on the interprocess condition of version 1 would never be notified
 class unidirectional_simple_wires {
     constexpr static std::size_t watch_interval = 5;
 public:
@@ -626,8 +1110,28 @@ public:
          *  used by server
          */
         void flush() {
+            seal();
+            publish();
+        }
+        /**
+         * @brief mark the record boundary without making the record visible to the client,
+         *  the sealed records are made visible together by the next publish() or flush().
+         *  used by server
+         */
+        void seal() {
             if (continued_) {
-                flush(get_bip_address(managed_shm_ptr_));
+                seal(get_bip_address(managed_shm_ptr_));
+            }
+        }
+        /**
+         * @brief make the sealed records visible to the clinet by a single store, and notify the record arrival once.
+         *  used by server
+         */
+        void publish() {
+            if (sealed_ != pushed_valid_.load()) {
+                pushed_valid_.store(sealed_);
+                std::atomic_thread_fence(std::memory_order_acq_rel);
+                envelope_->notify_record_arrival(this);
             }
         }
         /**
@@ -637,9 +1141,9 @@ public:
          */
         [[nodiscard]] bool check_room(std::size_t length) noexcept {
             if (continued_) {
-                return room() >= length;
+                return has_room(length);
             }
-            return room() >= (length + length_header::size);
+            return has_room(length + length_header::size);
         }
         /**
          * @brief wait data of length can be written.
@@ -711,34 +1215,33 @@ public:
     private:
         void brand_new() {
             std::size_t length = length_header::size;
-            if (length > room()) {
+            if (!has_room(length)) {
                 wait_to_resultset_write(length);
             }
             pushed_.fetch_add(length);
         }
 
         void write(char* base, const char* from, std::size_t length) {
-            if (length > room()) {
+            if (!has_room(length)) {
                 wait_to_resultset_write(length);
             }
             write_in_buffer(base, buffer_address(base, pushed_.load()), from, length);
             pushed_.fetch_add(length);
         }
 
-        void flush(char* base) {
-            length_header header(pushed_.load() - (pushed_valid_.load() + length_header::size));
-            write_in_buffer(base, buffer_address(base, pushed_valid_.load()), header.get_buffer(), length_header::size);
-            pushed_valid_.store(pushed_.load());
-            std::atomic_thread_fence(std::memory_order_acq_rel);
-            envelope_->notify_record_arrival();
+        void seal(char* base) {
+            length_header header(pushed_.load() - (sealed_ + length_header::size));
+            write_in_buffer(base, buffer_address(base, sealed_), header.get_buffer(), length_header::size);
+            sealed_ = pushed_.load();
             continued_ = false;
         }
 
         void wait_to_resultset_write(std::size_t length) {
+            publish();  // the client cannot make room without reading the sealed records
             boost::interprocess::scoped_lock lock(m_mutex_);
             wait_for_write_ = true;
             std::atomic_thread_fence(std::memory_order_acq_rel);
-            c_full_.wait(lock, [this, length](){ return (room() >= length) || closed_; });
+            c_full_.wait(lock, [this, length](){ return has_room(length) || closed_; });
             wait_for_write_ = false;
         }
 
@@ -759,6 +1262,7 @@ public:
 
         boost::interprocess::managed_shared_memory* managed_shm_ptr_{};  // used by server only
         std::atomic_ulong pushed_valid_{0};                              // used by server only
+        std::size_t sealed_{0};                                          // used by server only
         std::atomic_bool closed_{};                                      // written by client, read by server
         bool continued_{};                                               // used by server only
         unidirectional_simple_wires* envelope_{};                        // used by server only
@@ -769,7 +1273,8 @@ public:
      * @brief unidirectional_simple_wires constructer
      */
     unidirectional_simple_wires(boost::interprocess::managed_shared_memory* managed_shm_ptr, std::size_t count, std::size_t buffer_size)
-        : managed_shm_ptr_(managed_shm_ptr), unidirectional_simple_wires_(count, managed_shm_ptr->get_segment_manager()), buffer_size_(buffer_size), reserved_(static_cast<char*>(managed_shm_ptr->allocate_aligned(buffer_size_, Alignment))) {
+        : managed_shm_ptr_(managed_shm_ptr), unidirectional_simple_wires_(count, managed_shm_ptr->get_segment_manager()), buffer_size_(buffer_size), reserved_(static_cast<char*>(managed_shm_ptr->allocate_aligned(buffer_size_, Alignment))),
+          ready_((count + bits_per_word - 1) / bits_per_word, managed_shm_ptr->get_segment_manager()) {
         for (auto&& wire: unidirectional_simple_wires_) {
             wire.set_environments(this, managed_shm_ptr);
         }
@@ -847,45 +1352,73 @@ public:
         }
 
         while (true) {
-            for (auto&& wire: unidirectional_simple_wires_) {
-                if(wire.has_record()) {
-                    return &wire;
-                }
+            auto rung = doorbell_.load();
+            bool eor = is_eor();
+            if (auto* wire = ready_wire(); wire != nullptr) {
+                return wire;
             }
-            {
-                boost::interprocess::scoped_lock lock(m_record_);
-                wait_for_record_ = true;
-                std::atomic_thread_fence(std::memory_order_acq_rel);
-                unidirectional_simple_wire* active_wire = nullptr;
-                if (!c_record_.timed_wait(lock,
-#ifdef BOOST_DATE_TIME_HAS_NANOSECONDS
-                                          boost::get_system_time() + boost::posix_time::nanoseconds(n_cap(timeout)),
-#else
-                                          boost::get_system_time() + boost::posix_time::microseconds(u_cap(u_round(timeout))),
-#endif
-                                          [this, &active_wire](){
-                                              bool eor = is_eor();
-                                              std::atomic_thread_fence(std::memory_order_acq_rel);
-                                              for (auto&& wire: unidirectional_simple_wires_) {
-                                                  if (wire.has_record()) {
-                                                      active_wire = &wire;
-                                                      return true;
-                                                  }
-                                              }
-                                              return eor;
-                                          })) {
-                    wait_for_record_ = false;
-                    throw std::runtime_error("record has not been received within the specified time");
+            if (eor) {
+                return nullptr;
+            }
+            if (!wait_doorbell(rung, u_round(timeout))) {
+                throw std::runtime_error("record has not been received within the specified time");
+            }
+        }
+    }
+
+    /**
+     * @brief provide the doorbell rung by the server on the record arrival and the end of the result set,
+     *  the client can wait on the word with FUTEX_WAIT, while incrementing doorbell_waiters() during the wait.
+     *  used by clinet
+     */
+    [[nodiscard]] std::atomic_uint32_t& doorbell() noexcept {
+        return doorbell_;
+    }
+    [[nodiscard]] std::atomic_uint32_t& doorbell_waiters() noexcept {
+        return doorbell_waiters_;
+    }
+    /**
+     * @brief wait for the doorbell rung after the rung value has been read
+     *  used by clinet
+     * @param rung the value of the doorbell read before checking the wires
+     * @param timeout_us the timeout in microseconds
+     * @return false if timed out
+     */
+    bool wait_doorbell(std::uint32_t rung, std::int64_t timeout_us) {
+        doorbell_waiters_.fetch_add(1);
+        bool rv = true;
+        if (doorbell_.load() == rung) {
+            rv = futex_wait(&doorbell_, rung, timeout_us);
+        }
+        doorbell_waiters_.fetch_sub(1);
+        return rv;
+    }
+    /**
+     * @brief search a wire that has record using the ready bitmap, instead of scanning all the wires
+     *  used by clinet
+     * @return the wire that has record, nullptr if there is no such wire
+     */
+    unidirectional_simple_wire* ready_wire() {
+        for (std::size_t w = 0; w < ready_.size(); w++) {
+            auto& word = ready_.at(w);
+            auto bits = word.load();
+            while (bits != 0) {
+                auto bit = static_cast<std::size_t>(__builtin_ctzll(bits));
+                auto mask = 1ULL << bit;
+                bits &= ~mask;
+                auto& wire = unidirectional_simple_wires_.at(w * bits_per_word + bit);
+                if (wire.has_record()) {
+                    return &wire;
                 }
-                wait_for_record_ = false;
-                if (active_wire != nullptr) {
-                    return active_wire;
+                // clear the bit and check again, as the server sets the bit only when it is cleared
+                word.fetch_and(~mask);
+                if (wire.has_record()) {
+                    word.fetch_or(mask);
+                    return &wire;
                 }
             }
-            if (is_eor()) {
-                return nullptr;
-            }
         }
+        return nullptr;
     }
 
     /**
@@ -897,6 +1430,23 @@ public:
             wire.set_closed();
         }
         closed_ = true;
+        bump_retire_counter();
+    }
+    /**
+     * @brief register the counter of the session placed in the same segment,
+     *  which is bumped whenever a result set wires in the session may become ready to be retired.
+     *  used by server
+     */
+    void set_retire_counter(std::atomic_uint64_t* counter) noexcept {
+        retire_counter_ = counter;
+    }
+    /**
+     * @brief notify the server that this result set wires may become ready to be retired.
+     */
+    void bump_retire_counter() {
+        if (retire_counter_) {
+            retire_counter_->fetch_add(1);
+        }
     }
     /**
      * @brief returns that the client has closed the result set wire
@@ -911,11 +1461,7 @@ public:
      */
     void set_eor() {
         eor_ = true;
-        std::atomic_thread_fence(std::memory_order_acq_rel);
-        {
-            boost::interprocess::scoped_lock lock(m_record_);
-            c_record_.notify_one();
-        }
+        ring_doorbell();
     }
     /**
      * @brief returns that the server has marked the end of the result set
@@ -952,13 +1498,26 @@ private:
      * @brief notify the arrival of a record
      *  used by server
      */
-    void notify_record_arrival() {
-        boost::interprocess::scoped_lock lock(m_record_);
-        c_record_.notify_one();
+    void notify_record_arrival(unidirectional_simple_wire* wire) {
+        auto index = static_cast<std::size_t>(wire - &unidirectional_simple_wires_.at(0));
+        auto& word = ready_.at(index / bits_per_word);
+        auto mask = 1ULL << (index % bits_per_word);
+        if ((word.load() & mask) == 0) {
+            word.fetch_or(mask);
+        }
+        ring_doorbell();
+    }
+    void ring_doorbell() {
+        doorbell_.fetch_add(1);
+        if (doorbell_waiters_.load() > 0) {
+            futex_wake_all(&doorbell_);
+        }
     }
 
     static constexpr std::size_t Alignment = 64;
+    static constexpr std::size_t bits_per_word = 64;
     using allocator = boost::interprocess::allocator<unidirectional_simple_wire, boost::interprocess::managed_shared_memory::segment_manager>;
+    using word_allocator = boost::interprocess::allocator<std::atomic_uint64_t, boost::interprocess::managed_shared_memory::segment_manager>;
 
     boost::interprocess::managed_shared_memory* managed_shm_ptr_;  // used by server only
     std::vector<unidirectional_simple_wire, allocator> unidirectional_simple_wires_;
@@ -971,9 +1530,10 @@ private:
 
     std::atomic_bool eor_{};
     std::atomic_bool closed_{};
-    std::atomic_bool wait_for_record_{};
-    boost::interprocess::interprocess_mutex m_record_{};
-    boost::interprocess::interprocess_condition c_record_{};
+    std::vector<std::atomic_uint64_t, word_allocator> ready_;  // a bit per wire, set by the server on the record arrival
+    std::atomic_uint32_t doorbell_{};
+    std::atomic_uint32_t doorbell_waiters_{};
+    boost::interprocess::offset_ptr<std::atomic_uint64_t> retire_counter_{};
 };
 
 using shm_resultset_wire = unidirectional_simple_wires::unidirectional_simple_wire;
@@ -1120,6 +1680,9 @@ public:
         element& operator = (element const&) = delete;
         element& operator = (element&& elm) = delete;
 
+        void request() {
+            requested_at_ = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
         void accept(std::size_t session_id) {
             session_id_ = session_id;
             notify();
@@ -1129,19 +1692,20 @@ public:
             notify();
         }
         [[nodiscard]] std::size_t wait(std::int64_t timeout = 0) {
-            std::atomic_thread_fence(std::memory_order_acq_rel);
             if (timeout <= 0) {
-                boost::interprocess::scoped_lock lock(m_accepted_);
-                c_accepted_.wait(lock, [this](){ return (session_id_ != 0); });
-            } else {
-                boost::interprocess::scoped_lock lock(m_accepted_);
-                if (!c_accepted_.timed_wait(lock,
+                while (!check()) {
+                    wait_notification(MAX_TIMEOUT);
+                }
+                return session_id_;
+            }
 #ifdef BOOST_DATE_TIME_HAS_NANOSECONDS
-                                        boost::get_system_time() + boost::posix_time::nanoseconds(n_cap(timeout)),
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(n_cap(timeout));
 #else
-                                        boost::get_system_time() + boost::posix_time::microseconds(u_cap(u_round(timeout))),
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(u_cap(u_round(timeout)));
 #endif
-                                        [this](){ return (session_id_ != 0); })) {
+            while (!check()) {
+                auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0 || (!wait_notification(remaining) && !check())) {
                     throw std::runtime_error("connection response has not been accepted within the specified time");
                 }
             }
@@ -1149,21 +1713,137 @@ public:
         }
         void reuse() {
             session_id_ = 0;
+            requested_at_ = 0;
+            accepted_.store(0);
         }
         [[nodiscard]] bool check() const {
-            return session_id_ != 0;
+            return accepted_.load() != 0;
+        }
+        /**
+         * @brief returns the time elapsed since the client requested the slot, in microseconds
+         *  used by server
+         * @return the time elapsed, or std::nullopt if the client has not recorded the time of its request
+         */
+        [[nodiscard]] std::optional<std::int64_t> elapsed() const {
+            if (requested_at_ == 0) {
+                return std::nullopt;
+            }
+            auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            return (now - requested_at_) / 1000;
         }
     private:
-        boost::interprocess::interprocess_mutex m_accepted_{};
-        boost::interprocess::interprocess_condition c_accepted_{};
         std::size_t session_id_{};
+        std::int64_t requested_at_{};  // steady_clock is CLOCK_MONOTONIC, which is shared by the server and client processes
+        std::atomic_uint32_t accepted_{};
+        std::atomic_uint32_t waiters_{};
 
+        // notify the client waiting for this slot only, without taking an interprocess mutex
         void notify() {
-            std::atomic_thread_fence(std::memory_order_acq_rel);
-            {
-                boost::interprocess::scoped_lock lock(m_accepted_);
-                c_accepted_.notify_one();
+            accepted_.store(1);
+            if (waiters_.load() > 0) {
+                futex_wake_all(&accepted_);
+            }
+        }
+        bool wait_notification(std::int64_t timeout_us) {
+            waiters_.fetch_add(1);
+            bool rv = true;
+            if (!check()) {
+                rv = futex_wait(&accepted_, 0, timeout_us);
             }
+            waiters_.fetch_sub(1);
+            return rv;
+        }
+    };
+    /**
+     * @brief the ready bitmap of the slots whose request wire has received a request,
+     *  rung by the client and drained by the server's io threads.
+     *  It takes no lock, so that neither the sessions contend with each other nor a client dying while ringing blocks the server.
+     */
+    class doorbell {
+        using word_allocator = boost::interprocess::allocator<std::atomic_uint64_t, boost::interprocess::managed_shared_memory::segment_manager>;
+
+    public:
+        constexpr static std::size_t no_slot = UINT64_MAX;
+
+        doorbell(std::size_t size, boost::interprocess::managed_shared_memory::segment_manager* mgr) : ready_((size + bits_per_word - 1) / bits_per_word, mgr), size_(size) {
+        }
+
+        /**
+         * @brief notify the server that the request wire of the slot has received a request,
+         *  the rings of the same slot are coalesced until the slot is taken by wait().
+         * @param slot the slot index of the session
+         */
+        void ring(std::size_t slot) {
+            if (slot >= size_) {
+                return;
+            }
+            ready_.at(slot / bits_per_word).fetch_or(1ULL << (slot % bits_per_word));
+            rung_.fetch_add(1);
+            if (waiters_.load() > 0) {
+                futex_wake_one(&rung_);
+            }
+        }
+        /**
+         * @brief wait for the doorbell to be rung.
+         * @param timeout the timeout in microseconds
+         * @return the slot index rung, or no_slot if timeout occurs
+         */
+        [[nodiscard]] std::size_t wait(std::int64_t timeout) {
+            auto rung = rung_.load();
+            if (auto slot = take(); slot != no_slot || interrupted_.load()) {
+                return slot;
+            }
+            waiters_.fetch_add(1);
+            if (rung_.load() == rung) {
+                futex_wait(&rung_, rung, u_round(timeout));
+            }
+            waiters_.fetch_sub(1);
+            return take();
+        }
+        /**
+         * @brief wake up all the threads waiting for the doorbell, used in the server termination.
+         */
+        void interrupt() {
+            interrupted_.store(true);
+            rung_.fetch_add(1);
+            futex_wake_all(&rung_);
+        }
+
+    private:
+        static constexpr std::size_t bits_per_word = 64;
+
+        std::vector<std::atomic_uint64_t, word_allocator> ready_;  // a bit per slot, set by the client on the request arrival
+        std::size_t size_;
+        std::atomic_uint32_t rung_{};
+        std::atomic_uint32_t waiters_{};
+        std::atomic_ulong cursor_{};  // the slot from which the next search starts, so that the slots are taken in turn
+        std::atomic_bool interrupted_{};
+
+        // take a slot from the bitmap, starting from cursor_ and wrapping around
+        std::size_t take() {
+            auto words = ready_.size();
+            auto start = cursor_.load(std::memory_order_relaxed) % (words * bits_per_word);
+            for (std::size_t i = 0; i <= words; i++) {
+                auto w = (start / bits_per_word + i) % words;
+                auto& word = ready_.at(w);
+                auto bits = word.load();
+                if (i == 0) {
+                    bits &= ~0ULL << (start % bits_per_word);
+                } else if (i == words) {
+                    bits &= ~(~0ULL << (start % bits_per_word));  // the bits of the first word skipped at i == 0
+                }
+                while (bits != 0) {
+                    auto bit = static_cast<std::size_t>(__builtin_ctzll(bits));
+                    auto mask = 1ULL << bit;
+                    if ((word.fetch_and(~mask) & mask) != 0) {
+                        auto slot = w * bits_per_word + bit;
+                        cursor_.store(slot + 1, std::memory_order_relaxed);
+                        return slot;
+                    }
+                    bits &= ~mask;  // taken by another io thread
+                }
+            }
+            return no_slot;
         }
     };
 
@@ -1179,7 +1859,7 @@ public:
      * @brief Construct a new object.
      */
     connection_queue(std::size_t n, boost::interprocess::managed_shared_memory::segment_manager* mgr, std::uint8_t as_n)
-        : q_free_(n + as_n, mgr), q_requested_(n + as_n, mgr), v_requested_(n + as_n, mgr), admin_slots_(as_n) {
+        : q_free_(n + as_n, mgr), q_requested_(n + as_n, mgr), v_requested_(n + as_n, mgr), admin_slots_(as_n), doorbell_(n + as_n, mgr) {
         q_free_.fill(as_n);
     }
     ~connection_queue() = default;
@@ -1194,11 +1874,13 @@ public:
 
     std::size_t request() {
         auto sid = q_free_.try_pop();
+        v_requested_.at(sid).request();
         q_requested_.push(sid);
         return sid;
     }
     std::size_t request_admin() {
         auto sid = q_free_.try_pop(admin_slots_);
+        v_requested_.at(reset_admin(sid)).request();
         q_requested_.push(sid);
         return sid;
     }
@@ -1228,17 +1910,53 @@ public:
     // either accept() or reject() must be called
     void accept(std::size_t sid, std::size_t session_id) {
         q_requested_.pop();
-        v_requested_.at(reset_admin(sid)).accept(session_id);
+        accept_taken(sid, session_id);
     }
     // either accept() or reject() must be called
     void reject(std::size_t sid) {
         q_requested_.pop();
+        reject_taken(sid);
+    }
+    /**
+     * @brief take the slot requested out of the queue, so that the listener can proceed to the next request
+     *  while the session is set up by another thread. Either accept_taken() or reject_taken() must be called for the slot.
+     *  thread unsafe (assume single listener thread)
+     * @return the slot id taken
+     */
+    std::size_t take() {
+        auto sid = q_requested_.front();
+        q_requested_.pop();
+        return sid;
+    }
+    void accept_taken(std::size_t sid, std::size_t session_id) {
+        v_requested_.at(reset_admin(sid)).accept(session_id);
+    }
+    void reject_taken(std::size_t sid) {
         v_requested_.at(reset_admin(sid)).reject();
         q_free_.push(sid, admin_slots_);
     }
+    /**
+     * @brief returns the time elapsed since the client requested the slot, in microseconds
+     * @return the time elapsed, or std::nullopt if the client has not recorded the time of its request
+     */
+    [[nodiscard]] std::optional<std::int64_t> elapsed(std::size_t sid) const {
+        return v_requested_.at(reset_admin(sid)).elapsed();
+    }
     void disconnect(std::size_t sid) {
         q_free_.push(sid, admin_slots_);
     }
+    /**
+     * @brief take an admin slot while a request of the admin channel is served, so that the admin channel
+     *  and the admin sessions share the budget of the admin slots. release_admin_slot() must be called for the slot.
+     * @return the slot id taken
+     * @throws std::runtime_error if all the admin slots are in use
+     */
+    std::size_t acquire_admin_slot() {
+        return q_free_.try_pop(admin_slots_);
+    }
+    void release_admin_slot(std::size_t sid) {
+        q_free_.push(sid, admin_slots_);
+    }
 
     // for terminate
     void request_terminate() {
@@ -1250,6 +1968,9 @@ public:
     bool is_terminated() noexcept { return terminate_; }
     void confirm_terminated() { s_terminated_.post(); }
 
+    // for event driven io threads
+    doorbell& get_doorbell() noexcept { return doorbell_; }
+
     // for diagnostic
     [[nodiscard]] std::size_t pending_requests() const {
         return q_requested_.size();
@@ -1268,6 +1989,350 @@ private:
     boost::interprocess::interprocess_semaphore s_terminated_{0};
 
     std::size_t session_id_{};
+
+    doorbell doorbell_;
+};
+
+// implements the admin channel, which multiplexes the short-lived admin requests of many clients
+// on a request/response ring in the connection queue segment, instead of a session segment per client
+class admin_channel_test_peer;
+
+class admin_channel
+{
+public:
+    constexpr static const char* name = "admin_channel";
+    constexpr static std::size_t no_entry = UINT64_MAX;
+
+    /**
+     * @brief the request copied from an entry into the memory of the server,
+     *  so that the client can no longer modify it while the server serves it
+     */
+    class request_image {
+    public:
+        std::uint64_t client_id_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::size_t service_id_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::string credential_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+        std::string payload_{};  // NOLINT(misc-non-private-member-variables-in-classes)
+    };
+
+    /**
+     * @brief an entry of the ring, which carries a request tagged by the client id and then its response
+     */
+    class entry {
+    public:
+        enum class state : std::uint32_t {
+            free = 0,
+            acquired,
+            requested,
+            serving,
+            responded,
+            abandoned,
+        };
+
+        entry() = default;
+        ~entry() = default;
+
+        /**
+         * @brief Copy and move constructers are deleted.
+         */
+        entry(entry const&) = delete;
+        entry(entry&&) = delete;
+        entry& operator = (entry const&) = delete;
+        entry& operator = (entry&&) = delete;
+
+        [[nodiscard]] std::uint64_t client_id() const noexcept { return client_id_.load(); }
+        [[nodiscard]] std::string_view response() const noexcept {
+            return {buffer_.get(), response_length_};
+        }
+        [[nodiscard]] bool is_error() const noexcept { return error_; }
+        [[nodiscard]] state get_state() const noexcept { return static_cast<state>(state_.load()); }
+
+    private:
+        std::atomic_uint32_t state_{};
+        std::atomic_uint32_t waiters_{};
+        std::atomic_uint64_t client_id_{};  // 0 while the owner is not known
+        // written by the client, thus the server loads each of them only once and validates them
+        std::atomic_size_t service_id_{};
+        std::atomic_size_t credential_length_{};
+        std::atomic_size_t payload_length_{};
+        std::size_t response_length_{};
+        bool error_{};
+        boost::interprocess::offset_ptr<char> buffer_{};
+
+        bool transit(state from, state to) noexcept {
+            auto expected = static_cast<std::uint32_t>(from);
+            if (state_.compare_exchange_strong(expected, static_cast<std::uint32_t>(to))) {
+                if (waiters_.load() > 0) {
+                    futex_wake_all(&state_);
+                }
+                return true;
+            }
+            return false;
+        }
+        // the client id is cleared before the entry becomes free, so that reclaim() never sees the id of the previous owner
+        bool give_back(state from) noexcept {
+            client_id_.store(0);
+            return transit(from, state::free);
+        }
+        bool wait_state(state current, std::int64_t timeout_us) {
+            waiters_.fetch_add(1);
+            bool rv = true;
+            if (get_state() == current) {
+                rv = futex_wait(&state_, static_cast<std::uint32_t>(current), timeout_us);
+            }
+            waiters_.fetch_sub(1);
+            return rv;
+        }
+
+        friend class admin_channel;
+        friend class admin_channel_test_peer;
+    };
+
+    /**
+     * @brief Construct a new object.
+     * @param entries the number of the entries in the ring
+     * @param buffer_size the size of the buffer of each entry, which holds a request and then its response
+     */
+    admin_channel(std::size_t entries, std::size_t buffer_size, boost::interprocess::managed_shared_memory::segment_manager* mgr)
+        : entries_(entries, mgr), buffer_size_(buffer_size), queue_(entries, mgr) {
+        for (auto&& e : entries_) {
+            e.buffer_ = static_cast<char*>(mgr->allocate_aligned(buffer_size_, Alignment));
+        }
+    }
+    ~admin_channel() = default;
+
+    /**
+     * @brief Copy and move constructers are deleted.
+     */
+    admin_channel(admin_channel const&) = delete;
+    admin_channel(admin_channel&&) = delete;
+    admin_channel& operator = (admin_channel const&) = delete;
+    admin_channel& operator = (admin_channel&&) = delete;
+
+    /**
+     * @brief returns the size of the shared memory used by the admin channel
+     */
+    static std::size_t memory_size(std::size_t entries, std::size_t buffer_size) noexcept {
+        return entries * (buffer_size + sizeof(entry) + sizeof(std::size_t) + (2 * Alignment)) + sizeof(admin_channel) + named_object_overhead;
+    }
+
+    /**
+     * @brief acquire an entry to send a request.
+     *  used by client
+     * @param client_id the id of the client, which must be the process id of the client
+     *  so that the server can reclaim the entry left by the client exited
+     * @return the index of the entry acquired
+     * @throws std::runtime_error if no entry is available
+     */
+    [[nodiscard]] std::size_t acquire(std::uint64_t client_id) {
+        for (std::size_t idx = 0; idx < entries_.size(); idx++) {
+            auto& e = entries_.at(idx);
+            if (e.transit(entry::state::free, entry::state::acquired)) {
+                e.client_id_.store(client_id);
+                e.error_ = false;
+                e.response_length_ = 0;
+                return idx;
+            }
+        }
+        throw std::runtime_error("no admin channel entry is available");
+    }
+    /**
+     * @brief send a request through the entry acquired.
+     *  used by client
+     * @param idx the index of the entry
+     * @param service_id the id of the service to handle the request
+     * @param credential the credential serialized, which is empty when the authentication is off
+     * @param payload the payload of the request
+     * @throws std::runtime_error if the request exceeds the buffer of the entry
+     */
+    void request(std::size_t idx, std::size_t service_id, std::string_view credential, std::string_view payload) {
+        auto& e = entries_.at(idx);
+        if ((credential.length() + payload.length()) > buffer_size_) {
+            throw std::runtime_error("the request is too large for the admin channel");
+        }
+        e.service_id_.store(service_id);
+        e.credential_length_.store(credential.length());
+        e.payload_length_.store(payload.length());
+        std::memcpy(e.buffer_.get(), credential.data(), credential.length());
+        std::memcpy(e.buffer_.get() + credential.length(), payload.data(), payload.length());  // NOLINT
+        e.transit(entry::state::acquired, entry::state::requested);
+        queue_.ring(idx);
+    }
+    /**
+     * @brief wait for the response of the request sent through the entry.
+     *  used by client
+     * @param idx the index of the entry
+     * @param timeout the timeout in microseconds, 0 means no timeout
+     * @return the entry, whose response() and is_error() are valid until release() is called
+     * @throws std::runtime_error if timeout occurs, and the entry is given back to the server in that case
+     */
+    [[nodiscard]] entry const& receive(std::size_t idx, std::int64_t timeout = 0) {
+        auto& e = entries_.at(idx);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeout);
+        while (true) {
+            auto current = e.get_state();
+            if (current == entry::state::responded) {
+                return e;
+            }
+            std::int64_t remaining = MAX_TIMEOUT;
+            if (timeout > 0) {
+                remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) {
+                    abandon(idx);
+                    throw std::runtime_error("admin channel response has not been received within the specified time");
+                }
+            }
+            e.wait_state(current, remaining);
+        }
+    }
+    /**
+     * @brief give back the entry whose response has been received.
+     *  used by client
+     * @param idx the index of the entry
+     */
+    void release(std::size_t idx) {
+        entries_.at(idx).give_back(entry::state::responded);
+    }
+
+    /**
+     * @brief wait for a request, and take it for serving.
+     *  used by server
+     * @param timeout the timeout in microseconds
+     * @return the index of the entry taken, or no_entry if timeout occurs or interrupted
+     */
+    [[nodiscard]] std::size_t take(std::int64_t timeout) {
+        while (true) {
+            auto idx = queue_.wait(timeout);
+            if (idx == no_entry) {
+                return no_entry;
+            }
+            auto& e = entries_.at(idx);
+            if (e.transit(entry::state::requested, entry::state::serving)) {
+                return idx;
+            }
+            if (e.get_state() == entry::state::abandoned) {
+                e.give_back(entry::state::abandoned);
+            }
+        }
+    }
+    /**
+     * @brief returns the entry taken.
+     *  used by server
+     */
+    [[nodiscard]] entry const& at(std::size_t idx) const {
+        return entries_.at(idx);
+    }
+    /**
+     * @brief copy the request of the entry taken into the image, which is owned by the server.
+     *  used by server
+     * @details the lengths written by the client are loaded once and checked against the buffer of the entry,
+     *  as the client can write anything into the shared memory, even while the server is serving the request.
+     * @param idx the index of the entry
+     * @param image the request image to be filled
+     * @return false if the lengths exceed the buffer of the entry, and the image is left unchanged in that case
+     */
+    [[nodiscard]] bool copy_request(std::size_t idx, request_image& image) const {
+        auto const& e = entries_.at(idx);
+        auto credential_length = e.credential_length_.load();
+        auto payload_length = e.payload_length_.load();
+        if (credential_length > buffer_size_ || payload_length > buffer_size_ - credential_length) {
+            return false;
+        }
+        image.client_id_ = e.client_id_.load();
+        image.service_id_ = e.service_id_.load();
+        image.credential_.assign(e.buffer_.get(), credential_length);
+        image.payload_.assign(e.buffer_.get() + credential_length, payload_length);  // NOLINT
+        return true;
+    }
+    /**
+     * @brief return the response to the client.
+     *  used by server
+     * @param idx the index of the entry
+     * @param response the response body, or the diagnostics serialized if error is true
+     * @param error whether the request has failed or not
+     * @return false if the response exceeds the buffer of the entry, and the entry is still being served in that case
+     */
+    bool respond(std::size_t idx, std::string_view response, bool error) {
+        auto& e = entries_.at(idx);
+        if (response.length() > buffer_size_) {
+            return false;
+        }
+        std::memcpy(e.buffer_.get(), response.data(), response.length());
+        e.response_length_ = response.length();
+        e.error_ = error;
+        if (!e.transit(entry::state::serving, entry::state::responded)) {
+            e.give_back(entry::state::abandoned);
+        }
+        return true;
+    }
+    /**
+     * @brief give back the entries left by the clients exited.
+     *  used by server
+     * @param alive a predicate returning whether the client of the id given is alive or not
+     * @return the number of the entries given back
+     */
+    template <typename Predicate>
+    std::size_t reclaim(Predicate alive) {
+        std::size_t reclaimed{};
+        for (auto&& e : entries_) {
+            auto current = e.get_state();
+            if (current != entry::state::acquired && current != entry::state::responded) {
+                continue;
+            }
+            if (auto client_id = e.client_id_.load(); client_id != 0 && !alive(client_id)) {
+                if (e.give_back(current)) {
+                    reclaimed++;
+                }
+            }
+        }
+        return reclaimed;
+    }
+    /**
+     * @brief wake up all the threads waiting for a request, used in the server termination.
+     */
+    void interrupt() {
+        queue_.interrupt();
+    }
+
+    // for diagnostic
+    [[nodiscard]] std::size_t entries() const noexcept {
+        return entries_.size();
+    }
+    [[nodiscard]] std::size_t buffer_size() const noexcept {
+        return buffer_size_;
+    }
+    [[nodiscard]] std::size_t entries_in_use() const noexcept {
+        std::size_t n{};
+        for (auto&& e : entries_) {
+            if (e.get_state() != entry::state::free) {
+                n++;
+            }
+        }
+        return n;
+    }
+
+private:
+    static constexpr std::size_t Alignment = 64;
+    static constexpr std::size_t named_object_overhead = 1024;
+    using entry_allocator = boost::interprocess::allocator<entry, boost::interprocess::managed_shared_memory::segment_manager>;
+
+    boost::interprocess::vector<entry, entry_allocator> entries_;
+    std::size_t buffer_size_;
+    connection_queue::doorbell queue_;  // the ring of the entries requested
+
+    void abandon(std::size_t idx) {
+        auto& e = entries_.at(idx);
+        while (true) {
+            auto current = e.get_state();
+            if (current == entry::state::responded) {
+                e.give_back(entry::state::responded);
+                return;
+            }
+            if (e.transit(current, entry::state::abandoned)) {  // the server gives back the entry
+                return;
+            }
+        }
+    }
 };
 
 };  // namespace tateyama::common